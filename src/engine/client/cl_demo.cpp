@@ -80,6 +80,29 @@ void CL_WriteDemoMessage(void)
 	fflush(cls.demofile);
 }
 
+/*
+====================
+CL_DemoContinues
+
+Server demos split a tick that doesn't fit in one message, and the rest of
+it starts with svc_nop instead of svc_time.  It belongs with the message
+already read, so it shouldn't wait for the next time
+====================
+*/
+static bool CL_DemoContinues(void)
+{
+	byte	header[4 + 3 * 4 + 1];		// length, angles, first command
+	long	start;
+	bool	continues;
+
+	start = ftell(cls.demofile);
+	continues = fread(header, sizeof(header), 1, cls.demofile) == 1
+		&& header[sizeof(header) - 1] == svc_nop;
+	fseek(cls.demofile, start, SEEK_SET);
+
+	return continues;
+}
+
 /*
 ====================
 CL_GetMessage
@@ -91,13 +114,19 @@ int CL_GetMessage(void)
 {
 	int		r, i;
 	float	f;
+	bool	continues;
 
 	if (cls.demoplayback)
 	{
+		continues = false;
+
 		// decide if it is time to grab the next message		
 		if (cls.signon == SIGNONS)	// allways grab until fully connected
 		{
-			if (cls.timedemo)
+			// the rest of a split tick goes with the part already read
+			continues = CL_DemoContinues();
+
+			if (cls.timedemo && !continues)
 			{
 				if (host_framecount == cls.td_lastframe)
 					return 0;		// allready read this frame's message
@@ -107,7 +136,7 @@ int CL_GetMessage(void)
 				if (host_framecount == cls.td_startframe + 1)
 					cls.td_starttime = realtime;
 			}
-			else if ( /* cl.time > 0 && */ cl.time <= cl.mtime[0])
+			else if (!continues && /* cl.time > 0 && */ cl.time <= cl.mtime[0])
 			{
 				return 0;		// don't need another message yet
 			}
@@ -115,7 +144,8 @@ int CL_GetMessage(void)
 
 		// get the next message
 		fread(&net_message.cursize, 4, 1, cls.demofile);
-		VectorCopy(cl.mviewangles[0], cl.mviewangles[1]);
+		if (!continues)
+			VectorCopy(cl.mviewangles[0], cl.mviewangles[1]);
 		for (i = 0; i < 3; i++)
 		{
 			r = fread(&f, 4, 1, cls.demofile);
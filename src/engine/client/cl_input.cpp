@@ -379,6 +379,12 @@ void CL_SendMove(usercmd_t* cmd)
 	MSG_WriteByte(&buf, cmd->lightlevel);
 #endif
 
+	//
+	// acknowledge the last entity frame
+	//
+	if (cl.protocol == PROTOCOL_DELTA)
+		MSG_WriteLong(&buf, cl.frame_sequence);
+
 	//
 	// deliver the message
 	//
@@ -181,6 +181,10 @@ void CL_SignonReply(void)
 	switch (cls.signon)
 	{
 	case 1:
+		// ask for delta compressed entities, older servers ignore this
+		MSG_WriteByte(&cls.message, clc_stringcmd);
+		MSG_WriteString(&cls.message, va("protocol %i\n", PROTOCOL_DELTA));
+
 		MSG_WriteByte(&cls.message, clc_stringcmd);
 		MSG_WriteString(&cls.message, "prespawn");
 		break;
@@ -64,7 +64,8 @@ const char* svc_strings[] =
 	"svc_finale",			// [string] music [string] text
 	"svc_cdtrack",			// [byte] track [byte] looptrack
 	"svc_sellscreen",
-	"svc_cutscene"
+	"svc_cutscene",
+	"svc_packetentities"	// [long] sequence [long] delta sequence <see code>
 };
 
 //=============================================================================
@@ -120,13 +121,13 @@ void CL_ParseStartSoundPacket(void)
 	else
 		attenuation = DEFAULT_SOUND_PACKET_ATTENUATION;
 
-	channel = MSG_ReadShort();
+	channel = MSG_ReadShort() & 0xffff;	// entity numbers use all 13 bits
 	sound_num = MSG_ReadByte();
 
 	ent = channel >> 3;
 	channel &= 7;
 
-	if (ent > MAX_EDICTS)
+	if (ent >= MAX_EDICTS)
 		Host_Error("CL_ParseStartSoundPacket: ent = %i", ent);
 
 	for (i = 0; i < 3; i++)
@@ -196,6 +197,52 @@ void CL_KeepaliveMessage(void)
 	SZ_Clear(&cls.message);
 }
 
+// the last PROTOCOL_DELTA frames received, the server deltas against them
+static packet_frame_t	cl_frames[UPDATE_BACKUP];
+
+/*
+==================
+CL_ClearFrames
+==================
+*/
+static void CL_ClearFrames(void)
+{
+	int		i;
+
+	for (i = 0; i < UPDATE_BACKUP; i++)
+	{
+		cl_frames[i].sequence = 0;
+		cl_frames[i].entities.clear();
+	}
+}
+
+/*
+==================
+CL_DecodePrefetched
+
+Runs on a job worker for each precached file as soon as it has been read
+==================
+*/
+static void CL_DecodePrefetched(const char* path, const byte* data, int length)
+{
+	if (!Q_strncmp(path, "sound/", 6))
+		g_SoundSystem->DecodePrefetched(path + 6, data, length);
+	else
+		Mod_DecodeModel(path, data, length);
+}
+
+/*
+==================
+CL_ReleasePrefetch
+==================
+*/
+static void CL_ReleasePrefetch(void)
+{
+	g_SoundSystem->ReleaseDecoded();	// points into the prefetched data
+	Mod_ReleaseDecoded();
+	COM_ReleasePrefetch();
+}
+
 /*
 ==================
 CL_ParseServerInfo
@@ -217,11 +264,13 @@ void CL_ParseServerInfo(void)
 
 	// parse protocol version number
 	i = MSG_ReadLong();
-	if (i != PROTOCOL_VERSION)
+	if (i != PROTOCOL_VERSION && i != PROTOCOL_DELTA)
 	{
 		Con_Printf("Server returned version %i, not %i", i, PROTOCOL_VERSION);
 		return;
 	}
+	cl.protocol = i;
+	CL_ClearFrames();
 
 	// parse maxclients
 	cl.maxclients = MSG_ReadByte();
@@ -280,6 +329,20 @@ void CL_ParseServerInfo(void)
 		strcpy(sound_precache[numsounds], str);
 	}
 
+	//
+	// read and decode all of it on the job workers first, so the loaders
+	// below only register what is already in memory
+	//
+	std::vector<std::string> prefetch;
+
+	for (i = 1; i < nummodels; i++)
+		if (model_precache[i][0] != '*')
+			prefetch.push_back(model_precache[i]);
+	for (i = 1; i < numsounds; i++)
+		prefetch.push_back(std::string("sound/") + sound_precache[i]);
+
+	COM_PrefetchFiles(prefetch, CL_DecodePrefetched);
+
 	//
 	// now we try to load everything else until a cache allocation fails
 	//
@@ -290,6 +353,7 @@ void CL_ParseServerInfo(void)
 		if (cl.model_precache[i] == NULL)
 		{
 			Con_Printf("Model %s not found\n", model_precache[i]);
+			CL_ReleasePrefetch();
 			return;
 		}
 		CL_KeepaliveMessage();
@@ -301,6 +365,8 @@ void CL_ParseServerInfo(void)
 		CL_KeepaliveMessage();
 	}
 
+	CL_ReleasePrefetch();
+
 
 	// local state
 	cl_entities[0].model = cl.worldmodel = cl.model_precache[1];
@@ -315,61 +381,27 @@ void CL_ParseServerInfo(void)
 
 /*
 ==================
-CL_ParseUpdate
+CL_UpdateEntity
 
-Parse an entity update message from the server
+Moves an entity to the state it has in the newest message
 If an entities model or origin changes from frame to frame, it must be
 relinked.  Other attributes can change without relinking.
 ==================
 */
-int	bitcounts[16];
-
-void CL_ParseUpdate(int bits)
+static void CL_UpdateEntity(int num, const entity_state_t* state, bool nolerp)
 {
 	int			i;
 	model_t* model;
-	int			modnum;
 	entity_t* ent;
-	int			num;
-
-	if (cls.signon == SIGNONS - 1)
-	{	// first update is the final signon stage
-		cls.signon = SIGNONS;
-		CL_SignonReply();
-	}
-
-	if (bits & U_MOREBITS)
-	{
-		i = MSG_ReadByte();
-		bits |= (i << 8);
-	}
-
-	if (bits & U_LONGENTITY)
-		num = MSG_ReadShort();
-	else
-		num = MSG_ReadByte();
 
 	ent = CL_EntityNum(num);
 
-	for (i = 0; i < 16; i++)
-		if (bits & (1 << i))
-			bitcounts[i]++;
-
 	// no previous frame to lerp from if true
 	bool forcelink = ent->msgtime != cl.mtime[1];
 
 	ent->msgtime = cl.mtime[0];
 
-	if (bits & U_MODEL)
-	{
-		modnum = MSG_ReadByte();
-		if (modnum >= MAX_MODELS)
-			Host_Error("CL_ParseModel: bad modnum");
-	}
-	else
-		modnum = ent->baseline.modelindex;
-
-	model = cl.model_precache[modnum];
+	model = cl.model_precache[state->modelindex];
 	if (model != ent->model)
 	{
 		ent->model = model;
@@ -390,15 +422,9 @@ void CL_ParseUpdate(int bits)
 #endif
 	}
 
-	if (bits & U_FRAME)
-		ent->frame = MSG_ReadByte();
-	else
-		ent->frame = ent->baseline.frame;
+	ent->frame = state->frame;
 
-	if (bits & U_COLORMAP)
-		i = MSG_ReadByte();
-	else
-		i = ent->baseline.colormap;
+	i = state->colormap;
 	if (!i)
 		ent->colormap = vid.colormap;
 	else
@@ -409,63 +435,27 @@ void CL_ParseUpdate(int bits)
 	}
 
 #ifdef GLQUAKE
-	int			skin;
-
-	if (bits & U_SKIN)
-		skin = MSG_ReadByte();
-	else
-		skin = ent->baseline.skin;
-	if (skin != ent->skinnum) {
-		ent->skinnum = skin;
+	if (state->skin != ent->skinnum) {
+		ent->skinnum = state->skin;
 		if (num > 0 && num <= cl.maxclients)
 			R_TranslatePlayerSkin(num - 1);
 	}
 
 #else
 
-	if (bits & U_SKIN)
-		ent->skinnum = MSG_ReadByte();
-	else
-		ent->skinnum = ent->baseline.skin;
+	ent->skinnum = state->skin;
 #endif
 
-	if (bits & U_EFFECTS)
-		ent->effects = MSG_ReadByte();
-	else
-		ent->effects = ent->baseline.effects;
+	ent->effects = state->effects;
 
 	// shift the known values for interpolation
 	VectorCopy(ent->msg_origins[0], ent->msg_origins[1]);
 	VectorCopy(ent->msg_angles[0], ent->msg_angles[1]);
 
-	if (bits & U_ORIGIN1)
-		ent->msg_origins[0][0] = MSG_ReadCoord();
-	else
-		ent->msg_origins[0][0] = ent->baseline.origin[0];
-	if (bits & U_ANGLE1)
-		ent->msg_angles[0][0] = MSG_ReadAngle();
-	else
-		ent->msg_angles[0][0] = ent->baseline.angles[0];
+	VectorCopy(state->origin, ent->msg_origins[0]);
+	VectorCopy(state->angles, ent->msg_angles[0]);
 
-	if (bits & U_ORIGIN2)
-		ent->msg_origins[0][1] = MSG_ReadCoord();
-	else
-		ent->msg_origins[0][1] = ent->baseline.origin[1];
-	if (bits & U_ANGLE2)
-		ent->msg_angles[0][1] = MSG_ReadAngle();
-	else
-		ent->msg_angles[0][1] = ent->baseline.angles[1];
-
-	if (bits & U_ORIGIN3)
-		ent->msg_origins[0][2] = MSG_ReadCoord();
-	else
-		ent->msg_origins[0][2] = ent->baseline.origin[2];
-	if (bits & U_ANGLE3)
-		ent->msg_angles[0][2] = MSG_ReadAngle();
-	else
-		ent->msg_angles[0][2] = ent->baseline.angles[2];
-
-	if (bits & U_NOLERP)
+	if (nolerp)
 		ent->forcelink = true;
 
 	if (forcelink)
@@ -478,6 +468,182 @@ void CL_ParseUpdate(int bits)
 	}
 }
 
+/*
+==================
+CL_ReadEntityFields
+
+Reads the fields flagged in bits over the values already in state
+==================
+*/
+static void CL_ReadEntityFields(int bits, entity_state_t* state)
+{
+	if (bits & U_MODEL)
+	{
+		state->modelindex = MSG_ReadByte();
+		if (state->modelindex >= MAX_MODELS)
+			Host_Error("CL_ParseModel: bad modnum");
+	}
+
+	if (bits & U_FRAME)
+		state->frame = MSG_ReadByte();
+	if (bits & U_COLORMAP)
+		state->colormap = MSG_ReadByte();
+	if (bits & U_SKIN)
+		state->skin = MSG_ReadByte();
+	if (bits & U_EFFECTS)
+		state->effects = MSG_ReadByte();
+
+	if (bits & U_ORIGIN1)
+		state->origin[0] = MSG_ReadCoord();
+	if (bits & U_ANGLE1)
+		state->angles[0] = MSG_ReadAngle();
+	if (bits & U_ORIGIN2)
+		state->origin[1] = MSG_ReadCoord();
+	if (bits & U_ANGLE2)
+		state->angles[1] = MSG_ReadAngle();
+	if (bits & U_ORIGIN3)
+		state->origin[2] = MSG_ReadCoord();
+	if (bits & U_ANGLE3)
+		state->angles[2] = MSG_ReadAngle();
+}
+
+/*
+==================
+CL_ParseUpdate
+
+Parse an entity update message from the server
+Fields that aren't sent come from the entity's baseline
+==================
+*/
+int	bitcounts[16];
+
+void CL_ParseUpdate(int bits)
+{
+	int			i;
+	int			num;
+	entity_state_t	state;
+
+	if (cls.signon == SIGNONS - 1)
+	{	// first update is the final signon stage
+		cls.signon = SIGNONS;
+		CL_SignonReply();
+	}
+
+	if (bits & U_MOREBITS)
+	{
+		i = MSG_ReadByte();
+		bits |= (i << 8);
+	}
+
+	if (bits & U_LONGENTITY)
+		num = MSG_ReadShort();
+	else
+		num = MSG_ReadByte();
+
+	for (i = 0; i < 16; i++)
+		if (bits & (1 << i))
+			bitcounts[i]++;
+
+	state = CL_EntityNum(num)->baseline;
+	CL_ReadEntityFields(bits, &state);
+
+	CL_UpdateEntity(num, &state, (bits & U_NOLERP) != 0);
+}
+
+/*
+==================
+CL_ParsePacketEntities
+
+Parse a PROTOCOL_DELTA entity frame.  Entities that aren't mentioned keep
+their state from the delta frame, the others are deltaed from it or from
+their baseline.
+==================
+*/
+void CL_ParsePacketEntities(void)
+{
+	int			sequence, delta;
+	int			num, bits;
+	int			oldindex, oldcount;
+	bool		valid;
+	packet_frame_t* from;
+	packet_frame_t* to;
+	packet_entity_t	pe;
+	static packet_frame_t	dummy;
+
+	if (cls.signon == SIGNONS - 1)
+	{	// first update is the final signon stage
+		cls.signon = SIGNONS;
+		CL_SignonReply();
+	}
+
+	sequence = MSG_ReadLong();
+	delta = MSG_ReadLong();
+
+	valid = sequence > cl.frame_sequence && (delta == 0 || (delta < sequence && sequence - delta < UPDATE_BACKUP));
+	from = NULL;
+	if (delta)
+	{
+		from = &cl_frames[delta & UPDATE_MASK];
+		if (from->sequence != delta)
+			valid = false;	// lost it, still have to read the message
+	}
+
+	// an unusable frame is parsed into a scratch frame and thrown away
+	to = valid ? &cl_frames[sequence & UPDATE_MASK] : &dummy;
+	to->sequence = sequence;
+	to->entities.clear();
+
+	oldindex = 0;
+	oldcount = valid && from ? (int)from->entities.size() : 0;
+
+	while (1)
+	{
+		num = MSG_ReadShort();
+		if (msg_badread)
+			Host_Error("CL_ParsePacketEntities: end of message");
+
+		// unchanged entities ahead of this one carry over
+		while (oldindex < oldcount && (!num || from->entities[oldindex].number < num))
+			to->entities.push_back(from->entities[oldindex++]);
+
+		if (!num)
+			break;
+
+		if (num < 0 || num >= MAX_EDICTS)
+			Host_Error("CL_ParsePacketEntities: bad entity number %i", num);
+
+		bits = MSG_ReadShort() & 0xffff;
+
+		if (oldindex < oldcount && from->entities[oldindex].number == num)
+			pe = from->entities[oldindex++];
+		else
+		{
+			pe.number = num;
+			pe.nolerp = false;
+			pe.state = CL_EntityNum(num)->baseline;
+		}
+
+		if (bits & U_REMOVE)
+			continue;
+
+		CL_ReadEntityFields(bits, &pe.state);
+		pe.nolerp = (bits & U_NOLERP) != 0;
+		to->entities.push_back(pe);
+	}
+
+	if (!valid)
+	{
+		Con_DPrintf("CL_ParsePacketEntities: can't delta frame %i from %i\n", sequence, delta);
+		return;
+	}
+
+	// acknowledged with the next move
+	cl.frame_sequence = sequence;
+
+	for (const auto& entity : to->entities)
+		CL_UpdateEntity(entity.number, &entity.state, entity.nolerp);
+}
+
 /*
 ==================
 CL_ParseBaseline
@@ -777,8 +943,19 @@ void CL_ParseServerMessage(void)
 
 		case svc_version:
 			i = MSG_ReadLong();
-			if (i != PROTOCOL_VERSION)
+			if (i != PROTOCOL_VERSION && i != PROTOCOL_DELTA)
 				Host_Error("CL_ParseServerMessage: Server is protocol %i instead of %i\n", i, PROTOCOL_VERSION);
+			if (i != cl.protocol)
+			{
+				cl.protocol = i;
+				CL_ClearFrames();
+			}
+			break;
+
+		case svc_packetentities:
+			if (cl.protocol != PROTOCOL_DELTA)
+				Host_Error("CL_ParseServerMessage: svc_packetentities on protocol %i\n", cl.protocol);
+			CL_ParsePacketEntities();
 			break;
 
 		case svc_disconnect:
@@ -193,6 +193,9 @@ typedef struct
 	int			intermission;	// don't change view angle, full screen, etc
 	int			completed_time;	// latched at intermission start
 
+	int			protocol;		// PROTOCOL_VERSION or PROTOCOL_DELTA
+	int			frame_sequence;	// last svc_packetentities frame parsed, sent back in clc_move
+
 	double		mtime[2];		// the timestamp of last two messages	
 	double		time;			// clients view of time, should be between
 								// servertime and oldservertime to generate
@@ -19,6 +19,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // gl_mesh.c: triangle model functions
 
+#include <mutex>
+#include <unordered_map>
+
 #include "quakedef.h"
 
 /*
@@ -32,23 +35,24 @@ ALIAS MODEL DISPLAY LIST GENERATION
 model_t* aliasmodel;
 aliashdr_t* paliashdr;
 
-byte	used[8192];
+// the builder state is per thread, so GL_DecodeAliasMesh can run on the
+// job workers while a model loads on the main thread
+
+thread_local byte	used[8192];
 
 // the command list holds counts and s/t values that are valid for
 // every frame
-int		commands[8192];
-int		numcommands;
+thread_local int	commands[8192];
+thread_local int	numcommands;
 
 // all frames will have their vertexes rearranged and expanded
 // so they are in the order expected by the command list
-int		vertexorder[8192];
-int		numorder;
+thread_local int	vertexorder[8192];
+thread_local int	numorder;
 
-int		allverts, alltris;
-
-int		stripverts[128];
-int		striptris[128];
-int		stripcount;
+thread_local int	stripverts[128];
+thread_local int	striptris[128];
+thread_local int	stripcount;
 
 /*
 ================
@@ -269,70 +273,215 @@ void BuildTris(void)
 	}
 
 	commands[numcommands++] = 0;		// end of list marker
+}
 
-	Con_DPrintf("%3i tri %3i vert %3i cmd\n", pheader->numtris, numorder, numcommands);
 
-	allverts += numorder;
-	alltris += pheader->numtris;
+#define	MESH_CACHE_VERSION	1	// bump when BuildTris output or the entry layout changes
+
+/*
+================
+GL_LoadCachedMesh
+
+Takes the command list and vertex order back from a mesh cache entry
+================
+*/
+static bool GL_LoadCachedMesh(const byte* data, int length)
+{
+	const int* counts = reinterpret_cast<const int*>(data);
+
+	if (length < 2 * 4)
+		return false;
+
+	if (counts[0] < 0 || counts[0] > (int)(sizeof(commands) / sizeof(commands[0]))
+		|| counts[1] < 0 || counts[1] > (int)(sizeof(vertexorder) / sizeof(vertexorder[0]))
+		|| length != (2 + counts[0] + counts[1]) * 4)
+		return false;
+
+	numcommands = counts[0];
+	numorder = counts[1];
+	memcpy(commands, counts + 2, numcommands * 4);
+	memcpy(vertexorder, counts + 2 + numcommands, numorder * 4);
+	return true;
 }
 
+// meshes built or read from the mesh cache on the job workers, waiting for
+// GL_CacheAliasMesh to take them
+typedef struct
+{
+	std::vector<int>	entry;		// laid out like a mesh cache entry
+	bool				built;		// not in the mesh cache yet
+} decodedmesh_t;
+
+static std::mutex	decodedlock;
+static std::unordered_map<unsigned long long, decodedmesh_t>	decodedmeshes;
 
 /*
 ================
-GL_MakeAliasModelDisplayLists
+GL_AliasMeshKey
+
+Hashes everything BuildTris reads
 ================
 */
-void GL_MakeAliasModelDisplayLists(model_t* m, aliashdr_t* hdr)
+static unsigned long long GL_AliasMeshKey(void)
 {
-	int		i, j;
-	int* cmds;
-	trivertx_t* verts;
-	char	cache[MAX_QPATH], fullpath[MAX_OSPATH];
-	FILE* f;
+	unsigned long long	key;
 
-	aliasmodel = m;
-	paliashdr = hdr;	// (aliashdr_t *)Mod_Extradata (m);
+	key = DataCache_Key(&pheader->numverts, sizeof(pheader->numverts), DATACACHE_KEYSTART);
+	key = DataCache_Key(&pheader->numtris, sizeof(pheader->numtris), key);
+	key = DataCache_Key(&pheader->skinwidth, sizeof(pheader->skinwidth), key);
+	key = DataCache_Key(&pheader->skinheight, sizeof(pheader->skinheight), key);
+	key = DataCache_Key(stverts, pheader->numverts * sizeof(stverts[0]), key);
+	key = DataCache_Key(triangles, pheader->numtris * sizeof(triangles[0]), key);
 
-	//
-	// look for a cached version
-	//
-	strcpy(cache, "glquake/");
-	COM_StripExtension(m->name + strlen("progs/"), cache + strlen("glquake/"));
-	strcat(cache, ".ms2");
+	return key;
+}
 
-	COM_FOpenFile(cache, &f);
-	if (f)
+/*
+================
+GL_MeshEntry
+
+The command list and vertex order laid out as a mesh cache entry
+================
+*/
+static std::vector<int> GL_MeshEntry(void)
+{
+	std::vector<int>	entry;
+
+	entry.push_back(numcommands);
+	entry.push_back(numorder);
+	entry.insert(entry.end(), commands, commands + numcommands);
+	entry.insert(entry.end(), vertexorder, vertexorder + numorder);
+	return entry;
+}
+
+/*
+================
+GL_DecodeAliasMesh
+
+Called on a job worker with pheader, stverts and triangles filled in for this
+thread.  Builds the mesh, or reads it from the mesh cache, and leaves it for
+GL_CacheAliasMesh to pick up on the main thread
+================
+*/
+void GL_DecodeAliasMesh(void)
+{
+	unsigned long long	key;
+	decodedmesh_t		mesh;
+
+	key = GL_AliasMeshKey();
+
+	{
+		std::lock_guard<std::mutex> lock(decodedlock);
+		if (decodedmeshes.count(key))
+			return;
+	}
+
+	mesh.built = false;
+	if (!DataCache_Load("mesh", MESH_CACHE_VERSION, key, [&](const byte* data, int length)
+		{
+			if (!GL_LoadCachedMesh(data, length))
+				return false;
+			mesh.entry = GL_MeshEntry();
+			return true;
+		}))
 	{
-		fread(&numcommands, 4, 1, f);
-		fread(&numorder, 4, 1, f);
-		fread(&commands, numcommands * sizeof(commands[0]), 1, f);
-		fread(&vertexorder, numorder * sizeof(vertexorder[0]), 1, f);
-		fclose(f);
+		BuildTris();
+		mesh.entry = GL_MeshEntry();
+		mesh.built = true;
 	}
-	else
+
+	std::lock_guard<std::mutex> lock(decodedlock);
+	decodedmeshes.emplace(key, std::move(mesh));
+}
+
+/*
+================
+GL_ReleaseDecodedMeshes
+
+Drops the meshes GL_DecodeAliasMesh made for models that were never loaded
+================
+*/
+void GL_ReleaseDecodedMeshes(void)
+{
+	std::lock_guard<std::mutex> lock(decodedlock);
+	decodedmeshes.clear();
+}
+
+/*
+================
+GL_CacheAliasMesh
+
+Fills the command list and vertex order for pheader, stverts and triangles
+from the mesh cache, building and caching them if there's no entry
+================
+*/
+void GL_CacheAliasMesh(const char* name)
+{
+	unsigned long long	key;
+	decodedmesh_t		mesh;
+	bool				decoded;
+
+	key = GL_AliasMeshKey();
+
+	//
+	// see if a job worker already got it ready
+	//
+	decoded = false;
 	{
-		//
-		// build it from scratch
-		//
-		Con_Printf("meshing %s...\n", m->name);
-
-		BuildTris();		// trifans or lists
-
-		//
-		// save out the cached version
-		//
-		sprintf(fullpath, "%s/%s", com_gamedir, cache);
-		f = fopen(fullpath, "wb");
-		if (f)
+		std::lock_guard<std::mutex> lock(decodedlock);
+		auto it = decodedmeshes.find(key);
+		if (it != decodedmeshes.end())
 		{
-			fwrite(&numcommands, 4, 1, f);
-			fwrite(&numorder, 4, 1, f);
-			fwrite(&commands, numcommands * sizeof(commands[0]), 1, f);
-			fwrite(&vertexorder, numorder * sizeof(vertexorder[0]), 1, f);
-			fclose(f);
+			mesh = std::move(it->second);
+			decodedmeshes.erase(it);
+			decoded = true;
 		}
 	}
 
+	if (decoded && GL_LoadCachedMesh(reinterpret_cast<const byte*>(mesh.entry.data()), (int)mesh.entry.size() * 4))
+	{
+		if (mesh.built)
+			DataCache_Store("mesh", MESH_CACHE_VERSION, key, mesh.entry.data(), (int)mesh.entry.size() * 4);
+		return;
+	}
+
+	//
+	// look for a cached version
+	//
+	if (DataCache_Load("mesh", MESH_CACHE_VERSION, key, GL_LoadCachedMesh))
+		return;
+
+	//
+	// build it from scratch
+	//
+	Con_Printf("meshing %s...\n", name);
+
+	BuildTris();		// trifans or lists
+
+	Con_DPrintf("%3i tri %3i vert %3i cmd\n", pheader->numtris, numorder, numcommands);
+
+	//
+	// save out the cached version
+	//
+	mesh.entry = GL_MeshEntry();
+	DataCache_Store("mesh", MESH_CACHE_VERSION, key, mesh.entry.data(), (int)mesh.entry.size() * 4);
+}
+
+/*
+================
+GL_MakeAliasModelDisplayLists
+================
+*/
+void GL_MakeAliasModelDisplayLists(model_t* m, aliashdr_t* hdr)
+{
+	int		i, j;
+	int* cmds;
+	trivertx_t* verts;
+
+	aliasmodel = m;
+	paliashdr = hdr;	// (aliashdr_t *)Mod_Extradata (m);
+
+	GL_CacheAliasMesh(m->name);
 
 	// save the data out
 
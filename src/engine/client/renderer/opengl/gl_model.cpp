@@ -111,7 +111,7 @@ Mod_DecompressVis
 */
 byte* Mod_DecompressVis(byte* in, model_t* model)
 {
-	static byte	decompressed[MAX_MAP_LEAFS / 8];
+	static thread_local byte	decompressed[MAX_MAP_LEAFS / 8];	// per thread for the server send jobs
 	int		c;
 	byte* out;
 	int		row;
@@ -173,6 +173,8 @@ void Mod_ClearAll(void)
 	for (i = 0, mod = mod_known; i < mod_numknown; i++, mod++)
 		if (mod->type != mod_alias)
 			mod->needload = true;
+
+	ModCache_Release();
 }
 
 /*
@@ -239,6 +241,9 @@ model_t* Mod_LoadModel(model_t* mod, bool crash)
 	void* d;
 	unsigned* buf;
 	byte	stackbuf[1024];		// avoid dirtying the cache heap
+	const byte* view;
+	int		viewlength;
+	bool	cachechecked;
 
 	if (!mod->needload)
 	{
@@ -260,6 +265,24 @@ model_t* Mod_LoadModel(model_t* mod, bool crash)
 
 	}
 
+	//
+	// a brush model in a pak can be checked against the model cache straight
+	// from the mapping, without copying it in first
+	//
+	view = COM_MapFile(mod->name, &viewlength);
+	cachechecked = false;
+	if (view && viewlength >= 4
+		&& LittleLong(*(const unsigned*)view) != IDPOLYHEADER
+		&& LittleLong(*(const unsigned*)view) != IDSPRITEHEADER)
+	{
+		if (ModCache_Restore(mod, view, viewlength))
+		{
+			mod->needload = false;
+			return mod;
+		}
+		cachechecked = true;
+	}
+
 	//
 	// load the file
 	//
@@ -296,7 +319,11 @@ model_t* Mod_LoadModel(model_t* mod, bool crash)
 		break;
 
 	default:
+		if (!cachechecked && ModCache_Restore(mod, (byte*)buf, com_filesize))
+			break;
+		ModCache_BeginLoad();
 		Mod_LoadBrushModel(mod, buf);
+		ModCache_EndLoad(mod);
 		break;
 	}
 
@@ -1231,10 +1258,11 @@ ALIAS MODELS
 ==============================================================================
 */
 
-aliashdr_t* pheader;
+// per thread, Mod_DecodeModel fills them on the job workers
+thread_local aliashdr_t* pheader;
 
-stvert_t	stverts[MAXALIASVERTS];
-mtriangle_t	triangles[MAXALIASTRIS];
+thread_local stvert_t		stverts[MAXALIASVERTS];
+thread_local mtriangle_t	triangles[MAXALIASTRIS];
 
 // a pose is a single set of vertexes.  a frame may be
 // an animating sequence of poses
@@ -1645,6 +1673,176 @@ void Mod_LoadAliasModel(model_t* mod, void* buffer)
 	Hunk_FreeToLowMark(start);
 }
 
+/*
+=================
+Mod_ParseAliasMesh
+
+Fills header, stverts and triangles with just what the mesh is built from.
+Safe on a job worker.  Returns false if buf isn't an alias model that could
+be loaded
+=================
+*/
+static bool Mod_ParseAliasMesh(const byte* buf, int length, aliashdr_t* header)
+{
+	int					i, j, numskins, groupskins, skinsize;
+	const byte* p;
+	const mdl_t* pinmodel;
+	const stvert_t* pinstverts;
+	const dtriangle_t* pintriangles;
+
+	pinmodel = reinterpret_cast<const mdl_t*>(buf);
+
+	if (!buf || length < (int)sizeof(mdl_t)
+		|| LittleLong(pinmodel->ident) != IDPOLYHEADER
+		|| LittleLong(pinmodel->version) != ALIAS_VERSION)
+		return false;
+
+	memset(header, 0, sizeof(*header));
+	header->skinwidth = LittleLong(pinmodel->skinwidth);
+	header->skinheight = LittleLong(pinmodel->skinheight);
+	header->numverts = LittleLong(pinmodel->numverts);
+	header->numtris = LittleLong(pinmodel->numtris);
+	numskins = LittleLong(pinmodel->numskins);
+
+	if (header->skinwidth <= 0 || header->skinheight <= 0 || header->skinheight > MAX_LBM_HEIGHT
+		|| header->numverts <= 0 || header->numverts > MAXALIASVERTS
+		|| header->numtris <= 0 || header->numtris > MAXALIASTRIS
+		|| numskins < 1 || numskins > MAX_SKINS)
+		return false;
+
+	//
+	// skip the skins, the same way Mod_LoadAllSkins walks them
+	//
+	skinsize = header->skinwidth * header->skinheight;
+	p = buf + sizeof(mdl_t);
+
+	for (i = 0; i < numskins; i++)
+	{
+		if (p + sizeof(daliasskintype_t) > buf + length)
+			return false;
+
+		if (LittleLong(reinterpret_cast<const daliasskintype_t*>(p)->type) == ALIAS_SKIN_SINGLE)
+		{
+			p += sizeof(daliasskintype_t) + skinsize;
+			continue;
+		}
+
+		p += sizeof(daliasskintype_t);
+		if (p + sizeof(daliasskingroup_t) > buf + length)
+			return false;
+
+		groupskins = LittleLong(reinterpret_cast<const daliasskingroup_t*>(p)->numskins);
+		if (groupskins < 1 || groupskins > (buf + length - p) / skinsize)
+			return false;
+
+		p += sizeof(daliasskingroup_t) + groupskins * (sizeof(daliasskininterval_t) + skinsize);
+	}
+
+	pinstverts = reinterpret_cast<const stvert_t*>(p);
+	pintriangles = reinterpret_cast<const dtriangle_t*>(pinstverts + header->numverts);
+
+	if (p > buf + length
+		|| reinterpret_cast<const byte*>(pintriangles + header->numtris) > buf + length)
+		return false;
+
+	//
+	// endian-adjust the parts the mesh is built from, as Mod_LoadAliasModel does
+	//
+	for (i = 0; i < header->numverts; i++)
+	{
+		stverts[i].onseam = LittleLong(pinstverts[i].onseam);
+		stverts[i].s = LittleLong(pinstverts[i].s);
+		stverts[i].t = LittleLong(pinstverts[i].t);
+	}
+
+	for (i = 0; i < header->numtris; i++)
+	{
+		triangles[i].facesfront = LittleLong(pintriangles[i].facesfront);
+
+		for (j = 0; j < 3; j++)
+		{
+			triangles[i].vertindex[j] = LittleLong(pintriangles[i].vertindex[j]);
+			if (triangles[i].vertindex[j] < 0 || triangles[i].vertindex[j] >= header->numverts)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+=================
+Mod_PrewarmAliasMesh
+
+Puts an alias model's mesh in the mesh cache straight from the file, without
+loading the model.  Only the header, s and t vertices and triangles are read.
+Returns false if the file isn't an alias model that could be loaded
+=================
+*/
+bool Mod_PrewarmAliasMesh(const char* name)
+{
+	int					mark, length;
+	const byte* buf;
+	aliashdr_t			header;
+	aliashdr_t* saveheader;
+	bool				valid;
+
+	mark = Hunk_LowMark();
+
+	buf = COM_MapFile(name, &length);
+	if (!buf)
+	{
+		buf = COM_LoadHunkFile(name);
+		length = com_filesize;
+	}
+
+	valid = Mod_ParseAliasMesh(buf, length, &header);
+	if (valid)
+	{
+		saveheader = pheader;
+		pheader = &header;
+		GL_CacheAliasMesh(name);
+		pheader = saveheader;
+	}
+
+	Hunk_FreeToLowMark(mark);
+	return valid;
+}
+
+/*
+=================
+Mod_DecodeModel
+
+Called on a job worker for each file COM_PrefetchFiles reads.  Alias models
+get their mesh built, or read from the mesh cache, so Mod_LoadAliasModel only
+has to copy it to the hunk.  Anything else is left to load as it is
+=================
+*/
+void Mod_DecodeModel(const char* path, const byte* data, int length)
+{
+	aliashdr_t	header;
+
+	if (!Mod_ParseAliasMesh(data, length, &header))
+		return;
+
+	pheader = &header;
+	GL_DecodeAliasMesh();
+	pheader = nullptr;
+}
+
+/*
+=================
+Mod_ReleaseDecoded
+
+Called with COM_ReleasePrefetch, drops what Mod_DecodeModel made for models
+that didn't get loaded
+=================
+*/
+void Mod_ReleaseDecoded(void)
+{
+	GL_ReleaseDecodedMeshes();
+}
+
 //=============================================================================
 
 /*
@@ -312,9 +312,9 @@ typedef struct {
 #define	MAXALIASVERTS	1024
 #define	MAXALIASFRAMES	256
 #define	MAXALIASTRIS	2048
-extern	aliashdr_t* pheader;
-extern	stvert_t	stverts[MAXALIASVERTS];
-extern	mtriangle_t	triangles[MAXALIASTRIS];
+extern	thread_local aliashdr_t* pheader;
+extern	thread_local stvert_t		stverts[MAXALIASVERTS];
+extern	thread_local mtriangle_t	triangles[MAXALIASTRIS];
 extern	trivertx_t* poseverts[MAXALIASFRAMES];
 
 //===================================================================
@@ -418,6 +418,9 @@ void	Mod_ClearAll(void);
 model_t* Mod_ForName(const char* name, bool crash);
 void* Mod_Extradata(model_t* mod);	// handles caching
 void	Mod_TouchModel(const char* name);
+bool	Mod_PrewarmAliasMesh(const char* name);
+void	Mod_DecodeModel(const char* path, const byte* data, int length);
+void	Mod_ReleaseDecoded(void);
 
 mleaf_t* Mod_PointInLeaf(float* p, model_t* model);
 byte* Mod_LeafPVS(mleaf_t* leaf, model_t* model);
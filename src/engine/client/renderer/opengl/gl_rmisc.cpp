@@ -169,7 +169,6 @@ R_Init
 */
 void R_Init(void)
 {
-	extern byte* hunk_base;
 	extern cvar_t gl_finish;
 
 	Cmd_AddCommand("timerefresh", R_TimeRefresh_f);
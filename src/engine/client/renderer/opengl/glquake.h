@@ -203,6 +203,9 @@ void GL_Bind(int texnum);
 void GL_SubdivideSurface(msurface_t* fa);
 
 void GL_MakeAliasModelDisplayLists(model_t* m, aliashdr_t* hdr);
+void GL_CacheAliasMesh(const char* name);
+void GL_DecodeAliasMesh(void);
+void GL_ReleaseDecodedMeshes(void);
 
 int R_LightPoint(vec3_t p);
 
@@ -114,7 +114,7 @@ Mod_DecompressVis
 */
 byte *Mod_DecompressVis (byte *in, model_t *model)
 {
-	static byte	decompressed[MAX_MAP_LEAFS/8];
+	static thread_local byte	decompressed[MAX_MAP_LEAFS/8];	// per thread for the server send jobs
 	int		c;
 	byte	*out;
 	int		row;
@@ -175,6 +175,8 @@ void Mod_ClearAll (void)
 //FIX FOR CACHE_ALLOC ERRORS:
 		if (mod->type == mod_sprite) mod->cache.data = NULL;
 	}
+
+	ModCache_Release ();
 }
 
 /*
@@ -246,6 +248,28 @@ void Mod_TouchModel (const char *name)
 	}
 }
 
+/*
+==================
+Mod_DecodeModel
+
+Nothing here can be got ready off the main thread, the alias models are used
+as they are in the file
+==================
+*/
+void Mod_DecodeModel (const char *path, const byte *data, int length)
+{
+}
+
+/*
+==================
+Mod_ReleaseDecoded
+
+==================
+*/
+void Mod_ReleaseDecoded (void)
+{
+}
+
 /*
 ==================
 Mod_LoadModel
@@ -257,6 +281,9 @@ model_t *Mod_LoadModel (model_t *mod, bool crash)
 {
 	unsigned *buf;
 	byte	stackbuf[1024];		// avoid dirtying the cache heap
+	const byte	*view;
+	int		viewlength;
+	bool	cachechecked;
 
 	if (mod->type == mod_alias)
 	{
@@ -276,6 +303,24 @@ model_t *Mod_LoadModel (model_t *mod, bool crash)
 // because the world is so huge, load it one piece at a time
 //
 	
+//
+// a brush model in a pak can be checked against the model cache straight
+// from the mapping, without copying it in first
+//
+	view = COM_MapFile (mod->name, &viewlength);
+	cachechecked = false;
+	if (view && viewlength >= 4
+		&& LittleLong(*(const unsigned *)view) != IDPOLYHEADER
+		&& LittleLong(*(const unsigned *)view) != IDSPRITEHEADER)
+	{
+		if (ModCache_Restore (mod, view, viewlength))
+		{
+			mod->needload = NL_PRESENT;
+			return mod;
+		}
+		cachechecked = true;
+	}
+
 //
 // load the file
 //
@@ -312,7 +357,11 @@ model_t *Mod_LoadModel (model_t *mod, bool crash)
 		break;
 	
 	default:
+		if (!cachechecked && ModCache_Restore (mod, (byte *)buf, com_filesize))
+			break;
+		ModCache_BeginLoad ();
 		Mod_LoadBrushModel (mod, buf);
+		ModCache_EndLoad (mod);
 		break;
 	}
 
@@ -370,6 +370,8 @@ void	Mod_ClearAll (void);
 model_t *Mod_ForName (const char *name, bool crash);
 void	*Mod_Extradata (model_t *mod);	// handles caching
 void	Mod_TouchModel (const char *name);
+void	Mod_DecodeModel (const char *path, const byte *data, int length);
+void	Mod_ReleaseDecoded (void);
 
 mleaf_t *Mod_PointInLeaf (float *p, model_t *model);
 byte	*Mod_LeafPVS (mleaf_t *leaf, model_t *model);
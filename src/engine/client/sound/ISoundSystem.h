@@ -67,6 +67,18 @@ struct ISoundSystem
 	*/
 	virtual SoundIndex PrecacheSound(const char* name) = 0;
 
+	/**
+	*	@brief Parses a sound read by COM_PrefetchFiles, called on a job worker.
+	*	PrecacheSound uses the result instead of parsing the file again.
+	*	@param name Name relative to the sound directory
+	*/
+	virtual void DecodePrefetched(const char* name, const byte* data, int length) = 0;
+
+	/**
+	*	@brief Drops what DecodePrefetched made, before COM_ReleasePrefetch frees the data it points into
+	*/
+	virtual void ReleaseDecoded() = 0;
+
 	/**
 	*	@brief Start a sound effect
 	*/
@@ -20,7 +20,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
+#include <algorithm>
 #include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include <AL/alext.h>
 
@@ -44,6 +48,80 @@ void CheckALErrors()
 	} while (error != AL_NO_ERROR);
 }
 
+/**
+*	@brief A sample parsed from its file and ready to hand to OpenAL.
+*/
+struct DecodedSound
+{
+	const char* error = nullptr;	// why it can't be loaded, nullptr if it can
+	ALenum format = 0;
+	int rate = 0;
+	int width = 0;
+	int loopstart = -1;				// in samples
+	int length = 0;					// in bytes
+	const byte* samples = nullptr;	// in the file data, or in swapped
+	std::vector<short> swapped;		// byte swapped copy on big endian machines
+};
+
+// sounds DecodePrefetched parsed on the job workers, waiting for LoadSound
+static std::mutex s_DecodedLock;
+static std::unordered_map<std::string, DecodedSound> s_DecodedSounds;
+
+/**
+*	@brief Parses a WAV file that stays in memory as long as the result is used.
+*	Doesn't print anything, so it can run on a job worker.
+*/
+static DecodedSound DecodeSound(const byte* data, int length)
+{
+	DecodedSound decoded;
+
+	const wavinfo_t info = GetWavinfo(data, length);
+
+	if (info.error)
+	{
+		decoded.error = info.error;
+		return decoded;
+	}
+
+	if (info.channels != 1)
+	{
+		decoded.error = "Stereo samples aren't supported";
+		return decoded;
+	}
+
+	switch (info.width)
+	{
+	case 1: decoded.format = AL_FORMAT_MONO8; break;
+	case 2: decoded.format = AL_FORMAT_MONO16; break;
+
+	default:
+		decoded.error = "Invalid sample width";
+		return decoded;
+	}
+
+	// don't read past the end of a file with a bad data chunk length
+	const int samples = std::min(info.samples, (length - info.dataofs) / info.width);
+
+	decoded.rate = info.rate;
+	decoded.width = info.width;
+	decoded.loopstart = info.loopstart;
+	decoded.length = samples * info.width;
+	decoded.samples = data + info.dataofs;
+
+	if (info.width == 2 && bigendien)
+	{
+		// the view may be read only, swap into a copy
+		decoded.swapped.resize(samples);
+		for (int i = 0; i < samples; i++)
+		{
+			decoded.swapped[i] = LittleShort(((const short*)decoded.samples)[i]);
+		}
+		decoded.samples = reinterpret_cast<const byte*>(decoded.swapped.data());
+	}
+
+	return decoded;
+}
+
 std::optional<SoundSystem> SoundSystem::Create()
 {
 	if (SoundSystem audio; audio.CreateCore())
@@ -420,6 +498,21 @@ bool SoundSystem::LoadSound(SoundEffect* s)
 	if (s->buffer)
 		return true;
 
+	DecodedSound decoded;
+	bool found = false;
+
+	// parsed on a job worker while the precache list was read
+	{
+		std::lock_guard<std::mutex> lock(s_DecodedLock);
+
+		if (auto it = s_DecodedSounds.find(s->name); it != s_DecodedSounds.end())
+		{
+			decoded = std::move(it->second);
+			s_DecodedSounds.erase(it);
+			found = true;
+		}
+	}
+
 	//Con_Printf ("S_LoadSound: %x\n", (int)stackbuf);
 	// load it in
 	char namebuffer[256];
@@ -428,49 +521,28 @@ bool SoundSystem::LoadSound(SoundEffect* s)
 
 	//	Con_Printf ("loading %s\n",namebuffer);
 
+	// samples in a pak are handed to OpenAL straight from the mapping
 	byte stackbuf[1 * 1024]; // avoid dirtying the cache heap
-	auto data = COM_LoadStackFile(namebuffer, stackbuf, sizeof(stackbuf));
 
-	if (!data)
+	if (!found)
 	{
-		Con_Printf("Couldn't load %s\n", namebuffer);
-		return false;
-	}
+		const byte* data = COM_MapFile(namebuffer, nullptr);
 
-	const wavinfo_t info = GetWavinfo(s->name, data, com_filesize);
+		if (!data)
+			data = COM_LoadStackFile(namebuffer, stackbuf, sizeof(stackbuf));
 
-	if (info.channels != 1)
-	{
-		Con_Printf("%s is a stereo sample\n", s->name);
-		return false;
-	}
-
-	const ALenum format = [&]()
-	{
-		switch (info.channels)
+		if (!data)
 		{
-		case 1:
-			switch (info.width)
-			{
-			case 1: return AL_FORMAT_MONO8;
-			case 2: return AL_FORMAT_MONO16;
-			}
-			break;
-		case 2:
-			switch (info.width)
-			{
-			case 1: return AL_FORMAT_STEREO8;
-			case 2: return AL_FORMAT_STEREO16;
-			}
-			break;
+			Con_Printf("Couldn't load %s\n", namebuffer);
+			return false;
 		}
 
-		Con_Printf("%s has invalid format (channels: %d, sample bits: %d)\n", s->name, info.channels, info.width * 8);
-		return 0;
-	}();
+		decoded = DecodeSound(data, com_filesize);
+	}
 
-	if (format == 0)
+	if (decoded.error)
 	{
+		Con_Printf("%s: %s\n", s->name, decoded.error);
 		return false;
 	}
 
@@ -479,29 +551,39 @@ bool SoundSystem::LoadSound(SoundEffect* s)
 	if (!s->buffer)
 		return false;
 
-	byte* samples = data + info.dataofs;
+	s->IsLooping = decoded.loopstart >= 0;
 
-	if (info.width == 2)
-	{
-		for (int i = 0; i < info.samples; i++)
-		{
-			((short*)samples)[i] = LittleShort(((short*)samples)[i]);
-		}
-	}
-
-	s->IsLooping = info.loopstart >= 0;
-
-	// TODO: this code has not been tested with stereo sounds, these calculations may not be correct.
-	alBufferData(s->buffer.Id, format, samples, info.samples * info.width * info.channels, info.rate);
+	alBufferData(s->buffer.Id, decoded.format, decoded.samples, decoded.length, decoded.rate);
 
-	const int loopstart = info.loopstart >= 0 ? info.loopstart : 0;
+	const int loopstart = decoded.loopstart >= 0 ? decoded.loopstart : 0;
 
-	const ALint loopPoints[2] = {loopstart * info.width * info.channels, info.samples * info.width * info.channels};
+	const ALint loopPoints[2] = {loopstart * decoded.width, decoded.length};
 	alBufferiv(s->buffer.Id, AL_LOOP_POINTS_SOFT, loopPoints);
 
 	return true;
 }
 
+void SoundSystem::DecodePrefetched(const char* name, const byte* data, int length)
+{
+	{
+		std::lock_guard<std::mutex> lock(s_DecodedLock);
+
+		if (s_DecodedSounds.count(name))
+			return;
+	}
+
+	auto decoded = DecodeSound(data, length);
+
+	std::lock_guard<std::mutex> lock(s_DecodedLock);
+	s_DecodedSounds.emplace(name, std::move(decoded));
+}
+
+void SoundSystem::ReleaseDecoded()
+{
+	std::lock_guard<std::mutex> lock(s_DecodedLock);
+	s_DecodedSounds.clear();
+}
+
 SoundSystem::Channel* SoundSystem::PickChannel(int entnum, int entchannel)
 {
 	// Check for replacement sound, or find the best one to replace
@@ -194,6 +194,9 @@ public:
 
 	SoundIndex PrecacheSound(const char* name) override;
 
+	void DecodePrefetched(const char* name, const byte* data, int length) override;
+	void ReleaseDecoded() override;
+
 	void StartSound(int entnum, int entchannel, SoundIndex index, vec3_t origin, float fvol, float attenuation) override;
 	void StaticSound(SoundIndex index, vec3_t origin, float vol, float attenuation) override;
 	void LocalSound(const char* sound, float vol = 1.f) override;
@@ -26,7 +26,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 class WaveSoundLoader
 {
 public:
-	WaveSoundLoader(byte* wav, int wavlength)
+	WaveSoundLoader(const byte* wav, int wavlength)
 		: iff_data(wav)
 		, iff_end(wav + wavlength)
 	{
@@ -39,11 +39,11 @@ public:
 	bool FindChunk(const char* name);
 	void DumpChunks();
 
-	byte* iff_data;
-	byte* iff_end;
+	const byte* iff_data;
+	const byte* iff_end;
 
-	byte* data_p = nullptr;
-	byte* last_chunk = nullptr;
+	const byte* data_p = nullptr;
+	const byte* last_chunk = nullptr;
 };
 
 short WaveSoundLoader::GetLittleShort()
@@ -89,7 +89,7 @@ bool WaveSoundLoader::FindNextChunk(const char* name)
 		//			Sys_Error ("FindNextChunk: %i length is past the 1 meg sanity limit", iff_chunk_len);
 		data_p -= 8;
 		last_chunk = data_p + 8 + ((iff_chunk_len + 1) & ~1);
-		if (!Q_strncmp(reinterpret_cast<char*>(data_p), name, 4))
+		if (!Q_strncmp(reinterpret_cast<const char*>(data_p), name, 4))
 			break;
 	}
 
@@ -118,7 +118,7 @@ void WaveSoundLoader::DumpChunks()
 	} while (data_p < iff_end);
 }
 
-wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
+wavinfo_t GetWavinfo(const byte* wav, int wavlength)
 {
 	wavinfo_t info;
 	memset(&info, 0, sizeof(info));
@@ -129,9 +129,9 @@ wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
 	WaveSoundLoader loader{wav, wavlength};
 
 	// find "RIFF" chunk
-	if (!(loader.FindChunk("RIFF") && !Q_strncmp(reinterpret_cast<char*>(loader.data_p + 8), "WAVE", 4)))
+	if (!(loader.FindChunk("RIFF") && !Q_strncmp(reinterpret_cast<const char*>(loader.data_p + 8), "WAVE", 4)))
 	{
-		Con_Printf("Missing RIFF/WAVE chunks\n");
+		info.error = "Missing RIFF/WAVE chunks";
 		return info;
 	}
 
@@ -141,14 +141,14 @@ wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
 
 	if (!loader.FindChunk("fmt "))
 	{
-		Con_Printf("Missing fmt chunk\n");
+		info.error = "Missing fmt chunk";
 		return info;
 	}
 	loader.data_p += 8;
 	const int format = loader.GetLittleShort();
 	if (format != 1)
 	{
-		Con_Printf("Microsoft PCM format only\n");
+		info.error = "Microsoft PCM format only";
 		return info;
 	}
 
@@ -167,7 +167,7 @@ wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
 			// if the next chunk is a LIST chunk, look for a cue length marker
 		if (loader.FindNextChunk("LIST"))
 		{
-			if (!strncmp(reinterpret_cast<char*>(loader.data_p + 28), "mark", 4))
+			if (!strncmp(reinterpret_cast<const char*>(loader.data_p + 28), "mark", 4))
 			{	// this is not a proper parse, but it works with cooledit...
 				loader.data_p += 24;
 				const int i = loader.GetLittleLong();	// samples in loop
@@ -182,7 +182,13 @@ wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
 	// find data chunk
 	if (!loader.FindChunk("data"))
 	{
-		Con_Printf("Missing data chunk\n");
+		info.error = "Missing data chunk";
+		return info;
+	}
+
+	if (info.width <= 0)
+	{
+		info.error = "Bad sample width";
 		return info;
 	}
 
@@ -192,7 +198,10 @@ wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength)
 	if (info.samples)
 	{
 		if (samples < info.samples)
-			Sys_Error("Sound %s has a bad loop length", name);
+		{
+			info.error = "Bad loop length";
+			return info;
+		}
 	}
 	else
 		info.samples = samples;
@@ -28,6 +28,8 @@ struct wavinfo_t
 	int loopstart;
 	int samples;
 	int dataofs;		// chunk starts this many bytes from file start
+	const char* error;	// why it couldn't be parsed, nullptr if it could
 };
 
-wavinfo_t GetWavinfo(const char* name, byte* wav, int wavlength);
+// Doesn't print anything, so it can run on a job worker
+wavinfo_t GetWavinfo(const byte* wav, int wavlength);
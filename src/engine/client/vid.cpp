@@ -182,15 +182,6 @@ bool VID_AllocBuffers(int width, int height)
 
 	tbuffersize += tsize;
 
-	// see if there's enough memory, allowing for the normal mode 0x13 pixel,
-	// z, and surface buffers
-	if ((host_parms.memsize - tbuffersize + SURFCACHE_SIZE_AT_320X200 +
-		0x10000 * 3) < minimum_memory)
-	{
-		Con_SafePrintf("Not enough memory for video mode\n");
-		return false;		// not enough memory for mode
-	}
-
 	vid_surfcachesize = tsize;
 
 	if (d_pzbuffer)
@@ -203,6 +194,11 @@ bool VID_AllocBuffers(int width, int height)
 	VID_highhunkmark = Hunk_HighMark();
 
 	d_pzbuffer = reinterpret_cast<short*>(Hunk_HighAllocName(tbuffersize, "video"));
+	if (!d_pzbuffer)
+	{
+		Con_SafePrintf("Not enough memory for video mode\n");
+		return false;		// not enough memory for mode
+	}
 
 	vid_surfcache = (byte*)d_pzbuffer +
 		width * height * sizeof(*d_pzbuffer);
@@ -1734,10 +1730,6 @@ void	VID_Init(unsigned char* palette)
 
 	GL_Init();
 
-	char	gldir[MAX_OSPATH];
-	sprintf(gldir, "%s/glquake", com_gamedir);
-	Sys_mkdir(gldir);
-
 	vid_realmode = vid_modenum;
 
 	vid_menudrawfn = VID_MenuDraw;
@@ -19,6 +19,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // common.c -- misc functions used in client and server
 
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+
 #include "quakedef.h"
 
 #define NUM_SAFE_ARGVS  7
@@ -1172,10 +1177,18 @@ FIXME: make this buffer size safe someday
 char* va(const char* format, ...)
 {
 	va_list         argptr;
-	static char             string[1024];
+	char*           string;
+	int             length;
+
+	// results live in scratch memory, so several can be used at once
+	va_start(argptr, format);
+	length = vsnprintf(NULL, 0, format, argptr);
+	va_end(argptr);
+
+	string = reinterpret_cast<char*>(Scratch_Alloc(length + 1));
 
 	va_start(argptr, format);
-	vsprintf(string, format, argptr);
+	vsnprintf(string, length + 1, format, argptr);
 	va_end(argptr);
 
 	return string;
@@ -1220,6 +1233,7 @@ typedef struct pack_s
 	FILE*           handle;
 	int             numfiles;
 	packfile_t* files;
+	const byte*     mapped;         // the whole pak, nullptr if it couldn't be mapped
 } pack_t;
 
 //
@@ -1252,6 +1266,50 @@ typedef struct searchpath_s
 
 searchpath_t* com_searchpaths;
 
+// the pak entry each name resolves to, over every pak in the search path
+typedef struct
+{
+	searchpath_t*   search;
+	packfile_t*     file;
+} packindex_t;
+
+static std::unordered_map<std::string, packindex_t>    com_packindex;
+
+/*
+============
+COM_IndexPack
+
+Called as a pak is put at the head of the search path, so its files
+override whatever the index held for the same names
+============
+*/
+static void COM_IndexPack(searchpath_t* search)
+{
+	pack_t* pak = search->pack;
+
+	com_packindex.reserve(com_packindex.size() + pak->numfiles);
+
+	// backwards, so the first of any duplicate names wins like a linear search
+	for (int i = pak->numfiles - 1; i >= 0; i--)
+		com_packindex[pak->files[i].name] = {search, &pak->files[i]};
+}
+
+/*
+============
+COM_FindInPack
+
+Linear search of a single pak, only for when the index can't be used
+============
+*/
+static packfile_t* COM_FindInPack(pack_t* pak, const char* filename)
+{
+	for (int i = 0; i < pak->numfiles; i++)
+		if (!strcmp(pak->files[i].name, filename))
+			return &pak->files[i];
+
+	return nullptr;
+}
+
 /*
 ============
 COM_Path_f
@@ -1267,13 +1325,53 @@ void COM_Path_f(void)
 	{
 		if (s->pack)
 		{
-			Con_Printf("%s (%i files)\n", s->pack->filename, s->pack->numfiles);
+			Con_Printf("%s (%i files%s)\n", s->pack->filename, s->pack->numfiles, s->pack->mapped ? ", mapped" : "");
 		}
 		else
 			Con_Printf("%s\n", s->filename);
 	}
 }
 
+/*
+============
+COM_ListFiles
+
+Every file in the search path with the given extension, in paks or loose in
+any subdirectory, each name once
+============
+*/
+std::vector<std::string> COM_ListFiles(const char* extension)
+{
+	std::set<std::string> files;
+	searchpath_t* s;
+
+	for (s = com_searchpaths; s; s = s->next)
+	{
+		if (s->pack)
+		{
+			for (int i = 0; i < s->pack->numfiles; i++)
+				if (!Q_strcasecmp(COM_FileExtension(s->pack->files[i].name), extension))
+					files.insert(s->pack->files[i].name);
+			continue;
+		}
+
+		std::error_code ec;
+		std::filesystem::recursive_directory_iterator it(s->filename, ec), end;
+
+		for (; !ec && it != end; it.increment(ec))
+		{
+			if (!it->is_regular_file(ec))
+				continue;
+
+			auto name = it->path().lexically_relative(s->filename).generic_string();
+			if (!Q_strcasecmp(COM_FileExtension(name.c_str()), extension))
+				files.insert(name);
+		}
+	}
+
+	return std::vector<std::string>(files.begin(), files.end());
+}
+
 /*
 ============
 COM_WriteFile
@@ -1358,48 +1456,60 @@ void COM_CopyFile(const char* netpath, char* cachepath)
 
 /*
 ===========
-COM_FindFile
+COM_LocateFile
 
 Finds the file in the search path.
-Sets com_filesize and file
+Returns the pak entry holding it, or nullptr with netpath filled in when it
+is a loose file.  Sets com_filesize, which is -1 if the file doesn't exist.
 ===========
 */
-int COM_FindFile(const char* filename, FILE** file)
+static packfile_t* COM_LocateFile(const char* filename, pack_t** pack, char* netpath, bool quiet = false)
 {
 	searchpath_t* search;
-	char            netpath[MAX_OSPATH];
 	char            cachepath[MAX_OSPATH];
-	pack_t* pak;
 	time_t                     findtime, cachetime;
+	packindex_t* found;
+	bool            skipped;
 
 	//
 	// search through the path, one element at a time
 	//
 	search = com_searchpaths;
+	skipped = false;
 	if (proghack)
 	{	// gross hack to use quake 1 progs with quake 2 maps
 		if (!strcmp(filename, "progs.dat"))
+		{
 			search = search->next;
+			skipped = true;
+		}
 	}
 
+	// the highest pak in the path that has the file, directories in front of
+	// it still have to be checked
+	auto it = com_packindex.find(filename);
+	found = it != com_packindex.end() ? &it->second : nullptr;
+
 	for (; search; search = search->next)
 	{
 		// is the element a pak file?
 		if (search->pack)
 		{
-			// look through all the pak file elements
-			pak = search->pack;
-			for (int i = 0; i < pak->numfiles; i++)
-				if (!strcmp(pak->files[i].name, filename))
-				{       // found it!
-					Sys_Printf("PackFile: %s : %s\n", pak->filename, filename);
-					// open a new file on the pakfile
-					*file = fopen(pak->filename, "rb");
-					if (*file)
-						fseek(*file, pak->files[i].filepos, SEEK_SET);
-					com_filesize = pak->files[i].filelen;
-					return com_filesize;
-				}
+			packfile_t* file;
+
+			if (skipped && found && found->search == com_searchpaths)
+				file = COM_FindInPack(search->pack, filename);
+			else if (found && found->search == search)
+				file = found->file;
+			else
+				continue;
+
+			if (!file)
+				continue;
+
+			*pack = search->pack;
+			com_filesize = file->filelen;
+			return file;
 		}
 		else
 		{
@@ -1417,9 +1527,7 @@ int COM_FindFile(const char* filename, FILE** file)
 				continue;
 
 			// see if the file needs to be updated in the cache
-			if (!com_cachedir[0])
-				strcpy(cachepath, netpath);
-			else
+			if (com_cachedir[0])
 			{
 #if defined(_WIN32)
 				if ((strlen(netpath) < 2) || (netpath[1] != ':'))
@@ -1437,20 +1545,209 @@ int COM_FindFile(const char* filename, FILE** file)
 				strcpy(netpath, cachepath);
 			}
 
-			Sys_Printf("FindFile: %s\n", netpath);
-			FILE* i;
-			com_filesize = Sys_FileOpenRead(netpath, &i);
-			*file = i;
-			return com_filesize;
+			*pack = nullptr;
+			com_filesize = 0;
+			return nullptr;
 		}
 
 	}
 
-	Sys_Printf("FindFile: can't find %s\n", filename);
+	if (!quiet)
+		Sys_Printf("FindFile: can't find %s\n", filename);
 
-	*file = NULL;
+	*pack = nullptr;
+	netpath[0] = 0;
 	com_filesize = -1;
-	return -1;
+	return nullptr;
+}
+
+/*
+===========
+COM_OpenLocatedFile
+
+Opens what COM_LocateFile found
+===========
+*/
+static int COM_OpenLocatedFile(pack_t* pak, packfile_t* packfile, const char* netpath, FILE** file)
+{
+	if (packfile)
+	{
+		// open a new file on the pakfile
+		*file = fopen(pak->filename, "rb");
+		if (*file)
+			fseek(*file, packfile->filepos, SEEK_SET);
+		return com_filesize;
+	}
+
+	if (!netpath[0])
+	{
+		*file = NULL;
+		return -1;
+	}
+
+	FILE* i;
+	com_filesize = Sys_FileOpenRead(netpath, &i);
+	*file = i;
+	return com_filesize;
+}
+
+/*
+===========
+COM_FindFile
+
+Finds the file in the search path.
+Sets com_filesize and file
+===========
+*/
+int COM_FindFile(const char* filename, FILE** file)
+{
+	char            netpath[MAX_OSPATH];
+	pack_t* pak;
+	packfile_t* packfile;
+
+	packfile = COM_LocateFile(filename, &pak, netpath);
+	return COM_OpenLocatedFile(pak, packfile, netpath, file);
+}
+
+/*
+===========
+COM_MapFile
+
+Returns a read only view of a file inside a mapped pak, with nothing read or
+copied.  The view lasts as long as the search path, so for the whole run.
+Returns nullptr if the file is loose on disk, in a pak that couldn't be
+mapped or doesn't exist, and the caller falls back to COM_Load*File.
+===========
+*/
+const byte* COM_MapFile(const char* path, int* length)
+{
+	char            netpath[MAX_OSPATH];
+	pack_t* pak;
+	packfile_t* packfile;
+
+	packfile = COM_LocateFile(path, &pak, netpath);
+	if (!packfile || !pak->mapped)
+		return nullptr;
+
+	if (length)
+		*length = packfile->filelen;
+	return pak->mapped + packfile->filepos;
+}
+
+// files read ahead by COM_PrefetchFiles that weren't in a mapped pak
+static std::unordered_map<std::string, std::vector<byte>>	com_prefetched;
+
+/*
+===========
+COM_PrefetchFiles
+
+Reads a list of files on the job workers, so the loaders that go through
+them one at a time afterwards don't wait on the disk.  Entries in mapped
+paks are faulted in where they are, anything else is read into memory and
+served by COM_LoadFile until COM_ReleasePrefetch.  Missing files are skipped.
+
+decode, if given, is run on the same worker as soon as each file is in
+memory, so the parsing that doesn't need the hunk or the renderer happens
+there too.  The data stays good until COM_ReleasePrefetch.
+===========
+*/
+void COM_PrefetchFiles(const std::vector<std::string>& paths, prefetchdecode_t decode)
+{
+	typedef struct
+	{
+		const char* path;
+		pack_t* pak;
+		packfile_t* file;
+		char            netpath[MAX_OSPATH];
+		std::vector<byte>* dest;        // nullptr for a mapped pak entry
+	} prefetch_t;
+
+	std::vector<prefetch_t> reads;
+	int                     oldfilesize;
+
+	COM_ReleasePrefetch();
+
+	// the search path and the loose file cache are only touched here
+	oldfilesize = com_filesize;
+	reads.reserve(paths.size());
+	for (const auto& path : paths)
+	{
+		prefetch_t      read;
+
+		read.path = path.c_str();
+		read.file = COM_LocateFile(path.c_str(), &read.pak, read.netpath, true);
+		if (!read.file && !read.netpath[0])
+			continue;
+
+		if (read.file && read.pak->mapped)
+			read.dest = nullptr;
+		else
+		{
+			auto inserted = com_prefetched.emplace(path, std::vector<byte>());
+			if (!inserted.second)
+				continue;
+			read.dest = &inserted.first->second;
+		}
+
+		reads.push_back(read);
+	}
+	com_filesize = oldfilesize;
+
+	Jobs_ParallelFor((int)reads.size(), [&](int i)
+		{
+			prefetch_t* read = &reads[i];
+			FILE* f;
+			long            length;
+
+			if (!read->dest)
+			{
+				const byte* view = read->pak->mapped + read->file->filepos;
+				volatile byte   touch = 0;
+
+				for (int ofs = 0; ofs < read->file->filelen; ofs += 4096)
+					touch += view[ofs];
+
+				if (decode)
+					decode(read->path, view, read->file->filelen);
+				return;
+			}
+
+			f = fopen(read->file ? read->pak->filename : read->netpath, "rb");
+			if (!f)
+				return;
+
+			if (read->file)
+			{
+				fseek(f, read->file->filepos, SEEK_SET);
+				length = read->file->filelen;
+			}
+			else
+			{
+				fseek(f, 0, SEEK_END);
+				length = ftell(f);
+				fseek(f, 0, SEEK_SET);
+			}
+
+			read->dest->resize(length);
+			if (fread(read->dest->data(), 1, length, f) != (size_t)length)
+				read->dest->clear();        // COM_LoadFile goes to disk itself
+			fclose(f);
+
+			if (decode && !read->dest->empty())
+				decode(read->path, read->dest->data(), (int)read->dest->size());
+		});
+}
+
+/*
+===========
+COM_ReleasePrefetch
+
+Frees what COM_PrefetchFiles read once the loaders are done with it
+===========
+*/
+void COM_ReleasePrefetch(void)
+{
+	com_prefetched.clear();
 }
 
 /*
@@ -1485,13 +1782,43 @@ byte* COM_LoadFile(const char* path, int usehunk)
 	byte* buf;
 	char    base[32];
 	int             len;
+	char            netpath[MAX_OSPATH];
+	pack_t* pak;
+	packfile_t* packfile;
+	const byte* view;
 
 	buf = NULL;     // quiet compiler warning
 
-// look for it in the filesystem or pack files
-	len = COM_FOpenFile(path, &f);
-	if (!f)
-		return NULL;
+// look for it in the filesystem or pack files, mapped paks and prefetched
+// files are copied from memory without opening anything
+	f = NULL;
+	view = NULL;
+
+	if (!com_prefetched.empty())
+	{
+		auto it = com_prefetched.find(path);
+		if (it != com_prefetched.end() && !it->second.empty())
+		{
+			view = it->second.data();
+			len = com_filesize = (int)it->second.size();
+		}
+	}
+
+	if (!view)
+	{
+		packfile = COM_LocateFile(path, &pak, netpath);
+		if (packfile && pak->mapped)
+		{
+			view = pak->mapped + packfile->filepos;
+			len = packfile->filelen;
+		}
+		else
+		{
+			len = COM_OpenLocatedFile(pak, packfile, netpath, &f);
+			if (!f)
+				return NULL;
+		}
+	}
 
 	// extract the filename base name for hunk tag
 	COM_FileBase(path, base);
@@ -1519,6 +1846,12 @@ byte* COM_LoadFile(const char* path, int usehunk)
 
 	((byte*)buf)[len] = 0;
 
+	if (view)
+	{
+		memcpy(buf, view, len);
+		return buf;
+	}
+
 	Draw_BeginDisc();
 	fread(buf, 1, len, f);
 	fclose(f);
@@ -1573,10 +1906,13 @@ pack_t* COM_LoadPackFile(const char* packfile)
 	int                             numpackfiles;
 	pack_t* pack;
 	FILE* packhandle;
-	dpackfile_t             info[MAX_FILES_IN_PACK];
+	dpackfile_t* info;
 	unsigned short          crc;
+	long                    packlength;
+	bool                    mappable;
 
-	if (Sys_FileOpenRead(packfile, &packhandle) == -1)
+	packlength = Sys_FileOpenRead(packfile, &packhandle);
+	if (packlength == -1)
 	{
 		//              Con_Printf ("Couldn't open %s\n", packfile);
 		return NULL;
@@ -1597,6 +1933,7 @@ pack_t* COM_LoadPackFile(const char* packfile)
 		com_modified = true;    // not the original file
 
 	newfiles = reinterpret_cast<packfile_t*>(Hunk_AllocName(numpackfiles * sizeof(packfile_t), "packfile"));
+	info = reinterpret_cast<dpackfile_t*>(Scratch_Alloc(header.dirlen));
 
 	fseek(packhandle, header.dirofs, SEEK_SET);
 	fread(info, 1, header.dirlen, packhandle);
@@ -1609,11 +1946,17 @@ pack_t* COM_LoadPackFile(const char* packfile)
 		com_modified = true;
 
 	// parse the directory
+	mappable = true;
 	for (i = 0; i < numpackfiles; i++)
 	{
 		strcpy(newfiles[i].name, info[i].name);
 		newfiles[i].filepos = LittleLong(info[i].filepos);
 		newfiles[i].filelen = LittleLong(info[i].filelen);
+
+		// a view past the end of the mapping would fault instead of reading short
+		if (newfiles[i].filepos < 0 || newfiles[i].filelen < 0
+			|| (long)newfiles[i].filepos + newfiles[i].filelen > packlength)
+			mappable = false;
 	}
 
 	pack = reinterpret_cast<pack_t*>(Hunk_Alloc(sizeof(pack_t)));
@@ -1621,6 +1964,7 @@ pack_t* COM_LoadPackFile(const char* packfile)
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
+	pack->mapped = mappable ? Sys_FileMap(packhandle, packlength) : nullptr;
 
 	Con_Printf("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
@@ -1665,6 +2009,7 @@ void COM_AddGameDirectory(const char* dir)
 		search->pack = pak;
 		search->next = com_searchpaths;
 		com_searchpaths = search;
+		COM_IndexPack(search);
 	}
 
 	//
@@ -1750,6 +2095,7 @@ void COM_InitFilesystem(void)
 	{
 		com_modified = true;
 		com_searchpaths = NULL;
+		com_packindex.clear();
 		while (++i < com_argc)
 		{
 			if (!com_argv[i] || com_argv[i][0] == '+' || com_argv[i][0] == '-')
@@ -1766,6 +2112,8 @@ void COM_InitFilesystem(void)
 				strcpy(search->filename, com_argv[i]);
 			search->next = com_searchpaths;
 			com_searchpaths = search;
+			if (search->pack)
+				COM_IndexPack(search);
 		}
 	}
 
@@ -165,9 +165,17 @@ struct cache_user_s;
 extern	char	com_gamedir[MAX_OSPATH];
 
 void COM_WriteFile(const char* filename, const void* data, int len);
+void COM_CreatePath(char* path);
+std::vector<std::string> COM_ListFiles(const char* extension);
 int COM_FOpenFile(const char* filename, FILE** file);
 
 byte* COM_LoadStackFile(const char* path, void* buffer, int bufsize);
+const byte* COM_MapFile(const char* path, int* length);
+// Runs on a job worker, so it must not touch the hunk, the console or any
+// loader globals
+typedef void (*prefetchdecode_t)(const char* path, const byte* data, int length);
+void COM_PrefetchFiles(const std::vector<std::string>& paths, prefetchdecode_t decode = nullptr);
+void COM_ReleasePrefetch(void);
 byte* COM_LoadTempFile(const char* path);
 byte* COM_LoadHunkFile(const char* path);
 void COM_LoadCacheFile(const char* path, struct cache_user_s* cu);
@@ -0,0 +1,213 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* datacache.c -- on disk cache of processed model data, keyed by content */
+
+#include <atomic>
+
+#include "quakedef.h"
+
+// Entries are files under <gamedir>/cache/<kind>/ named by their key.  The
+// payload is whatever relocatable layout the producer uses, and a version
+// mismatch or a file written on a machine with a different byte order is a
+// miss, which the producer overwrites with a fresh entry.
+
+#define	DATACACHE_IDENT		(('1' << 24) + ('C' << 16) + ('D' << 8) + 'Q')	// "QDC1", written in host byte order
+
+typedef struct
+{
+	int			ident;
+	int			version;
+	unsigned long long	key;
+	int			length;			// of the payload that follows
+} datacacheheader_t;
+
+static std::atomic<int>	datacache_hits;		// DataCache_Load also runs on the job workers
+static int		datacache_writes;
+
+/*
+================
+DataCache_Path
+================
+*/
+static void DataCache_Path(char* path, const char* kind, unsigned long long key)
+{
+	sprintf(path, "%s/cache/%s/%016llx", com_gamedir, kind, key);
+}
+
+/*
+================
+DataCache_Key
+
+64 bit FNV-1a
+================
+*/
+unsigned long long DataCache_Key(const void* data, int length, unsigned long long key)
+{
+	const byte* p = reinterpret_cast<const byte*>(data);
+
+	for (int i = 0; i < length; i++)
+	{
+		key ^= p[i];
+		key *= 1099511628211ULL;
+	}
+
+	return key;
+}
+
+/*
+================
+DataCache_Load
+================
+*/
+bool DataCache_Load(const char* kind, int version, unsigned long long key, const std::function<bool(const byte* data, int length)>& use)
+{
+	char		path[MAX_OSPATH];
+	FILE* f;
+	long		length;
+	const byte* mapped;
+	std::vector<byte>	copy;
+	const datacacheheader_t* header;
+	bool		used;
+
+	DataCache_Path(path, kind, key);
+
+	length = Sys_FileOpenRead(path, &f);
+	if (!f)
+		return false;
+
+	mapped = Sys_FileMap(f, length);
+	if (!mapped && length > 0)
+	{
+		// the mapping failed, read it instead
+		copy.resize(length);
+		if (fread(copy.data(), 1, length, f) != (size_t)length)
+			copy.clear();
+	}
+	fclose(f);
+
+	const byte* data = mapped ? mapped : (copy.empty() ? nullptr : copy.data());
+	header = reinterpret_cast<const datacacheheader_t*>(data);
+
+	used = false;
+	if (data && length >= (long)sizeof(*header)
+		&& header->ident == DATACACHE_IDENT
+		&& header->version == version
+		&& header->key == key
+		&& header->length == length - (long)sizeof(*header))
+		used = use(data + sizeof(*header), header->length);
+
+	Sys_FileUnmap(mapped, length);
+
+	if (used)
+		datacache_hits++;
+	return used;
+}
+
+/*
+================
+DataCache_Store
+
+Written to a temporary name and renamed, so a reader never sees half an
+entry.  Two processes storing the same entry write the same bytes, and a
+short file is a miss on load
+================
+*/
+void DataCache_Store(const char* kind, int version, unsigned long long key, const void* data, int length)
+{
+	char		path[MAX_OSPATH], temp[MAX_OSPATH];
+	datacacheheader_t	header;
+	FILE* f;
+	bool		written;
+
+	DataCache_Path(path, kind, key);
+	sprintf(temp, "%s.tmp", path);
+	COM_CreatePath(temp);
+
+	f = fopen(temp, "wb");
+	if (!f)
+	{
+		Con_DPrintf("DataCache_Store: couldn't write %s\n", temp);
+		return;
+	}
+
+	header.ident = DATACACHE_IDENT;
+	header.version = version;
+	header.key = key;
+	header.length = length;
+
+	written = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(data, 1, length, f) == (size_t)length;
+	if (fclose(f) || !written)
+	{
+		remove(temp);
+		return;
+	}
+
+	remove(path);
+	if (rename(temp, path))
+	{
+		remove(temp);
+		return;
+	}
+
+	datacache_writes++;
+}
+
+#ifdef GLQUAKE
+/*
+================
+DataCache_Prewarm_f
+
+Builds the mesh cache entry for every model in the game directory.  The
+models are read straight from their files, nothing is loaded or registered
+================
+*/
+static void DataCache_Prewarm_f(void)
+{
+	int		hits, writes, failed;
+
+	hits = datacache_hits;
+	writes = datacache_writes;
+	failed = 0;
+
+	auto models = COM_ListFiles("mdl");
+
+	for (const auto& name : models)
+	{
+		if (!Mod_PrewarmAliasMesh(name.c_str()))
+			failed++;
+	}
+
+	Con_Printf("%i models: %i cache entries written, %i already cached, %i failed\n",
+		(int)models.size(), datacache_writes - writes, datacache_hits - hits, failed);
+}
+#endif
+
+/*
+================
+DataCache_Init
+================
+*/
+void DataCache_Init(void)
+{
+#ifdef GLQUAKE
+	Cmd_AddCommand("cacheprewarm", DataCache_Prewarm_f);
+#endif
+}
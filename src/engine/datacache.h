@@ -0,0 +1,38 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* datacache.h -- on disk cache of processed model data, keyed by content */
+
+#include <functional>
+
+// Keys are a hash of everything the cached result was computed from, so an
+// edited source file simply misses instead of loading stale data
+#define	DATACACHE_KEYSTART	14695981039346656037ULL
+
+void DataCache_Init(void);
+
+// Folds length bytes of data into key, start from DATACACHE_KEYSTART
+unsigned long long DataCache_Key(const void* data, int length, unsigned long long key);
+
+// Finds the entry for kind / key written with the same version and hands its
+// payload to use, which returns false if it can't take it.  The payload is
+// mapped read only and goes away when use returns.
+bool DataCache_Load(const char* kind, int version, unsigned long long key, const std::function<bool(const byte* data, int length)>& use);
+
+void DataCache_Store(const char* kind, int version, unsigned long long key, const void* data, int length);
@@ -216,7 +216,7 @@ void HuntTarget(edict_t* self)
 	self->v.goalentity = self->v.enemy;
 	self->v.think = self->v.th_run;
 	self->v.ideal_yaw = PF_vectoyaw(AsVector(self->v.enemy->v.origin) - AsVector(self->v.origin));
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 	SUB_AttackFinished(self, 1);	// wait a while before first attack
 }
 
@@ -76,7 +76,7 @@ void animation_set(edict_t* self, const char* name, int frame)
 	}
 
 	//Set before calling animation think so it can override.
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &animation_advance;
 
 	const auto animation = animations->FindAnimation(self->v.animation);
@@ -99,7 +99,7 @@ void animation_advance(edict_t* self)
 	}
 
 	//Set before calling animation think so it can override.
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 
 	const auto animation = animations->FindAnimation(self->v.animation);
 
@@ -99,7 +99,7 @@ void boss_shocka_frame(edict_t* self, const Animation* animation, int frame)
 
 void boss_shockb_finish(edict_t* self)
 {
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 
 	if (self->v.frame >= animations_get(self)->FindAnimationEnd("shockb"))
 	{
@@ -115,7 +115,7 @@ LINK_FUNCTION_TO_NAME(boss_shockb_finish);
 
 void boss_shockb_postframes(edict_t* self)
 {
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.frame = animations_get(self)->FindAnimationStart("shockb");
 	self->v.think = boss_shockb_finish;
 }
@@ -283,7 +283,7 @@ void boss_missile(edict_t* self, vec3_t p)
 void boss_awake(edict_t* self, edict_t* other)
 {
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 	self->v.takedamage = DAMAGE_NO;
 
 	PF_setmodel(self, "progs/boss.mdl");
@@ -359,7 +359,7 @@ void lightning_fire(edict_t* self)
 
 	p2 = p2 - offset * 100;
 
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 	self->v.think = lightning_fire;
 
 	PF_WriteByte(MSG_ALL, SVC_TEMPENTITY);
@@ -398,8 +398,8 @@ void lightning_use(edict_t* self, edict_t* other)
 	}
 
 	// don't let the electrodes go back up until the bolt is done
-	pr_global_struct->le1->v.nextthink = -1;
-	pr_global_struct->le2->v.nextthink = -1;
+	ED_SetNextThink(pr_global_struct->le1, -1);
+	ED_SetNextThink(pr_global_struct->le2, -1);
 	pr_global_struct->lightning_end = pr_global_struct->time + 1;
 
 	PF_sound(self, CHAN_VOICE, "misc/power.wav", 1, ATTN_NORM);
@@ -30,7 +30,7 @@ void button_return(edict_t* self);
 void button_wait(edict_t* self)
 {
 	self->v.state = STATE_TOP;
-	self->v.nextthink = self->v.ltime + self->v.wait;
+	ED_SetNextThink(self, self->v.ltime + self->v.wait);
 	self->v.think = button_return;
 	pr_global_struct->activator = self->v.enemy;
 	SUB_UseTargets(self);
@@ -142,7 +142,7 @@ void func_button(edict_t* self)
 
 	SetMovedir(self);
 
-	self->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(self, MOVETYPE_PUSH);
 	self->v.solid = SOLID_BSP;
 	PF_setmodel(self, self->v.model);
 
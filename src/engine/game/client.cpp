@@ -276,11 +276,11 @@ void execute_changelevel(edict_t* self)
 		VectorCopy(pos->v.mangle, other->v.angles);
 		VectorCopy(pos->v.mangle, other->v.v_angle);
 		other->v.fixangle = 1;		// turn this way immediately
-		other->v.nextthink = pr_global_struct->time + 0.5;
+		ED_SetNextThink(other, pr_global_struct->time + 0.5);
 		other->v.takedamage = DAMAGE_NO;
 		other->v.solid = SOLID_NOT;
-		other->v.movetype = MOVETYPE_NONE;
-		other->v.modelindex = 0;
+		ED_SetMovetype(other, MOVETYPE_NONE);
+		ED_SetModelIndex(other, 0);
 		PF_setorigin(other, pos->v.origin);
 		other = PF_Find(other, "classname", "player");
 	}
@@ -318,7 +318,7 @@ void changelevel_touch(edict_t* self, edict_t* other)
 	// we can't move people right now, because touch functions are called
 	// in the middle of C movement code, so set a think time to do it
 	self->v.think = &execute_changelevel;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 }
 
 LINK_FUNCTION_TO_NAME(changelevel_touch);
@@ -386,7 +386,7 @@ void Game::ClientKill(edict_t* self)
 	PF_bprint(self->v.netname);
 	PF_bprint(" suicides\n");
 	set_suicide_frame(self);
-	self->v.modelindex = modelindex_player;
+	ED_SetModelIndex(self, modelindex_player);
 	self->v.frags = self->v.frags - 2;	// extra penalty
 	respawn(self);
 }
@@ -448,11 +448,11 @@ void PlayerDie(edict_t*);
 
 void Game::PutClientInServer(edict_t* self)
 {
-	self->v.classname = "player";
+	ED_SetClassname(self, "player");
 	self->v.health = 100;
 	self->v.takedamage = DAMAGE_AIM;
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_WALK;
+	ED_SetMovetype(self, MOVETYPE_WALK);
 	self->v.show_hostile = 0;
 	self->v.max_health = 100;
 	self->v.flags = FL_CLIENT;
@@ -665,7 +665,7 @@ void NextLevel(edict_t* self)
 	if (o->v.nextthink < pr_global_struct->time)
 	{
 		o->v.think = &execute_changelevel;
-		o->v.nextthink = pr_global_struct->time + 0.1;
+		ED_SetNextThink(o, pr_global_struct->time + 0.1);
 	}
 }
 
@@ -1010,10 +1010,10 @@ void CheckPowerups(edict_t* self)
 
 		// use the eyes
 		self->v.frame = 0;
-		self->v.modelindex = modelindex_eyes;
+		ED_SetModelIndex(self, modelindex_eyes);
 	}
 	else
-		self->v.modelindex = modelindex_player;	// don't use eyes
+		ED_SetModelIndex(self, modelindex_player);	// don't use eyes
 
 // invincibility
 	if (self->v.invincible_finished)
@@ -136,7 +136,7 @@ void demon1_jump_frame(edict_t* self, const Animation* animation, int frame)
 
 	case 9:
 		self->v.think = demon1_jump1;
-		self->v.nextthink = pr_global_struct->time + 3;
+		ED_SetNextThink(self, pr_global_struct->time + 3);
 		// if three seconds pass, assume demon is stuck and jump again
 		break;
 	}
@@ -360,7 +360,7 @@ void monster_demon1(edict_t* self)
 	PF_precache_sound("demon/sight2.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/demon.mdl");
 
@@ -501,7 +501,7 @@ void Demon_JumpTouch(edict_t* self, edict_t* other)
 //dprint ("popjump\n");
 			self->v.touch = SUB_NullTouch;
 			self->v.think = demon1_jump1;
-			self->v.nextthink = pr_global_struct->time + 0.1;
+			ED_SetNextThink(self, pr_global_struct->time + 0.1);
 
 			//			self->v.velocity[0] = (PF_random() - 0.5) * 600;
 			//			self->v.velocity[1] = (PF_random() - 0.5) * 600;
@@ -513,7 +513,7 @@ void Demon_JumpTouch(edict_t* self, edict_t* other)
 
 	self->v.touch = SUB_NullTouch;
 	self->v.think = demon1_jump11;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 }
 
 LINK_FUNCTION_TO_NAME(Demon_JumpTouch);
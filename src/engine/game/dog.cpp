@@ -235,7 +235,7 @@ void Dog_JumpTouch(edict_t* self, edict_t* other)
 //dprint ("popjump\n");
 			self->v.touch = SUB_NullTouch;
 			self->v.think = dog_leap1;
-			self->v.nextthink = pr_global_struct->time + 0.1;
+			ED_SetNextThink(self, pr_global_struct->time + 0.1);
 
 			//			self->v.velocity[0] = (PF_random() - 0.5) * 600;
 			//			self->v.velocity[1] = (PF_random() - 0.5) * 600;
@@ -247,7 +247,7 @@ void Dog_JumpTouch(edict_t* self, edict_t* other)
 
 	self->v.touch = SUB_NullTouch;
 	self->v.think = dog_run1;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 }
 
 LINK_FUNCTION_TO_NAME(Dog_JumpTouch);
@@ -434,7 +434,7 @@ void monster_dog(edict_t* self)
 	PF_precache_sound("dog/idle.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/dog.mdl");
 
@@ -77,7 +77,7 @@ void door_hit_top(edict_t* self)
 	if (self->v.spawnflags & DOOR_TOGGLE)
 		return;		// don't come down automatically
 	self->v.think = door_go_down;
-	self->v.nextthink = self->v.ltime + self->v.wait;
+	ED_SetNextThink(self, self->v.ltime + self->v.wait);
 }
 
 LINK_FUNCTION_TO_NAME(door_hit_top);
@@ -112,7 +112,7 @@ void door_go_up(edict_t* self)
 
 	if (self->v.state == STATE_TOP)
 	{	// reset top wait time
-		self->v.nextthink = self->v.ltime + self->v.wait;
+		ED_SetNextThink(self, self->v.ltime + self->v.wait);
 		return;
 	}
 
@@ -296,7 +296,7 @@ SPAWNING FUNCTIONS
 edict_t* spawn_field(edict_t* self, vec3_t fmins, vec3_t fmaxs)
 {
 	auto trigger = PF_Spawn();
-	trigger->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(trigger, MOVETYPE_NONE);
 	trigger->v.solid = SOLID_TRIGGER;
 	trigger->v.owner = self;
 	trigger->v.touch = door_trigger_touch;
@@ -503,10 +503,10 @@ void func_door(edict_t* self)
 
 	self->v.max_health = self->v.health;
 	self->v.solid = SOLID_BSP;
-	self->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(self, MOVETYPE_PUSH);
 	PF_setorigin(self, self->v.origin);
 	PF_setmodel(self, self->v.model);
-	self->v.classname = "door";
+	ED_SetClassname(self, "door");
 
 	self->v.blocked = door_blocked;
 	self->v.use = door_use;
@@ -553,7 +553,7 @@ void func_door(edict_t* self)
 	// LinkDoors can't be done until all of the doors have been spawned, so
 	// the sizes can be detected properly.
 	self->v.think = LinkDoors;
-	self->v.nextthink = self->v.ltime + 0.1;
+	ED_SetNextThink(self, self->v.ltime + 0.1);
 }
 
 LINK_ENTITY_TO_CLASS(func_door);
@@ -603,7 +603,7 @@ void fd_secret_use(edict_t* self, edict_t* other)
 	// Make a sound, wait a little...
 
 	PF_sound(self, CHAN_VOICE, self->v.noise1, 1, ATTN_NORM);
-	self->v.nextthink = self->v.ltime + 0.1;
+	ED_SetNextThink(self, self->v.ltime + 0.1);
 
 	const float temp = 1 - (self->v.spawnflags & SECRET_1ST_LEFT);	// 1 or -1
 	PF_makevectors(self->v.mangle);
@@ -641,7 +641,7 @@ LINK_FUNCTION_TO_NAME(fd_secret_pain);
 // Wait after first movement...
 void fd_secret_move1(edict_t* self)
 {
-	self->v.nextthink = self->v.ltime + 1.0;
+	ED_SetNextThink(self, self->v.ltime + 1.0);
 	self->v.think = fd_secret_move2;
 	PF_sound(self, CHAN_VOICE, self->v.noise3, 1, ATTN_NORM);
 }
@@ -663,7 +663,7 @@ void fd_secret_move3(edict_t* self)
 	PF_sound(self, CHAN_VOICE, self->v.noise3, 1, ATTN_NORM);
 	if (!(self->v.spawnflags & SECRET_OPEN_ONCE))
 	{
-		self->v.nextthink = self->v.ltime + self->v.wait;
+		ED_SetNextThink(self, self->v.ltime + self->v.wait);
 		self->v.think = fd_secret_move4;
 	}
 }
@@ -682,7 +682,7 @@ LINK_FUNCTION_TO_NAME(fd_secret_move4);
 // Wait 1 second...
 void fd_secret_move5(edict_t* self)
 {
-	self->v.nextthink = self->v.ltime + 1.0;
+	ED_SetNextThink(self, self->v.ltime + 1.0);
 	self->v.think = fd_secret_move6;
 	PF_sound(self, CHAN_VOICE, self->v.noise3, 1, ATTN_NORM);
 }
@@ -799,8 +799,8 @@ void func_door_secret(edict_t* self)
 	AsVector(self->v.mangle) = AsVector(self->v.angles);
 	AsVector(self->v.angles) = AsVector(vec3_origin);
 	self->v.solid = SOLID_BSP;
-	self->v.movetype = MOVETYPE_PUSH;
-	self->v.classname = "door";
+	ED_SetMovetype(self, MOVETYPE_PUSH);
+	ED_SetClassname(self, "door");
 	PF_setmodel(self, self->v.model);
 	PF_setorigin(self, self->v.origin);
 
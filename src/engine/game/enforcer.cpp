@@ -339,7 +339,7 @@ edict_t* LaunchLaser(edict_t* self, vec3_t org, vec3_t vec)
 
 	auto newmis = PF_Spawn();
 	newmis->v.owner = self;
-	newmis->v.movetype = MOVETYPE_FLY;
+	ED_SetMovetype(newmis, MOVETYPE_FLY);
 	newmis->v.solid = SOLID_BBOX;
 	newmis->v.effects = EF_DIMLIGHT;
 
@@ -351,7 +351,7 @@ edict_t* LaunchLaser(edict_t* self, vec3_t org, vec3_t vec)
 	AsVector(newmis->v.velocity) = AsVector(vec) * 600;
 	PF_vectoangles(newmis->v.velocity, newmis->v.angles);
 
-	newmis->v.nextthink = pr_global_struct->time + 5;
+	ED_SetNextThink(newmis, pr_global_struct->time + 5);
 	newmis->v.think = SUB_Remove;
 	newmis->v.touch = Laser_Touch;
 
@@ -457,7 +457,7 @@ void monster_enforcer(edict_t* self)
 	PF_precache_sound("enforcer/sight4.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/enforcer.mdl");
 
@@ -220,7 +220,7 @@ void monster_fish(edict_t* self)
 	PF_precache_sound("fish/idle.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/fish.mdl");
 
@@ -241,13 +241,13 @@ void bodyque(edict_t* self)
 void InitBodyQue()
 {
 	bodyque_head = PF_Spawn();
-	bodyque_head->v.classname = "bodyque";
+	ED_SetClassname(bodyque_head, "bodyque");
 	bodyque_head->v.owner = PF_Spawn();
-	bodyque_head->v.owner->v.classname = "bodyque";
+	ED_SetClassname(bodyque_head->v.owner, "bodyque");
 	bodyque_head->v.owner->v.owner = PF_Spawn();
-	bodyque_head->v.owner->v.owner->v.classname = "bodyque";
+	ED_SetClassname(bodyque_head->v.owner->v.owner, "bodyque");
 	bodyque_head->v.owner->v.owner->v.owner = PF_Spawn();
-	bodyque_head->v.owner->v.owner->v.owner->v.classname = "bodyque";
+	ED_SetClassname(bodyque_head->v.owner->v.owner->v.owner, "bodyque");
 	bodyque_head->v.owner->v.owner->v.owner->v.owner = bodyque_head;
 }
 
@@ -258,10 +258,10 @@ void CopyToBodyQue(edict_t* ent)
 {
 	VectorCopy(ent->v.angles, bodyque_head->v.angles);
 	bodyque_head->v.model = ent->v.model;
-	bodyque_head->v.modelindex = ent->v.modelindex;
+	ED_SetModelIndex(bodyque_head, ent->v.modelindex);
 	bodyque_head->v.frame = ent->v.frame;
 	bodyque_head->v.colormap = ent->v.colormap;
-	bodyque_head->v.movetype = ent->v.movetype;
+	ED_SetMovetype(bodyque_head, ent->v.movetype);
 	VectorCopy(ent->v.velocity, bodyque_head->v.velocity);
 	bodyque_head->v.flags = 0;
 	PF_setorigin(bodyque_head, ent->v.origin);
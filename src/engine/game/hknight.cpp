@@ -528,7 +528,7 @@ void hknight_shot(edict_t* self, float offset)
 	vec[2] = 0 - vec[2] + (PF_random() - 0.5) * 0.1;
 
 	auto newmis = launch_spike(self, org, vec);
-	newmis->v.classname = "knightspike";
+	ED_SetClassname(newmis, "knightspike");
 	PF_setmodel(newmis, "progs/k_spike.mdl");
 	PF_setsize(newmis, VEC_ORIGIN, VEC_ORIGIN);
 	AsVector(newmis->v.velocity) = vec * 300;
@@ -770,7 +770,7 @@ void monster_hell_knight(edict_t* self)
 	PF_precache_sound("knight/sword2.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/hknight.mdl");
 
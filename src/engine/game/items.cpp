@@ -62,7 +62,7 @@ void PlaceItem(edict_t* self)
 	self->v.mdl = self->v.model;		// so it can be restored on respawn
 	self->v.flags = FL_ITEM;		// make extra wide
 	self->v.solid = SOLID_TRIGGER;
-	self->v.movetype = MOVETYPE_TOSS;
+	ED_SetMovetype(self, MOVETYPE_TOSS);
 	VectorCopy(vec3_origin, self->v.velocity);
 	self->v.origin[2] += 6;
 	if (!PF_droptofloor(self))
@@ -86,7 +86,7 @@ Sets the clipping size and plants the object on the floor
 */
 void StartItem(edict_t* self)
 {
-	self->v.nextthink = pr_global_struct->time + 0.2;	// items start after other solids
+	ED_SetNextThink(self, pr_global_struct->time + 0.2);	// items start after other solids
 	self->v.think = PlaceItem;
 }
 
@@ -206,7 +206,7 @@ void health_touch(edict_t* self, edict_t* other)
 	if (self->v.healtype == 2)
 	{
 		other->v.items = other->v.items | IT_SUPERHEALTH;
-		self->v.nextthink = pr_global_struct->time + 5;
+		ED_SetNextThink(self, pr_global_struct->time + 5);
 		self->v.think = item_megahealth_rot;
 		self->v.owner = other;
 	}
@@ -215,7 +215,7 @@ void health_touch(edict_t* self, edict_t* other)
 		if (pr_global_struct->deathmatch != 2)		// deathmatch 2 is the silly old rules
 		{
 			if (pr_global_struct->deathmatch)
-				self->v.nextthink = pr_global_struct->time + 20;
+				ED_SetNextThink(self, pr_global_struct->time + 20);
 			self->v.think = SUB_regen;
 		}
 	}
@@ -233,7 +233,7 @@ void item_megahealth_rot(edict_t* self)
 	if (other->v.health > other->v.max_health)
 	{
 		other->v.health = other->v.health - 1;
-		self->v.nextthink = pr_global_struct->time + 1;
+		ED_SetNextThink(self, pr_global_struct->time + 1);
 		return;
 	}
 
@@ -243,7 +243,7 @@ void item_megahealth_rot(edict_t* self)
 
 	if (pr_global_struct->deathmatch == 1)	// deathmatch 2 is silly old rules
 	{
-		self->v.nextthink = pr_global_struct->time + 20;
+		ED_SetNextThink(self, pr_global_struct->time + 20);
 		self->v.think = SUB_regen;
 	}
 }
@@ -298,7 +298,7 @@ void armor_touch(edict_t* self, edict_t* other)
 	self->v.solid = SOLID_NOT;
 	self->v.model = nullptr;
 	if (pr_global_struct->deathmatch == 1)
-		self->v.nextthink = pr_global_struct->time + 20;
+		ED_SetNextThink(self, pr_global_struct->time + 20);
 	self->v.think = SUB_regen;
 
 	PF_sprint(other, "You got armor\n");
@@ -517,7 +517,7 @@ void weapon_touch(edict_t* self, edict_t* other)
 	self->v.model = nullptr;
 	self->v.solid = SOLID_NOT;
 	if (pr_global_struct->deathmatch == 1)
-		self->v.nextthink = pr_global_struct->time + 30;
+		ED_SetNextThink(self, pr_global_struct->time + 30);
 	self->v.think = SUB_regen;
 
 	pr_global_struct->activator = other;
@@ -697,7 +697,7 @@ void ammo_touch(edict_t* self, edict_t* other)
 	self->v.model = nullptr;
 	self->v.solid = SOLID_NOT;
 	if (pr_global_struct->deathmatch == 1)
-		self->v.nextthink = pr_global_struct->time + 30;
+		ED_SetNextThink(self, pr_global_struct->time + 30);
 
 	self->v.think = SUB_regen;
 
@@ -1047,7 +1047,7 @@ void sigil_touch(edict_t* self, edict_t* other)
 	self->v.solid = SOLID_NOT;
 	self->v.model = nullptr;
 	pr_global_struct->serverflags = pr_global_struct->serverflags | (self->v.spawnflags & 15);
-	self->v.classname = "";		// so rune doors won't find it
+	ED_SetClassname(self, "");		// so rune doors won't find it
 
 	pr_global_struct->activator = other;
 	SUB_UseTargets(self);				// fire all targets / killtargets
@@ -1119,9 +1119,9 @@ void powerup_touch(edict_t* self, edict_t* other)
 
 		if ((!strcmp(self->v.classname, "item_artifact_invulnerability")) ||
 			(!strcmp(self->v.classname, "item_artifact_invisibility")))
-			self->v.nextthink = pr_global_struct->time + 60 * 5;
+			ED_SetNextThink(self, pr_global_struct->time + 60 * 5);
 		else
-			self->v.nextthink = pr_global_struct->time + 60;
+			ED_SetNextThink(self, pr_global_struct->time + 60);
 
 		self->v.think = SUB_regen;
 	}
@@ -1355,11 +1355,11 @@ void DropBackpack(edict_t* self)
 
 	item->v.flags = FL_ITEM;
 	item->v.solid = SOLID_TRIGGER;
-	item->v.movetype = MOVETYPE_TOSS;
+	ED_SetMovetype(item, MOVETYPE_TOSS);
 	PF_setmodel(item, "progs/backpack.mdl");
 	PF_setsize(item, Vector3D{-16, -16, 0}, Vector3D{16, 16, 56});
 	item->v.touch = BackpackTouch;
 
-	item->v.nextthink = pr_global_struct->time + 120;	// PF_Remove after 2 minutes
+	ED_SetNextThink(item, pr_global_struct->time + 120);	// PF_Remove after 2 minutes
 	item->v.think = SUB_Remove;
 }
@@ -412,7 +412,7 @@ void monster_knight(edict_t* self)
 	PF_precache_sound("knight/idle.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/knight.mdl");
 
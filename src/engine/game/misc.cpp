@@ -219,8 +219,8 @@ void misc_fireball(edict_t* self)
 {
 
 	PF_precache_model("progs/lavaball.mdl");
-	self->v.classname = "fireball";
-	self->v.nextthink = pr_global_struct->time + (PF_random() * 5);
+	ED_SetClassname(self, "fireball");
+	ED_SetNextThink(self, pr_global_struct->time + (PF_random() * 5));
 	self->v.think = fire_fly;
 
 	//Disabled because the original code never did anything.
@@ -236,20 +236,20 @@ void fire_fly(edict_t* self)
 {
 	auto fireball = PF_Spawn();
 	fireball->v.solid = SOLID_TRIGGER;
-	fireball->v.movetype = MOVETYPE_TOSS;
+	ED_SetMovetype(fireball, MOVETYPE_TOSS);
 	AsVector(fireball->v.velocity) = Vector3D{0, 0, 1000};
 	fireball->v.velocity[0] = (PF_random() * 100) - 50;
 	fireball->v.velocity[1] = (PF_random() * 100) - 50;
 	fireball->v.velocity[2] = self->v.speed + (PF_random() * 200);
-	fireball->v.classname = "fireball";
+	ED_SetClassname(fireball, "fireball");
 	PF_setmodel(fireball, "progs/lavaball.mdl");
 	PF_setsize(fireball, vec3_origin, vec3_origin);
 	PF_setorigin(fireball, self->v.origin);
-	fireball->v.nextthink = pr_global_struct->time + 5;
+	ED_SetNextThink(fireball, pr_global_struct->time + 5);
 	fireball->v.think = SUB_Remove;
 	fireball->v.touch = fire_touch;
 
-	self->v.nextthink = pr_global_struct->time + (PF_random() * 5) + 3;
+	ED_SetNextThink(self, pr_global_struct->time + (PF_random() * 5) + 3);
 	self->v.think = fire_fly;
 }
 
@@ -268,7 +268,7 @@ LINK_FUNCTION_TO_NAME(fire_touch);
 void barrel_explode(edict_t* self)
 {
 	self->v.takedamage = DAMAGE_NO;
-	self->v.classname = "explo_box";
+	ED_SetClassname(self, "explo_box");
 	// did say self->v.owner
 	T_RadiusDamage(self, self, self, 160, pr_global_struct->world);
 	PF_sound(self, CHAN_VOICE, "weapons/r_exp3.wav", 1, ATTN_NORM);
@@ -287,7 +287,7 @@ TESTING THING
 void misc_explobox(edict_t* self)
 {
 	self->v.solid = SOLID_BBOX;
-	self->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(self, MOVETYPE_NONE);
 	PF_precache_model("maps/b_explob.bsp");
 	PF_setmodel(self, "maps/b_explob.bsp");
 	PF_precache_sound("weapons/r_exp3.wav");
@@ -316,7 +316,7 @@ Smaller exploding box, REGISTERED ONLY
 void misc_explobox2(edict_t* self)
 {
 	self->v.solid = SOLID_BBOX;
-	self->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(self, MOVETYPE_NONE);
 	PF_precache_model("maps/b_exbox2.bsp");
 	PF_setmodel(self, "maps/b_exbox2.bsp");
 	PF_precache_sound("weapons/r_exp3.wav");
@@ -374,7 +374,7 @@ LINK_FUNCTION_TO_NAME(spikeshooter_use);
 void shooter_think(edict_t* self)
 {
 	auto newmis = spikeshooter_fire(self, nullptr);
-	self->v.nextthink = pr_global_struct->time + self->v.wait;
+	ED_SetNextThink(self, pr_global_struct->time + self->v.wait);
 	AsVector(newmis->v.velocity) = AsVector(self->v.movedir) * 500;
 }
 
@@ -413,7 +413,7 @@ void trap_shooter(edict_t* self)
 
 	if (self->v.wait == 0)
 		self->v.wait = 1;
-	self->v.nextthink = self->v.nextthink + self->v.wait + self->v.ltime;
+	ED_SetNextThink(self, self->v.nextthink + self->v.wait + self->v.ltime);
 	self->v.think = shooter_think;
 }
 
@@ -443,7 +443,7 @@ void air_bubbles(edict_t* self)
 		return;
 	}
 	PF_precache_model("progs/s_bubble.spr");
-	self->v.nextthink = pr_global_struct->time + 1;
+	ED_SetNextThink(self, pr_global_struct->time + 1);
 	self->v.think = make_bubbles;
 }
 
@@ -454,17 +454,17 @@ void make_bubbles(edict_t* self)
 	auto bubble = PF_Spawn();
 	PF_setmodel(bubble, "progs/s_bubble.spr");
 	PF_setorigin(bubble, self->v.origin);
-	bubble->v.movetype = MOVETYPE_NOCLIP;
+	ED_SetMovetype(bubble, MOVETYPE_NOCLIP);
 	bubble->v.solid = SOLID_NOT;
 	AsVector(bubble->v.velocity) = Vector3D{0, 0, 15};
-	bubble->v.nextthink = pr_global_struct->time + 0.5;
+	ED_SetNextThink(bubble, pr_global_struct->time + 0.5);
 	bubble->v.think = bubble_bob;
 	bubble->v.touch = bubble_remove;
-	bubble->v.classname = "bubble";
+	ED_SetClassname(bubble, "bubble");
 	bubble->v.frame = 0;
 	bubble->v.cnt = 0;
 	PF_setsize(bubble, Vector3D{-8, -8, -8}, Vector3D{8, 8, 8});
-	self->v.nextthink = pr_global_struct->time + PF_random() + 0.5;
+	ED_SetNextThink(self, pr_global_struct->time + PF_random() + 0.5);
 	self->v.think = make_bubbles;
 }
 
@@ -475,13 +475,13 @@ void bubble_split(edict_t* self)
 	auto bubble = PF_Spawn();
 	PF_setmodel(bubble, "progs/s_bubble.spr");
 	PF_setorigin(bubble, self->v.origin);
-	bubble->v.movetype = MOVETYPE_NOCLIP;
+	ED_SetMovetype(bubble, MOVETYPE_NOCLIP);
 	bubble->v.solid = SOLID_NOT;
 	AsVector(bubble->v.velocity) = AsVector(self->v.velocity);
-	bubble->v.nextthink = pr_global_struct->time + 0.5;
+	ED_SetNextThink(bubble, pr_global_struct->time + 0.5);
 	bubble->v.think = bubble_bob;
 	bubble->v.touch = bubble_remove;
-	bubble->v.classname = "bubble";
+	ED_SetClassname(bubble, "bubble");
 	bubble->v.frame = 1;
 	bubble->v.cnt = 10;
 	PF_setsize(bubble, Vector3D{-8, -8, -8}, Vector3D{8, 8, 8});
@@ -534,7 +534,7 @@ void bubble_bob(edict_t* self)
 	self->v.velocity[1] = rnd2;
 	self->v.velocity[2] = rnd3;
 
-	self->v.nextthink = pr_global_struct->time + 0.5;
+	ED_SetNextThink(self, pr_global_struct->time + 0.5);
 	self->v.think = bubble_bob;
 }
 
@@ -551,7 +551,7 @@ Just for the debugging level.  Don't use
 void viewthing(edict_t* self)
 
 {
-	self->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(self, MOVETYPE_NONE);
 	self->v.solid = SOLID_NOT;
 	PF_precache_model("progs/player.mdl");
 	PF_setmodel(self, "progs/player.mdl");
@@ -580,7 +580,7 @@ This is just a solid wall if not inhibitted
 void func_wall(edict_t* self)
 {
 	VectorCopy(vec3_origin, self->v.angles);
-	self->v.movetype = MOVETYPE_PUSH;	// so it doesn't get pushed by anything
+	ED_SetMovetype(self, MOVETYPE_PUSH);	// so it doesn't get pushed by anything
 	self->v.solid = SOLID_BSP;
 	self->v.use = func_wall_use;
 	PF_setmodel(self, self->v.model);
@@ -594,7 +594,7 @@ A simple entity that looks solid but lets you walk through it.
 void func_illusionary(edict_t* self)
 {
 	VectorCopy(vec3_origin, self->v.angles);
-	self->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(self, MOVETYPE_NONE);
 	self->v.solid = SOLID_NOT;
 	PF_setmodel(self, self->v.model);
 	PF_makestatic(self);
@@ -611,7 +611,7 @@ void func_episodegate(edict_t* self)
 		return;			// can still enter episode
 
 	VectorCopy(vec3_origin, self->v.angles);
-	self->v.movetype = MOVETYPE_PUSH;	// so it doesn't get pushed by anything
+	ED_SetMovetype(self, MOVETYPE_PUSH);	// so it doesn't get pushed by anything
 	self->v.solid = SOLID_BSP;
 	self->v.use = func_wall_use;
 	PF_setmodel(self, self->v.model);
@@ -627,7 +627,7 @@ void func_bossgate(edict_t* self)
 	if ((pr_global_struct->serverflags & 15) == 15)
 		return;		// all episodes completed
 	VectorCopy(vec3_origin, self->v.angles);
-	self->v.movetype = MOVETYPE_PUSH;	// so it doesn't get pushed by anything
+	ED_SetMovetype(self, MOVETYPE_PUSH);	// so it doesn't get pushed by anything
 	self->v.solid = SOLID_BSP;
 	self->v.use = func_wall_use;
 	PF_setmodel(self, self->v.model);
@@ -730,7 +730,7 @@ LINK_ENTITY_TO_CLASS(ambient_swamp2);
 
 void noise_think(edict_t* self)
 {
-	self->v.nextthink = pr_global_struct->time + 0.5;
+	ED_SetNextThink(self, pr_global_struct->time + 0.5);
 	PF_sound(self, 1, "enforcer/enfire.wav", 1, ATTN_NORM);
 	PF_sound(self, 2, "enforcer/enfstop.wav", 1, ATTN_NORM);
 	PF_sound(self, 3, "enforcer/sight1.wav", 1, ATTN_NORM);
@@ -760,7 +760,7 @@ void misc_noisemaker(edict_t* self)
 	PF_precache_sound("enforcer/death1.wav");
 	PF_precache_sound("enforcer/idle1.wav");
 
-	self->v.nextthink = pr_global_struct->time + 0.1 + PF_random();
+	ED_SetNextThink(self, pr_global_struct->time + 0.1 + PF_random());
 	self->v.think = noise_think;
 }
 
@@ -247,7 +247,7 @@ void ogre_smash_frame(edict_t* self, const Animation* animation, int frame)
 		ai_charge(self, 2);
 		chainsaw(self, 0);
 		// slight variation
-		self->v.nextthink = self->v.nextthink + PF_random() * 0.2;
+		ED_SetNextThink(self, self->v.nextthink + PF_random() * 0.2);
 		break;
 
 	case 13:
@@ -426,7 +426,7 @@ void OgreFireGrenade(edict_t* self)
 
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetMovetype(missile, MOVETYPE_BOUNCE);
 	missile->v.solid = SOLID_BBOX;
 
 	// set missile speed	
@@ -444,7 +444,7 @@ void OgreFireGrenade(edict_t* self)
 	missile->v.touch = OgreGrenadeTouch;
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 2.5;
+	ED_SetNextThink(missile, pr_global_struct->time + 2.5);
 	missile->v.think = OgreGrenadeExplode;
 
 	PF_setmodel(missile, "progs/grenade.mdl");
@@ -657,7 +657,7 @@ void monster_ogre(edict_t* self)
 	PF_precache_sound("ogre/ogwake.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/ogre.mdl");
 
@@ -137,11 +137,11 @@ void finale_1(edict_t* self)
 		AsVector(pl->v.angles) = AsVector(other->v.v_angle) = AsVector(pos->v.mangle);
 		pl->v.fixangle = 1;		// turn this way immediately
 		pl->v.map = self->v.map;
-		pl->v.nextthink = pr_global_struct->time + 0.5;
+		ED_SetNextThink(pl, pr_global_struct->time + 0.5);
 		pl->v.takedamage = DAMAGE_NO;
 		pl->v.solid = SOLID_NOT;
-		pl->v.movetype = MOVETYPE_NONE;
-		pl->v.modelindex = 0;
+		ED_SetMovetype(pl, MOVETYPE_NONE);
+		ED_SetModelIndex(pl, 0);
 		PF_setorigin(pl, pos->v.origin);
 		pl = PF_Find(pl, "classname", "player");
 	}
@@ -151,7 +151,7 @@ void finale_1(edict_t* self)
 
 	// wait for 1 second
 	auto timer = PF_Spawn();
-	timer->v.nextthink = pr_global_struct->time + 1;
+	ED_SetNextThink(timer, pr_global_struct->time + 1);
 	timer->v.think = finale_2;
 }
 
@@ -170,7 +170,7 @@ void finale_2(edict_t* self)
 
 	PF_sound(pr_global_struct->shub, CHAN_VOICE, "misc/r_tele1.wav", 1, ATTN_NORM);
 
-	self->v.nextthink = pr_global_struct->time + 2;
+	ED_SetNextThink(self, pr_global_struct->time + 2);
 	self->v.think = finale_3;
 }
 
@@ -263,14 +263,14 @@ void monster_oldone(edict_t* self)
 	PF_precache_sound("boss2/pop2.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/oldone.mdl");
 	PF_setsize(self, Vector3D{-160, -128, -24}, Vector3D{160, 128, 256});
 
 	self->v.health = 40000;		// kill by telefrag
 	self->v.think = old_idle1;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 	self->v.takedamage = DAMAGE_YES;
 	self->v.th_die = finale_1;
 	self->v.animations_get = &old_animations_get;
@@ -36,7 +36,7 @@ void plat_spawn_inside_trigger(edict_t* self)
 	//	
 	auto trigger = PF_Spawn();
 	trigger->v.touch = plat_center_touch;
-	trigger->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(trigger, MOVETYPE_NONE);
 	trigger->v.solid = SOLID_TRIGGER;
 	trigger->v.enemy = self;
 
@@ -65,7 +65,7 @@ void plat_hit_top(edict_t* self)
 	PF_sound(self, CHAN_VOICE, self->v.noise1, 1, ATTN_NORM);
 	self->v.state = STATE_TOP;
 	self->v.think = plat_go_down;
-	self->v.nextthink = self->v.ltime + 3;
+	ED_SetNextThink(self, self->v.ltime + 3);
 }
 
 LINK_FUNCTION_TO_NAME(plat_hit_top);
@@ -106,7 +106,7 @@ void plat_center_touch(edict_t* self, edict_t* other)
 	if (self->v.state == STATE_BOTTOM)
 		plat_go_up(self);
 	else if (self->v.state == STATE_TOP)
-		self->v.nextthink = self->v.ltime + 1;	// delay going down
+		ED_SetNextThink(self, self->v.ltime + 1);	// delay going down
 }
 
 LINK_FUNCTION_TO_NAME(plat_center_touch);
@@ -208,9 +208,9 @@ void func_plat(edict_t* self)
 	AsVector(self->v.mangle) = AsVector(self->v.angles);
 	AsVector(self->v.angles) = AsVector(vec3_origin);
 
-	self->v.classname = "plat";
+	ED_SetClassname(self, "plat");
 	self->v.solid = SOLID_BSP;
-	self->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(self, MOVETYPE_PUSH);
 	PF_setorigin(self, self->v.origin);
 	PF_setmodel(self, self->v.model);
 	PF_setsize(self, self->v.mins, self->v.maxs);
@@ -273,11 +273,11 @@ void train_wait(edict_t* self)
 {
 	if (self->v.wait)
 	{
-		self->v.nextthink = self->v.ltime + self->v.wait;
+		ED_SetNextThink(self, self->v.ltime + self->v.wait);
 		PF_sound(self, CHAN_VOICE, self->v.noise, 1, ATTN_NORM);
 	}
 	else
-		self->v.nextthink = self->v.ltime + 0.1;
+		ED_SetNextThink(self, self->v.ltime + 0.1);
 
 	self->v.think = train_next;
 }
@@ -308,7 +308,7 @@ void func_train_find(edict_t* self)
 	PF_setorigin(self, AsVector(targ->v.origin) - AsVector(self->v.mins));
 	if (!self->v.targetname)
 	{	// not triggered, so start immediately
-		self->v.nextthink = self->v.ltime + 0.1;
+		ED_SetNextThink(self, self->v.ltime + 0.1);
 		self->v.think = train_next;
 	}
 }
@@ -353,10 +353,10 @@ void func_train(edict_t* self)
 
 	self->v.cnt = 1;
 	self->v.solid = SOLID_BSP;
-	self->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(self, MOVETYPE_PUSH);
 	self->v.blocked = train_blocked;
 	self->v.use = train_use;
-	self->v.classname = "train";
+	ED_SetClassname(self, "train");
 
 	PF_setmodel(self, self->v.model);
 	PF_setsize(self, self->v.mins, self->v.maxs);
@@ -364,7 +364,7 @@ void func_train(edict_t* self)
 
 	// start trains on the second frame, to make sure their targets have had
 	// a chance to spawn
-	self->v.nextthink = self->v.ltime + 0.1;
+	ED_SetNextThink(self, self->v.ltime + 0.1);
 	self->v.think = func_train_find;
 }
 
@@ -382,7 +382,7 @@ void misc_teleporttrain(edict_t* self)
 
 	self->v.cnt = 1;
 	self->v.solid = SOLID_NOT;
-	self->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(self, MOVETYPE_PUSH);
 	self->v.blocked = train_blocked;
 	self->v.use = train_use;
 	AsVector(self->v.avelocity) = Vector3D{100, 200, 300};
@@ -399,7 +399,7 @@ void misc_teleporttrain(edict_t* self)
 
 	// start trains on the second frame, to make sure their targets have had
 	// a chance to spawn
-	self->v.nextthink = self->v.ltime + 0.1;
+	ED_SetNextThink(self, self->v.ltime + 0.1);
 	self->v.think = func_train_find;
 }
 
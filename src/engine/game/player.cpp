@@ -159,7 +159,7 @@ PLAYER
 void player_stand1(edict_t* self)
 {
 	self->v.think = &player_stand1;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 
 	self->v.weaponframe = 0;
 	if (self->v.velocity[0] || self->v.velocity[1])
@@ -189,7 +189,7 @@ LINK_FUNCTION_TO_NAME(player_stand1);
 void player_run(edict_t* self)
 {
 	self->v.think = &player_run;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 
 	self->v.weaponframe = 0;
 	if (!self->v.velocity[0] && !self->v.velocity[1])
@@ -378,16 +378,16 @@ void DeathBubblesSpawn(edict_t* self)
 	auto bubble = PF_Spawn();
 	PF_setmodel(bubble, "progs/s_bubble.spr");
 	PF_setorigin(bubble, AsVector(self->v.owner->v.origin) + Vector3D{0, 0, 24});
-	bubble->v.movetype = MOVETYPE_NOCLIP;
+	ED_SetMovetype(bubble, MOVETYPE_NOCLIP);
 	bubble->v.solid = SOLID_NOT;
 	AsVector(bubble->v.velocity) = Vector3D{0, 0, 15};
-	bubble->v.nextthink = pr_global_struct->time + 0.5;
+	ED_SetNextThink(bubble, pr_global_struct->time + 0.5);
 	bubble->v.think = bubble_bob;
-	bubble->v.classname = "bubble";
+	ED_SetClassname(bubble, "bubble");
 	bubble->v.frame = 0;
 	bubble->v.cnt = 0;
 	PF_setsize(bubble, Vector3D{-8, -8, -8}, Vector3D{8, 8, 8});
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 	self->v.think = DeathBubblesSpawn;
 	self->v.air_finished = self->v.air_finished + 1;
 	if (self->v.air_finished >= self->v.bubble_count)
@@ -400,9 +400,9 @@ void DeathBubbles(edict_t* self, float num_bubbles)
 {
 	auto bubble_spawner = PF_Spawn();
 	PF_setorigin(bubble_spawner, self->v.origin);
-	bubble_spawner->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(bubble_spawner, MOVETYPE_NONE);
 	bubble_spawner->v.solid = SOLID_NOT;
-	bubble_spawner->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(bubble_spawner, pr_global_struct->time + 0.1);
 	bubble_spawner->v.think = DeathBubblesSpawn;
 	bubble_spawner->v.air_finished = 0;
 	bubble_spawner->v.owner = self;
@@ -438,7 +438,7 @@ void DeathSound(edict_t* self)
 
 void PlayerDead(edict_t* self)
 {
-	self->v.nextthink = -1;
+	ED_SetNextThink(self, -1);
 	// allow respawn after a certain time
 	self->v.deadflag = DEAD_DEAD;
 }
@@ -472,14 +472,14 @@ void ThrowGib(edict_t* self, const char* gibname, float dm)
 	PF_setmodel(ent, gibname);
 	PF_setsize(ent, vec3_origin, vec3_origin);
 	VelocityForDamage(self, dm, ent->v.velocity);
-	ent->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetMovetype(ent, MOVETYPE_BOUNCE);
 	ent->v.solid = SOLID_NOT;
 	ent->v.avelocity[0] = PF_random() * 600;
 	ent->v.avelocity[1] = PF_random() * 600;
 	ent->v.avelocity[2] = PF_random() * 600;
 	ent->v.think = &SUB_Remove;
 	ent->v.ltime = pr_global_struct->time;
-	ent->v.nextthink = pr_global_struct->time + 10 + PF_random() * 10;
+	ED_SetNextThink(ent, pr_global_struct->time + 10 + PF_random() * 10);
 	ent->v.frame = 0;
 	ent->v.flags = 0;
 }
@@ -488,8 +488,8 @@ void ThrowHead(edict_t* self, const char* gibname, float dm)
 {
 	PF_setmodel(self, gibname);
 	self->v.frame = 0;
-	self->v.nextthink = -1;
-	self->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetNextThink(self, -1);
+	ED_SetMovetype(self, MOVETYPE_BOUNCE);
 	self->v.takedamage = DAMAGE_NO;
 	self->v.solid = SOLID_NOT;
 	self->v.view_ofs[0] = 0;
@@ -566,7 +566,7 @@ void PlayerDie(edict_t* self)
 	self->v.invincible_finished = 0;
 	self->v.super_damage_finished = 0;
 	self->v.radsuit_finished = 0;
-	self->v.modelindex = modelindex_player;	// don't use eyes
+	ED_SetModelIndex(self, modelindex_player);	// don't use eyes
 
 	if (pr_global_struct->deathmatch || pr_global_struct->coop)
 	{
@@ -580,7 +580,7 @@ void PlayerDie(edict_t* self)
 	self->v.deadflag = DEAD_DYING;
 	self->v.solid = SOLID_NOT;
 	self->v.flags &= ~FL_ONGROUND;
-	self->v.movetype = MOVETYPE_TOSS;
+	ED_SetMovetype(self, MOVETYPE_TOSS);
 	if (self->v.velocity[2] < 10)
 		self->v.velocity[2] += PF_random() * 300;
 
@@ -625,7 +625,7 @@ void set_suicide_frame(edict_t* self)
 		return;	// allready gibbed
 	self->v.frame = PlayerAnimations.FindAnimationEnd("deatha");
 	self->v.solid = SOLID_NOT;
-	self->v.movetype = MOVETYPE_TOSS;
+	ED_SetMovetype(self, MOVETYPE_TOSS);
 	self->v.deadflag = DEAD_DEAD;
-	self->v.nextthink = -1;
+	ED_SetNextThink(self, -1);
 }
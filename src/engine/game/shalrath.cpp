@@ -293,7 +293,7 @@ void ShalMissile(edict_t* self)
 	missile->v.owner = self;
 
 	missile->v.solid = SOLID_BBOX;
-	missile->v.movetype = MOVETYPE_FLYMISSILE;
+	ED_SetMovetype(missile, MOVETYPE_FLYMISSILE);
 	PF_setmodel(missile, "progs/v_spike.mdl");
 
 	PF_setsize(missile, vec3_origin, vec3_origin);
@@ -301,7 +301,7 @@ void ShalMissile(edict_t* self)
 	AsVector(missile->v.origin) = AsVector(self->v.origin) + Vector3D{0, 0, 10};
 	AsVector(missile->v.velocity) = dir * 400;
 	AsVector(missile->v.avelocity) = Vector3D{300, 300, 300};
-	missile->v.nextthink = flytime + pr_global_struct->time;
+	ED_SetNextThink(missile, flytime + pr_global_struct->time);
 	missile->v.think = ShalHome;
 	missile->v.enemy = self->v.enemy;
 	missile->v.touch = ShalMissileTouch;
@@ -322,7 +322,7 @@ void ShalHome(edict_t* self)
 		AsVector(self->v.velocity) = dir * 350;
 	else
 		AsVector(self->v.velocity) = dir * 250;
-	self->v.nextthink = pr_global_struct->time + 0.2;
+	ED_SetNextThink(self, pr_global_struct->time + 0.2);
 	self->v.think = ShalHome;
 }
 
@@ -376,7 +376,7 @@ void monster_shalrath(edict_t* self)
 	PF_precache_sound("shalrath/sight.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/shalrath.mdl");
 	PF_setsize(self, VEC_HULL2_MIN, VEC_HULL2_MAX);
@@ -391,7 +391,7 @@ void monster_shalrath(edict_t* self)
 	self->v.animations_get = &shal_animations_get;
 
 	self->v.think = walkmonster_start;
-	self->v.nextthink = pr_global_struct->time + 0.1 + PF_random() * 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1 + PF_random() * 0.1);
 
 }
 
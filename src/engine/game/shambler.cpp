@@ -310,7 +310,7 @@ void shambler_magic_frame(edict_t* self, const Animation* animation, int frame)
 	case 2:
 	{
 		ai_face(self);
-		self->v.nextthink = self->v.nextthink + 0.2;
+		ED_SetNextThink(self, self->v.nextthink + 0.2);
 
 		self->v.effects |= EF_MUZZLEFLASH;
 		ai_face(self);
@@ -318,7 +318,7 @@ void shambler_magic_frame(edict_t* self, const Animation* animation, int frame)
 		PF_setmodel(o, "progs/s_light.mdl");
 		PF_setorigin(o, self->v.origin);
 		AsVector(o->v.angles) = AsVector(self->v.angles);
-		o->v.nextthink = pr_global_struct->time + 0.7;
+		ED_SetNextThink(o, pr_global_struct->time + 0.7);
 		o->v.think = SUB_Remove;
 		break;
 	}
@@ -583,7 +583,7 @@ void monster_shambler(edict_t* self)
 	PF_precache_sound("shambler/smack.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 	PF_setmodel(self, "progs/shambler.mdl");
 
 	PF_setsize(self, VEC_HULL2_MIN, VEC_HULL2_MAX);
@@ -428,7 +428,7 @@ void monster_army(edict_t* self)
 
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/soldier.mdl");
 
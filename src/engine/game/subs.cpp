@@ -99,8 +99,8 @@ void InitTrigger(edict_t* self)
 		SetMovedir(self);
 	self->v.solid = SOLID_TRIGGER;
 	PF_setmodel(self, self->v.model);	// set size and link into world
-	self->v.movetype = MOVETYPE_NONE;
-	self->v.modelindex = 0;
+	ED_SetMovetype(self, MOVETYPE_NONE);
+	ED_SetModelIndex(self, 0);
 	self->v.model = "";
 }
 
@@ -129,7 +129,7 @@ void SUB_CalcMove(edict_t* self, vec3_t tdest, float tspeed, void (*func)(edict_
 	if (VectorCompare(tdest, self->v.origin))
 	{
 		VectorCopy(vec3_origin, self->v.velocity);
-		self->v.nextthink = self->v.ltime + 0.1;
+		ED_SetNextThink(self, self->v.ltime + 0.1);
 		return;
 	}
 
@@ -146,12 +146,12 @@ void SUB_CalcMove(edict_t* self, vec3_t tdest, float tspeed, void (*func)(edict_
 	if (traveltime < 0.1)
 	{
 		VectorCopy(vec3_origin, self->v.velocity);
-		self->v.nextthink = self->v.ltime + 0.1;
+		ED_SetNextThink(self, self->v.ltime + 0.1);
 		return;
 	}
 
 	// set nextthink to trigger a think when dest is reached
-	self->v.nextthink = self->v.ltime + traveltime;
+	ED_SetNextThink(self, self->v.ltime + traveltime);
 
 	// scale the destdelta vector by the time spent traveling to get velocity
 	VectorScale(vdestdelta, (1 / traveltime), self->v.velocity); // qcc won't take vec/float	
@@ -166,7 +166,7 @@ void SUB_CalcMoveDone(edict_t* self)
 {
 	PF_setorigin(self, self->v.finaldest);
 	VectorCopy(vec3_origin, self->v.velocity);
-	self->v.nextthink = -1;
+	ED_SetNextThink(self, -1);
 	if (self->v.think1)
 		self->v.think1(self);
 }
@@ -204,7 +204,7 @@ void SUB_CalcAngleMove(edict_t* self, vec3_t destangle, float tspeed, void (*fun
 	const float traveltime = len / tspeed;
 
 	// set nextthink to trigger a think when dest is reached
-	self->v.nextthink = self->v.ltime + traveltime;
+	ED_SetNextThink(self, self->v.ltime + traveltime);
 
 	// scale the destdelta vector by the time spent traveling to get velocity
 	VectorScale(destdelta, (1 / traveltime), self->v.avelocity);
@@ -223,7 +223,7 @@ void SUB_CalcAngleMoveDone(edict_t* self)
 {
 	VectorCopy(self->v.finalangle, self->v.angles);
 	VectorCopy(vec3_origin, self->v.avelocity);
-	self->v.nextthink = -1;
+	ED_SetNextThink(self, -1);
 	if (self->v.think1)
 		self->v.think1(self);
 }
@@ -269,8 +269,8 @@ void SUB_UseTargets(edict_t* self, edict_t* other)
 	{
 		// create a temp object to fire at a later time
 		auto t = PF_Spawn();
-		t->v.classname = "DelayedUse";
-		t->v.nextthink = pr_global_struct->time + self->v.delay;
+		ED_SetClassname(t, "DelayedUse");
+		ED_SetNextThink(t, pr_global_struct->time + self->v.delay);
 		t->v.think = DelayThink;
 		t->v.enemy = pr_global_struct->activator;
 		t->v.message = self->v.message;
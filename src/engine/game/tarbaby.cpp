@@ -120,7 +120,7 @@ void tarbaby_jump_frame(edict_t* self, const Animation* animation, int frame)
 	}
 	else if (frame == 4)
 	{
-		self->v.movetype = MOVETYPE_BOUNCE;
+		ED_SetMovetype(self, MOVETYPE_BOUNCE);
 		self->v.touch = Tar_JumpTouch;
 		PF_makevectors(self->v.angles);
 		self->v.origin[2] = self->v.origin[2] + 1;
@@ -139,7 +139,7 @@ void tarbaby_jump_frame(edict_t* self, const Animation* animation, int frame)
 
 void tarbaby_exp_finish(edict_t* self)
 {
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &tbaby_run1;
 
 	T_RadiusDamage(self, self, self, 120, pr_global_struct->world);
@@ -238,8 +238,8 @@ void Tar_JumpTouch(edict_t* self, edict_t* other)
 //dprint ("popjump\n");
 			self->v.touch = SUB_NullTouch;
 			self->v.think = tbaby_run1;
-			self->v.movetype = MOVETYPE_STEP;
-			self->v.nextthink = pr_global_struct->time + 0.1;
+			ED_SetMovetype(self, MOVETYPE_STEP);
+			ED_SetNextThink(self, pr_global_struct->time + 0.1);
 
 			//			self->v.velocity_x = (PF_random() - 0.5) * 600;
 			//			self->v.velocity_y = (PF_random() - 0.5) * 600;
@@ -251,7 +251,7 @@ void Tar_JumpTouch(edict_t* self, edict_t* other)
 
 	self->v.touch = SUB_NullTouch;
 	self->v.think = tbaby_jump1;
-	self->v.nextthink = pr_global_struct->time + 0.1;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1);
 }
 
 LINK_FUNCTION_TO_NAME(Tar_JumpTouch);
@@ -298,7 +298,7 @@ void monster_tarbaby(edict_t* self)
 	PF_precache_sound("blob/sight1.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/tarbaby.mdl");
 
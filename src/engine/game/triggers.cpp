@@ -77,13 +77,13 @@ void multi_trigger(edict_t* self)
 	if (self->v.wait > 0)
 	{
 		self->v.think = multi_wait;
-		self->v.nextthink = pr_global_struct->time + self->v.wait;
+		ED_SetNextThink(self, pr_global_struct->time + self->v.wait);
 	}
 	else
 	{	// we can't just remove (self) here, because this is a touch function
 		// called wheil C code is looping through area links...
 		self->v.touch = SUB_NullTouch;
-		self->v.nextthink = pr_global_struct->time + 0.1;
+		ED_SetNextThink(self, pr_global_struct->time + 0.1);
 		self->v.think = SUB_Remove;
 	}
 }
@@ -340,7 +340,7 @@ void spawn_tfog(edict_t* self, vec3_t org)
 {
 	auto s = PF_Spawn();
 	VectorCopy(org, s->v.origin);
-	s->v.nextthink = pr_global_struct->time + 0.2;
+	ED_SetNextThink(s, pr_global_struct->time + 0.2);
 	s->v.think = play_teleport;
 
 	PF_WriteByte(MSG_BROADCAST, SVC_TEMPENTITY);
@@ -360,7 +360,7 @@ void tdeath_touch(edict_t* self, edict_t* other)
 	if (!strcmp(other->v.classname, "player"))
 	{
 		if (other->v.invincible_finished > pr_global_struct->time)
-			self->v.classname = "teledeath2";
+			ED_SetClassname(self, "teledeath2");
 		if (strcmp(self->v.owner->v.classname, "player"))
 		{	// other monsters explode themselves
 			T_Damage(self, self->v.owner, self, self, 50000);
@@ -380,14 +380,14 @@ LINK_FUNCTION_TO_NAME(tdeath_touch);
 void spawn_tdeath(edict_t* self, vec3_t org, edict_t* death_owner)
 {
 	auto death = PF_Spawn();
-	death->v.classname = "teledeath";
-	death->v.movetype = MOVETYPE_NONE;
+	ED_SetClassname(death, "teledeath");
+	ED_SetMovetype(death, MOVETYPE_NONE);
 	death->v.solid = SOLID_TRIGGER;
 	VectorCopy(vec3_origin, death->v.angles);
 	PF_setsize(death, AsVector(death_owner->v.mins) - Vector3D{1, 1, 1}, AsVector(death_owner->v.maxs) + Vector3D{1, 1, 1});
 	PF_setorigin(death, org);
 	death->v.touch = tdeath_touch;
-	death->v.nextthink = pr_global_struct->time + 0.2;
+	ED_SetNextThink(death, pr_global_struct->time + 0.2);
 	death->v.think = SUB_Remove;
 	death->v.owner = death_owner;
 
@@ -469,7 +469,7 @@ LINK_ENTITY_TO_CLASS(info_teleport_destination);
 
 void teleport_use(edict_t* self, edict_t* other)
 {
-	self->v.nextthink = pr_global_struct->time + 0.2;
+	ED_SetNextThink(self, pr_global_struct->time + 0.2);
 	pr_global_struct->force_retouch = 2;		// make sure even still objects get hit
 	self->v.think = SUB_NullThink;
 }
@@ -581,7 +581,7 @@ LINK_ENTITY_TO_CLASS(trigger_onlyregistered);
 void hurt_on(edict_t* self)
 {
 	self->v.solid = SOLID_TRIGGER;
-	self->v.nextthink = -1;
+	ED_SetNextThink(self, -1);
 }
 
 LINK_FUNCTION_TO_NAME(hurt_on);
@@ -593,7 +593,7 @@ void hurt_touch(edict_t* self, edict_t* other)
 		self->v.solid = SOLID_NOT;
 		T_Damage(self, other, self, self, self->v.dmg);
 		self->v.think = hurt_on;
-		self->v.nextthink = pr_global_struct->time + 1;
+		ED_SetNextThink(self, pr_global_struct->time + 1);
 	}
 
 	return;
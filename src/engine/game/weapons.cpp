@@ -99,7 +99,7 @@ void SpawnMeatSpray(edict_t* self, vec3_t org, vec3_t vel)
 {
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetMovetype(missile, MOVETYPE_BOUNCE);
 	missile->v.solid = SOLID_NOT;
 
 	PF_makevectors(self->v.angles);
@@ -110,7 +110,7 @@ void SpawnMeatSpray(edict_t* self, vec3_t org, vec3_t vel)
 	AsVector(missile->v.avelocity) = Vector3D{3000, 1000, 2000};
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 1;
+	ED_SetNextThink(missile, pr_global_struct->time + 1);
 	missile->v.think = SUB_Remove;
 
 	PF_setmodel(missile, "progs/zom_gib.mdl");
@@ -315,7 +315,7 @@ ROCKETS
 void s_explode6(edict_t* self)
 {
 	self->v.frame = 5;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &SUB_Remove;
 }
 
@@ -324,7 +324,7 @@ LINK_FUNCTION_TO_NAME(s_explode6);
 void s_explode5(edict_t* self)
 {
 	self->v.frame = 4;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &s_explode6;
 }
 
@@ -333,7 +333,7 @@ LINK_FUNCTION_TO_NAME(s_explode5);
 void s_explode4(edict_t* self)
 {
 	self->v.frame = 3;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &s_explode5;
 }
 
@@ -342,7 +342,7 @@ LINK_FUNCTION_TO_NAME(s_explode4);
 void s_explode3(edict_t* self)
 {
 	self->v.frame = 2;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &s_explode4;
 }
 
@@ -351,7 +351,7 @@ LINK_FUNCTION_TO_NAME(s_explode3);
 void s_explode2(edict_t* self)
 {
 	self->v.frame = 1;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &s_explode3;
 }
 
@@ -360,7 +360,7 @@ LINK_FUNCTION_TO_NAME(s_explode2);
 void s_explode1(edict_t* self)
 {
 	self->v.frame = 0;
-	self->v.nextthink = pr_global_struct->time + 0.1f;
+	ED_SetNextThink(self, pr_global_struct->time + 0.1f);
 	self->v.think = &s_explode2;
 }
 
@@ -368,7 +368,7 @@ LINK_FUNCTION_TO_NAME(s_explode1);
 
 void BecomeExplosion(edict_t* self)
 {
-	self->v.movetype = MOVETYPE_NONE;
+	ED_SetMovetype(self, MOVETYPE_NONE);
 	VectorCopy(vec3_origin, self->v.velocity);
 	self->v.touch = SUB_NullTouch;
 	PF_setmodel(self, "progs/s_explod.spr");
@@ -431,7 +431,7 @@ void W_FireRocket(edict_t* self)
 
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.movetype = MOVETYPE_FLYMISSILE;
+	ED_SetMovetype(missile, MOVETYPE_FLYMISSILE);
 	missile->v.solid = SOLID_BBOX;
 
 	// set missile speed	
@@ -444,7 +444,7 @@ void W_FireRocket(edict_t* self)
 	missile->v.touch = T_MissileTouch;
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 5;
+	ED_SetNextThink(missile, pr_global_struct->time + 5);
 	missile->v.think = SUB_Remove;
 
 	PF_setmodel(missile, "progs/missile.mdl");
@@ -607,9 +607,9 @@ void W_FireGrenade(edict_t* self)
 
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetMovetype(missile, MOVETYPE_BOUNCE);
 	missile->v.solid = SOLID_BBOX;
-	missile->v.classname = "grenade";
+	ED_SetClassname(missile, "grenade");
 
 	// set missile speed	
 
@@ -634,7 +634,7 @@ void W_FireGrenade(edict_t* self)
 	missile->v.touch = GrenadeTouch;
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 2.5;
+	ED_SetNextThink(missile, pr_global_struct->time + 2.5);
 	missile->v.think = GrenadeExplode;
 
 	PF_setmodel(missile, "progs/grenade.mdl");
@@ -656,15 +656,15 @@ edict_t* launch_spike(edict_t* self, vec3_t org, vec3_t dir)
 {
 	auto newmis = PF_Spawn();
 	newmis->v.owner = self;
-	newmis->v.movetype = MOVETYPE_FLYMISSILE;
+	ED_SetMovetype(newmis, MOVETYPE_FLYMISSILE);
 	newmis->v.solid = SOLID_BBOX;
 
 	PF_vectoangles(dir, newmis->v.angles);
 
 	newmis->v.touch = spike_touch;
-	newmis->v.classname = "spike";
+	ED_SetClassname(newmis, "spike");
 	newmis->v.think = SUB_Remove;
-	newmis->v.nextthink = pr_global_struct->time + 6;
+	ED_SetNextThink(newmis, pr_global_struct->time + 6);
 	PF_setmodel(newmis, "progs/spike.mdl");
 	PF_setsize(newmis, VEC_ORIGIN, VEC_ORIGIN);
 	PF_setorigin(newmis, org);
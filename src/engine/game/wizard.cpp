@@ -208,7 +208,7 @@ void LaunchMissile(edict_t* self, edict_t* missile, float mspeed, float accuracy
 	missile->v.angles[1] = PF_vectoyaw(missile->v.velocity);
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 5;
+	ED_SetNextThink(missile, pr_global_struct->time + 5);
 	missile->v.think = SUB_Remove;
 }
 
@@ -331,7 +331,7 @@ void Wiz_FastFire(edict_t* self)
 		auto newmis = launch_spike(self, self->v.origin, vec);
 		AsVector(newmis->v.velocity) = vec * 600;
 		newmis->v.owner = self->v.owner;
-		newmis->v.classname = "wizspike";
+		ED_SetClassname(newmis, "wizspike");
 		PF_setmodel(newmis, "progs/w_spike.mdl");
 		PF_setsize(newmis, VEC_ORIGIN, VEC_ORIGIN);
 	}
@@ -349,21 +349,21 @@ void Wiz_StartFast(edict_t* self)
 
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.nextthink = pr_global_struct->time + 0.6;
+	ED_SetNextThink(missile, pr_global_struct->time + 0.6);
 	PF_setsize(missile, Vector3D{0, 0, 0}, Vector3D{0, 0, 0});
 	PF_setorigin(missile, AsVector(self->v.origin) + Vector3D{0, 0, 30} + AsVector(pr_global_struct->v_forward) * 14 + AsVector(pr_global_struct->v_right) * 14);
 	missile->v.enemy = self->v.enemy;
-	missile->v.nextthink = pr_global_struct->time + 0.8;
+	ED_SetNextThink(missile, pr_global_struct->time + 0.8);
 	missile->v.think = Wiz_FastFire;
 	AsVector(missile->v.movedir) = AsVector(pr_global_struct->v_right);
 
 	missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.nextthink = pr_global_struct->time + 1;
+	ED_SetNextThink(missile, pr_global_struct->time + 1);
 	PF_setsize(missile, Vector3D{0, 0, 0}, Vector3D{0, 0, 0});
 	PF_setorigin(missile, AsVector(self->v.origin) + Vector3D{0, 0, 30} + AsVector(pr_global_struct->v_forward) * 14 + AsVector(pr_global_struct->v_right) * -14);
 	missile->v.enemy = self->v.enemy;
-	missile->v.nextthink = pr_global_struct->time + 0.3;
+	ED_SetNextThink(missile, pr_global_struct->time + 0.3);
 	missile->v.think = Wiz_FastFire;
 	AsVector(missile->v.movedir) = AsVector(vec3_origin) - AsVector(pr_global_struct->v_right);
 }
@@ -487,7 +487,7 @@ void monster_wizard(edict_t* self)
 	PF_precache_sound("wizard/wsight.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/wizard.mdl");
 
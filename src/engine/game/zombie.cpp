@@ -51,7 +51,7 @@ void zombie_cruc_frame(edict_t* self, const Animation* animation, int frame)
 	}
 	else
 	{
-		self->v.nextthink = pr_global_struct->time + 0.1 + PF_random() * 0.1;
+		ED_SetNextThink(self, pr_global_struct->time + 0.1 + PF_random() * 0.1);
 	}
 }
 
@@ -350,7 +350,7 @@ void zombie_paine_frame(edict_t* self, const Animation* animation, int frame)
 		break;
 
 	case 10:
-		self->v.nextthink = self->v.nextthink + 5;
+		ED_SetNextThink(self, self->v.nextthink + 5);
 		self->v.health = 60;
 		break;
 
@@ -504,7 +504,7 @@ void ZombieFireGrenade(edict_t* self, vec3_t st)
 
 	auto missile = PF_Spawn();
 	missile->v.owner = self;
-	missile->v.movetype = MOVETYPE_BOUNCE;
+	ED_SetMovetype(missile, MOVETYPE_BOUNCE);
 	missile->v.solid = SOLID_BBOX;
 
 	// calc org
@@ -525,7 +525,7 @@ void ZombieFireGrenade(edict_t* self, vec3_t st)
 	missile->v.touch = ZombieGrenadeTouch;
 
 	// set missile duration
-	missile->v.nextthink = pr_global_struct->time + 2.5;
+	ED_SetNextThink(missile, pr_global_struct->time + 2.5);
 	missile->v.think = SUB_Remove;
 
 	PF_setmodel(missile, "progs/zom_gib.mdl");
@@ -663,7 +663,7 @@ void monster_zombie(edict_t* self)
 	PF_precache_sound("zombie/idle_w2.wav");
 
 	self->v.solid = SOLID_SLIDEBOX;
-	self->v.movetype = MOVETYPE_STEP;
+	ED_SetMovetype(self, MOVETYPE_STEP);
 
 	PF_setmodel(self, "progs/zombie.mdl");
 
@@ -680,7 +680,7 @@ void monster_zombie(edict_t* self)
 
 	if (self->v.spawnflags & SPAWN_CRUCIFIED)
 	{
-		self->v.movetype = MOVETYPE_NONE;
+		ED_SetMovetype(self, MOVETYPE_NONE);
 		zombie_cruc1(self);
 	}
 	else
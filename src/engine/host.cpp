@@ -293,6 +293,7 @@ void SV_BroadcastPrintf(const char* fmt, ...)
 	va_list		argptr;
 	char		string[1024];
 	int			i;
+	sizebuf_t* demo;
 
 	va_start(argptr, fmt);
 	vsprintf(string, fmt, argptr);
@@ -304,6 +305,13 @@ void SV_BroadcastPrintf(const char* fmt, ...)
 			MSG_WriteByte(&svs.clients[i].message, svc_print);
 			MSG_WriteString(&svs.clients[i].message, string);
 		}
+
+	demo = SV_DemoReliable();
+	if (demo)
+	{
+		MSG_WriteByte(demo, svc_print);
+		MSG_WriteString(demo, string);
+	}
 }
 
 /*
@@ -398,48 +406,39 @@ void Host_ShutdownServer(bool crash)
 	int		count;
 	sizebuf_t	buf;
 	char		message[4];
-	double	start;
 
 	if (!sv.active)
 		return;
 
 	sv.active = false;
 
+	SV_StopDemo();
+
+	// an error may have interrupted parsing a client message in place
+	g_Networking->ReleaseMessage();
+
 	// stop all client sounds immediately
 	if (cls.state == ca_connected)
 		CL_Disconnect();
 
 	// flush any pending messages - like the score!!!
-	start = Sys_FloatTime();
-	do
+	// nothing waits for delivery, closed connections finish sending in the background
+	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
-		count = 0;
-		for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
+		if (host_client->active && host_client->message.cursize
+			&& g_Networking->CanSendMessage(host_client->netconnection))
 		{
-			if (host_client->active && host_client->message.cursize)
-			{
-				if (g_Networking->CanSendMessage(host_client->netconnection))
-				{
-					g_Networking->SendMessage(host_client->netconnection, &host_client->message);
-					SZ_Clear(&host_client->message);
-				}
-				else
-				{
-					g_Networking->GetMessage(host_client->netconnection);
-					count++;
-				}
-			}
+			g_Networking->SendMessage(host_client->netconnection, &host_client->message);
+			SZ_Clear(&host_client->message);
 		}
-		if ((Sys_FloatTime() - start) > 3.0)
-			break;
-	} while (count);
+	}
 
 	// make sure all the clients know we're disconnecting
 	buf.data = reinterpret_cast<byte*>(message);
 	buf.maxsize = 4;
 	buf.cursize = 0;
 	MSG_WriteByte(&buf, svc_disconnect);
-	count = g_Networking->SendToAll(&buf, 5);
+	count = g_Networking->SendToAll(&buf);
 	if (count)
 		Con_Printf("Host_ShutdownServer: NET_SendToAll failed for %u clients\n", count);
 
@@ -491,7 +490,8 @@ bool Host_FilterTime(float time)
 {
 	realtime += time;
 
-	if (!cls.timedemo && realtime - oldrealtime < 1.0 / 72.0)
+	// dedicated servers are paced by Tick_Wait
+	if (!cls.timedemo && !isDedicated && realtime - oldrealtime < 1.0 / 72.0)
 		return false;		// framerate is too high
 
 	host_frametime = realtime - oldrealtime;
@@ -542,22 +542,31 @@ Host_ServerFrame
 
 void _Host_ServerFrame(void)
 {
+	long long	start;
+
 	// run the world state	
 	pr_global_struct->frametime = host_frametime;
 
 	// read client messages
+	start = SV_ProfTime();
 	SV_RunClients();
+	SV_ProfEnd(PROF_RUNCLIENTS, start);
 
 	// move things around and think
 	// always pause in single player if in console or menus
 	if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game))
+	{
+		start = SV_ProfTime();
 		SV_Physics();
+		SV_ProfEnd(PROF_PHYSICS, start);
+	}
 }
 
 void Host_ServerFrame(void)
 {
 	float	save_host_frametime;
 	float	temp_host_frametime;
+	long long	start;
 
 	// run the world state	
 	pr_global_struct->frametime = host_frametime;
@@ -581,13 +590,17 @@ void Host_ServerFrame(void)
 	host_frametime = save_host_frametime;
 
 	// send all messages to the clients
+	start = SV_ProfTime();
 	SV_SendClientMessages();
+	SV_ProfEnd(PROF_SENDMESSAGES, start);
 }
 
 #else
 
 void Host_ServerFrame(void)
 {
+	long long	start;
+
 	// run the world state	
 	pr_global_struct->frametime = host_frametime;
 
@@ -598,15 +611,23 @@ void Host_ServerFrame(void)
 	//SV_CheckForNewClients();
 
 	// read client messages
+	start = SV_ProfTime();
 	SV_RunClients();
+	SV_ProfEnd(PROF_RUNCLIENTS, start);
 
 	// move things around and think
 	// always pause in single player if in console or menus
 	if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game))
+	{
+		start = SV_ProfTime();
 		SV_Physics();
+		SV_ProfEnd(PROF_PHYSICS, start);
+	}
 
 	// send all messages to the clients
+	start = SV_ProfTime();
 	SV_SendClientMessages();
+	SV_ProfEnd(PROF_SENDMESSAGES, start);
 }
 
 #endif
@@ -625,6 +646,7 @@ void _Host_Frame(float time)
 	static double		time2 = 0;
 	static double		time3 = 0;
 	int			pass1, pass2, pass3;
+	long long	networkstart;
 
 	if (setjmp(host_abortserver))
 		return;			// something bad happened, or the server disconnected
@@ -636,6 +658,9 @@ void _Host_Frame(float time)
 	if (!Host_FilterTime(time))
 		return;			// don't run too fast, or packets will flood out
 
+	// everything the last frame put in scratch memory is done with
+	Scratch_EndFrame();
+
 // get new key events
 	Sys_SendKeyEvents();
 
@@ -645,7 +670,11 @@ void _Host_Frame(float time)
 	// process console commands
 	Cbuf_Execute();
 
+	SV_ProfBeginTick();
+
+	networkstart = SV_ProfTime();
 	g_Networking->RunFrame();
+	SV_ProfEnd(PROF_NETWORK, networkstart);
 
 	// if running the server locally, make intentions now
 	if (sv.active)
@@ -663,6 +692,8 @@ void _Host_Frame(float time)
 	if (sv.active)
 		Host_ServerFrame();
 
+	SV_ProfEndTick();
+
 	//-------------------
 	//
 	// client operations
@@ -775,19 +806,23 @@ void Host_Init(quakeparms_t* parms)
 	com_argc = parms->argc;
 	com_argv = parms->argv;
 
-	Memory_Init(parms->membase, parms->memsize);
+	Memory_Init(parms->memsize);
 	Cbuf_Init();
 	Cmd_Init();
 	V_Init();
 	Chase_Init();
 	COM_Init(parms->basedir);
 	Host_InitLocal();
+	Jobs_Init();
+	Tick_Init();
 	W_LoadWadFile("gfx.wad");
 	Key_Init();
 	Con_Init();
 	M_Init();
 	PR_Init();
 	Mod_Init();
+	ModCache_Init();
+	DataCache_Init();
 	NET_Init();
 	SV_Init();
 	g_Game->Initialize();
@@ -864,6 +899,7 @@ void Host_Shutdown(void)
 	g_Game->Shutdown();
 	CDAudio_Shutdown();
 	NET_Shutdown();
+	Jobs_Shutdown();
 	S_Shutdown();
 	IN_Shutdown();
 
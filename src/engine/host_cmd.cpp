@@ -160,13 +160,13 @@ void Host_Noclip_f(void)
 	if (sv_player->v.movetype != MOVETYPE_NOCLIP)
 	{
 		noclip_anglehack = true;
-		sv_player->v.movetype = MOVETYPE_NOCLIP;
+		ED_SetMovetype(sv_player, MOVETYPE_NOCLIP);
 		SV_ClientPrintf("noclip ON\n");
 	}
 	else
 	{
 		noclip_anglehack = false;
-		sv_player->v.movetype = MOVETYPE_WALK;
+		ED_SetMovetype(sv_player, MOVETYPE_WALK);
 		SV_ClientPrintf("noclip OFF\n");
 	}
 }
@@ -191,12 +191,12 @@ void Host_Fly_f(void)
 
 	if (sv_player->v.movetype != MOVETYPE_FLY)
 	{
-		sv_player->v.movetype = MOVETYPE_FLY;
+		ED_SetMovetype(sv_player, MOVETYPE_FLY);
 		SV_ClientPrintf("flymode ON\n");
 	}
 	else
 	{
-		sv_player->v.movetype = MOVETYPE_WALK;
+		ED_SetMovetype(sv_player, MOVETYPE_WALK);
 		SV_ClientPrintf("flymode OFF\n");
 	}
 }
@@ -677,9 +677,9 @@ void Host_Loadgame_f(void)
 		else
 		{	// parse an edict
 
+			ED_ReserveEdicts(entnum + 1);
 			ent = EDICT_NUM(entnum);
-			memset(&ent->v, 0, sizeof(entvars_t));
-			ent->free = false;
+			ED_ClearEdict(ent);
 			ED_ParseEdict(start, ent);
 
 			// link it into the bsp tree
@@ -840,9 +840,9 @@ int LoadGamestate(char* level, char* startspot)
 
 		// parse an edict
 
+		ED_ReserveEdicts(entnum + 1);
 		ent = EDICT_NUM(entnum);
-		memset(&ent->v, 0, sizeof(entvars_t));
-		ent->free = false;
+		ED_ClearEdict(ent);
 		ED_ParseEdict(start, ent);
 
 		// link it into the bsp tree
@@ -1208,6 +1208,36 @@ void Host_Pause_f(void)
 //===========================================================================
 
 
+/*
+==================
+Host_Protocol_f
+
+Sent by clients during signon with the highest protocol they understand
+==================
+*/
+void Host_Protocol_f(void)
+{
+	int		protocol;
+
+	if (cmd_source == src_command)
+	{
+		Con_Printf("protocol is not valid from the console\n");
+		return;
+	}
+
+	if (Cmd_Argc() != 2 || host_client->spawned)
+		return;
+
+	protocol = Q_atoi(Cmd_Argv(1));
+	if (protocol >= PROTOCOL_DELTA && sv_protocol.value >= PROTOCOL_DELTA)
+		host_client->protocol = PROTOCOL_DELTA;
+	else
+		host_client->protocol = PROTOCOL_VERSION;
+
+	MSG_WriteByte(&host_client->message, svc_version);
+	MSG_WriteLong(&host_client->message, host_client->protocol);
+}
+
 /*
 ==================
 Host_PreSpawn_f
@@ -1241,7 +1271,6 @@ Host_Spawn_f
 void Host_Spawn_f(void)
 {
 	int		i;
-	client_t* client;
 	edict_t* ent;
 
 	if (cmd_source == src_command)
@@ -1267,7 +1296,7 @@ void Host_Spawn_f(void)
 		// set up the edict
 		ent = host_client->edict;
 
-		memset(&ent->v, 0, sizeof(entvars_t));
+		ED_ClearEdict(ent);
 		ent->v.colormap = NUM_FOR_EDICT(ent);
 		ent->v.team = (host_client->colors & 15) + 1;
 		ent->v.netname = host_client->name;
@@ -1296,46 +1325,7 @@ void Host_Spawn_f(void)
 	MSG_WriteByte(&host_client->message, svc_time);
 	MSG_WriteFloat(&host_client->message, sv.time);
 
-	for (i = 0, client = svs.clients; i < svs.maxclients; i++, client++)
-	{
-		MSG_WriteByte(&host_client->message, svc_updatename);
-		MSG_WriteByte(&host_client->message, i);
-		MSG_WriteString(&host_client->message, client->name);
-		MSG_WriteByte(&host_client->message, svc_updatefrags);
-		MSG_WriteByte(&host_client->message, i);
-		MSG_WriteShort(&host_client->message, client->old_frags);
-		MSG_WriteByte(&host_client->message, svc_updatecolors);
-		MSG_WriteByte(&host_client->message, i);
-		MSG_WriteByte(&host_client->message, client->colors);
-	}
-
-	// send all current light styles
-	for (i = 0; i < MAX_LIGHTSTYLES; i++)
-	{
-		MSG_WriteByte(&host_client->message, svc_lightstyle);
-		MSG_WriteByte(&host_client->message, (char)i);
-		MSG_WriteString(&host_client->message, sv.lightstyles[i]);
-	}
-
-	//
-	// send some stats
-	//
-	MSG_WriteByte(&host_client->message, svc_updatestat);
-	MSG_WriteByte(&host_client->message, STAT_TOTALSECRETS);
-	MSG_WriteLong(&host_client->message, pr_global_struct->total_secrets);
-
-	MSG_WriteByte(&host_client->message, svc_updatestat);
-	MSG_WriteByte(&host_client->message, STAT_TOTALMONSTERS);
-	MSG_WriteLong(&host_client->message, pr_global_struct->total_monsters);
-
-	MSG_WriteByte(&host_client->message, svc_updatestat);
-	MSG_WriteByte(&host_client->message, STAT_SECRETS);
-	MSG_WriteLong(&host_client->message, pr_global_struct->found_secrets);
-
-	MSG_WriteByte(&host_client->message, svc_updatestat);
-	MSG_WriteByte(&host_client->message, STAT_MONSTERS);
-	MSG_WriteLong(&host_client->message, pr_global_struct->killed_monsters);
-
+	SV_WriteGameState(&host_client->message);
 
 	//
 	// send a fixangle
@@ -1862,6 +1852,7 @@ void Host_InitCommands(void)
 	Cmd_AddCommand("spawn", Host_Spawn_f);
 	Cmd_AddCommand("begin", Host_Begin_f);
 	Cmd_AddCommand("prespawn", Host_PreSpawn_f);
+	Cmd_AddCommand("protocol", Host_Protocol_f);
 	Cmd_AddCommand("kick", Host_Kick_f);
 	Cmd_AddCommand("ping", Host_Ping_f);
 	Cmd_AddCommand("load", Host_Loadgame_f);
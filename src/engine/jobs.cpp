@@ -0,0 +1,191 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* jobs.c -- persistent worker threads for data parallel engine work */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "quakedef.h"
+
+#define	MAX_JOB_WORKERS	15
+
+static std::vector<std::thread>	jobs_workers;
+static std::mutex				jobs_mutex;
+static std::condition_variable	jobs_wake;		// workers wait for a new batch
+static std::condition_variable	jobs_done;		// the caller waits for the workers
+
+// the batch currently being run, protected by jobs_mutex
+static const std::function<void(int)>* jobs_func;
+static int			jobs_count;
+static int			jobs_active;		// workers that haven't finished the batch
+static unsigned		jobs_generation;
+static bool			jobs_quit;
+
+static std::atomic<int>	jobs_next;		// next index to hand out
+
+static thread_local bool	jobs_isworker;
+
+/*
+================
+Jobs_RunBatch
+
+Takes indices until the batch is exhausted
+================
+*/
+static void Jobs_RunBatch(const std::function<void(int)>& func, int count)
+{
+	int		i;
+
+	while ((i = jobs_next.fetch_add(1, std::memory_order_relaxed)) < count)
+		func(i);
+}
+
+/*
+================
+Jobs_WorkerLoop
+================
+*/
+static void Jobs_WorkerLoop(void)
+{
+	unsigned	generation = 0;
+	const std::function<void(int)>* func;
+	int			count;
+
+	jobs_isworker = true;
+
+	std::unique_lock<std::mutex> lock(jobs_mutex);
+
+	while (1)
+	{
+		jobs_wake.wait(lock, [&] { return jobs_quit || jobs_generation != generation; });
+
+		if (jobs_quit)
+			return;
+
+		generation = jobs_generation;
+		func = jobs_func;
+		count = jobs_count;
+
+		lock.unlock();
+		Jobs_RunBatch(*func, count);
+		Scratch_EndJob();
+		lock.lock();
+
+		// the caller can't start another batch until every worker has checked in,
+		// so no worker can skip a generation
+		if (--jobs_active == 0)
+			jobs_done.notify_one();
+	}
+}
+
+/*
+================
+Jobs_Init
+
+Starts one worker per spare hardware thread, or the number given with -jobs
+================
+*/
+void Jobs_Init(void)
+{
+	int		i, count;
+
+	i = COM_CheckParm("-jobs");
+	if (i && i < com_argc - 1)
+		count = Q_atoi(com_argv[i + 1]);
+	else
+		count = (int)std::thread::hardware_concurrency() - 1;
+
+	count = std::clamp(count, 0, MAX_JOB_WORKERS);
+
+	jobs_quit = false;
+	for (i = 0; i < count; i++)
+		jobs_workers.emplace_back(Jobs_WorkerLoop);
+
+	Con_Printf("%i job workers\n", count);
+}
+
+/*
+================
+Jobs_Shutdown
+================
+*/
+void Jobs_Shutdown(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobs_mutex);
+		jobs_quit = true;
+	}
+	jobs_wake.notify_all();
+
+	for (auto& worker : jobs_workers)
+		worker.join();
+
+	jobs_workers.clear();
+}
+
+/*
+================
+Jobs_NumWorkers
+================
+*/
+int Jobs_NumWorkers(void)
+{
+	return (int)jobs_workers.size();
+}
+
+/*
+================
+Jobs_ParallelFor
+================
+*/
+void Jobs_ParallelFor(int count, const std::function<void(int)>& func)
+{
+	int		i;
+
+	if (count <= 0)
+		return;
+
+	if (count == 1 || jobs_workers.empty() || jobs_isworker)
+	{
+		for (i = 0; i < count; i++)
+			func(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(jobs_mutex);
+
+	jobs_func = &func;
+	jobs_count = count;
+	jobs_active = (int)jobs_workers.size();
+	jobs_next.store(0, std::memory_order_relaxed);
+	jobs_generation++;
+
+	lock.unlock();
+	jobs_wake.notify_all();
+
+	Jobs_RunBatch(func, count);
+
+	lock.lock();
+	jobs_done.wait(lock, [] { return jobs_active == 0; });
+}
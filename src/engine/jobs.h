@@ -0,0 +1,35 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* jobs.h -- persistent worker threads for data parallel engine work */
+
+#pragma once
+
+#include <functional>
+
+void Jobs_Init(void);
+void Jobs_Shutdown(void);
+
+int Jobs_NumWorkers(void);
+
+// Calls func(i) for every i in [0, count) on the workers and the calling
+// thread, and returns once all of them have finished.  Jobs must not touch
+// shared engine state, print, or call Host_Error / Sys_Error.  Calls made
+// from inside a job run serially on that worker.
+void Jobs_ParallelFor(int count, const std::function<void(int)>& func);
@@ -0,0 +1,269 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* modcache.c -- parsed brush models kept across map changes */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "quakedef.h"
+
+// Brush models normally live on the hunk and are parsed again on every map
+// spawn, because Host_ClearMemory frees the hunk back to host_hunklevel.  A
+// dedicated server renders nothing, so the parsed world never changes after
+// loading and can be kept outside the hunk and handed out again whenever the
+// same file is loaded.
+
+cvar_t	mod_cachemaps = {"mod_cachemaps", "4"};	// unused maps kept, 0 disables the cache
+
+model_t* Mod_FindName(const char* name);
+
+#define	MODCACHE_BLOCK	(1024 * 1024)
+
+typedef struct
+{
+	char		name[MAX_QPATH];
+	int			length;
+	unsigned short	checksum;
+
+	int			refcount;		// held by the models in use since the last Mod_ClearAll
+	int			lastused;
+
+	std::vector<model_t>	models;		// the world, then *1, *2...
+
+	std::vector<std::unique_ptr<byte[]>>	blocks;
+	int			blockused, blocksize;
+	int			bytes;
+} modcache_t;
+
+static std::vector<std::unique_ptr<modcache_t>>	modcache;
+static std::vector<modcache_t*>	modcache_held;
+static int			modcache_sequence;
+
+static modcache_t*	modcache_loading;
+static modcache_t	modcache_pending;	// key of the file being looked up
+
+/*
+================
+ModCache_Enabled
+================
+*/
+static bool ModCache_Enabled(void)
+{
+	return cls.state == ca_dedicated && mod_cachemaps.value > 0;
+}
+
+/*
+================
+ModCache_Alloc
+
+Hunk_AllocName replacement while a brush model is loading
+================
+*/
+static void* ModCache_Alloc(int size)
+{
+	modcache_t* entry = modcache_loading;
+
+	size = (size + 15) & ~15;
+
+	if (entry->blocks.empty() || entry->blockused + size > entry->blocksize)
+	{
+		entry->blocksize = std::max(size, MODCACHE_BLOCK);
+		entry->blocks.emplace_back(new byte[entry->blocksize]());
+		entry->blockused = 0;
+	}
+
+	byte* data = entry->blocks.back().get() + entry->blockused;
+	entry->blockused += size;
+	entry->bytes += size;
+
+	return data;
+}
+
+/*
+================
+ModCache_Hold
+================
+*/
+static void ModCache_Hold(modcache_t* entry)
+{
+	entry->refcount++;
+	entry->lastused = ++modcache_sequence;
+	modcache_held.push_back(entry);
+}
+
+/*
+================
+ModCache_Restore
+================
+*/
+bool ModCache_Restore(model_t* mod, const byte* buf, int length)
+{
+	unsigned short	crc;
+	int		i;
+
+	if (!ModCache_Enabled())
+		return false;
+
+	CRC_Init(&crc);
+	for (i = 0; i < length; i++)
+		CRC_ProcessByte(&crc, buf[i]);
+
+	Q_strncpy(modcache_pending.name, mod->name, sizeof(modcache_pending.name) - 1);
+	modcache_pending.length = length;
+	modcache_pending.checksum = CRC_Value(crc);
+
+	for (auto& entry : modcache)
+	{
+		if (entry->length != modcache_pending.length
+			|| entry->checksum != modcache_pending.checksum
+			|| strcmp(entry->name, modcache_pending.name))
+			continue;
+
+		*mod = entry->models[0];
+
+		for (i = 1; i < (int)entry->models.size(); i++)
+			*Mod_FindName(entry->models[i].name) = entry->models[i];
+
+		ModCache_Hold(entry.get());
+		Con_DPrintf("%s reused from the model cache\n", mod->name);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+================
+ModCache_BeginLoad
+================
+*/
+void ModCache_BeginLoad(void)
+{
+	if (!ModCache_Enabled())
+		return;
+
+	auto entry = std::make_unique<modcache_t>();
+
+	strcpy(entry->name, modcache_pending.name);
+	entry->length = modcache_pending.length;
+	entry->checksum = modcache_pending.checksum;
+
+	modcache_loading = entry.get();
+	modcache.push_back(std::move(entry));
+
+	Hunk_SetExternal(ModCache_Alloc);
+}
+
+/*
+================
+ModCache_EndLoad
+================
+*/
+void ModCache_EndLoad(model_t* mod)
+{
+	modcache_t* entry = modcache_loading;
+	char		name[10];
+	int			i;
+
+	if (!entry)
+		return;
+
+	Hunk_SetExternal(NULL);
+	modcache_loading = NULL;
+
+	// Mod_LoadBrushModel has copied the world into a mod_known entry per submodel
+	entry->models.push_back(*mod);
+
+	for (i = 1; i < mod->numsubmodels; i++)
+	{
+		sprintf(name, "*%i", i);
+		entry->models.push_back(*Mod_FindName(name));
+	}
+
+	ModCache_Hold(entry);
+}
+
+/*
+================
+ModCache_Release
+================
+*/
+void ModCache_Release(void)
+{
+	std::vector<modcache_t*>	unused;
+
+	for (auto entry : modcache_held)
+		entry->refcount--;
+	modcache_held.clear();
+
+	for (auto& entry : modcache)
+	{
+		if (!entry->refcount)
+			unused.push_back(entry.get());
+	}
+
+	const size_t keep = (size_t)std::max(mod_cachemaps.value, 0.f);
+
+	if (unused.size() <= keep)
+		return;
+
+	// oldest first
+	std::sort(unused.begin(), unused.end(), [](const modcache_t* a, const modcache_t* b)
+		{
+			return a->lastused < b->lastused;
+		});
+
+	unused.resize(unused.size() - keep);
+
+	modcache.erase(std::remove_if(modcache.begin(), modcache.end(), [&](const std::unique_ptr<modcache_t>& entry)
+		{
+			return std::find(unused.begin(), unused.end(), entry.get()) != unused.end();
+		}), modcache.end());
+}
+
+/*
+================
+ModCache_List_f
+================
+*/
+static void ModCache_List_f(void)
+{
+	int		total = 0;
+
+	for (auto& entry : modcache)
+	{
+		Con_Printf("%8i %3i %s%s\n", entry->bytes, (int)entry->models.size(), entry->name, entry->refcount ? " (in use)" : "");
+		total += entry->bytes;
+	}
+
+	Con_Printf("%i cached maps, %i bytes\n", (int)modcache.size(), total);
+}
+
+/*
+================
+ModCache_Init
+================
+*/
+void ModCache_Init(void)
+{
+	Cvar_RegisterVariable(&mod_cachemaps);
+	Cmd_AddCommand("modcachelist", ModCache_List_f);
+}
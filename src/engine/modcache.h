@@ -0,0 +1,36 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* modcache.h -- parsed brush models kept across map changes */
+
+void ModCache_Init(void);
+
+// Called by Mod_LoadModel with the file contents before a brush model is
+// parsed.  Returns true if the same file is cached, in which case the world
+// and its submodels have been copied back into mod_known.
+bool ModCache_Restore(model_t* mod, const byte* buf, int length);
+
+// Bracket Mod_LoadBrushModel after a failed ModCache_Restore.  Everything the
+// loader allocates in between goes into a cache entry instead of the hunk.
+void ModCache_BeginLoad(void);
+void ModCache_EndLoad(model_t* mod);
+
+// Called by Mod_ClearAll.  Drops the references held by the models that were
+// in use, and frees the least recently used maps beyond mod_cachemaps.
+void ModCache_Release(void);
@@ -19,15 +19,38 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <memory>
 
 #include <steam/isteamnetworkingutils.h>
 
 #include "quakedef.h"
 #include "CGNSNetSystem.h"
+#include "CLoopbackChannel.h"
 
 void SV_NewClient(qsocket_t* newClient);
 
+// number of messages fetched from the poll group per library call
+#define NET_RECEIVEBATCH	64
+
+// seconds a closed connection gets to deliver the rest of its reliable data
+#define NET_LINGERTIME		5
+
+// longest the service thread blocks in the library at once, milliseconds
+#define NET_SERVICEWAIT		100
+
+/**
+*	@brief Data queued for several connections at once, freed when the last message using it is
+*/
+struct sharedmessage_t
+{
+	std::atomic<int> refcount;
+	int size;
+	byte data[1];
+};
+
 static void DebugOutput(ESteamNetworkingSocketsDebugOutputType eType, const char* pszMsg)
 {
 	Con_Printf("%s\n", pszMsg);
@@ -37,6 +60,10 @@ CGNSNetSystem::CGNSNetSystem()
 {
 	s_pCallbackInstance = this;
 
+	// must be chosen before the library starts its own service thread
+	if (isDedicated)
+		SteamNetworkingSockets_SetManualPollMode(true);
+
 	SteamNetworkingErrMsg error;
 	if (!GameNetworkingSockets_Init(nullptr, error))
 	{
@@ -45,21 +72,57 @@ CGNSNetSystem::CGNSNetSystem()
 
 	m_GNSInterface = SteamNetworkingSockets();
 
+	m_PollGroup = m_GNSInterface->CreatePollGroup();
+
 	SteamNetworkingUtils()->SetDebugOutputFunction(k_ESteamNetworkingSocketsDebugOutputType_Msg, &DebugOutput);
+
+	if (isDedicated)
+		m_ServiceThread = std::thread(&CGNSNetSystem::ServiceThread, this);
 }
 
 CGNSNetSystem::~CGNSNetSystem()
 {
 	if (m_GNSInterface)
 	{
+		ReleaseMessage();
+
+		for (auto message : m_SendQueue)
+		{
+			message->Release();
+		}
+
+		m_SendQueue.clear();
+		m_SendQueueInfo.clear();
+
+		EndSharedMessage();
+
 		for (auto& conn : m_Connections)
 		{
-			m_GNSInterface->CloseConnection(conn->connection, k_ESteamNetConnectionEnd_App_Generic, "Shutting down", false);
+			ReleasePending(conn.get());
+
+			if (!conn->loopback)
+				m_GNSInterface->CloseConnection(conn->connection, k_ESteamNetConnectionEnd_App_Generic, "Shutting down", false);
 		}
 
 		m_Connections.clear();
 
+		for (auto& linger : m_Lingering)
+		{
+			m_GNSInterface->CloseConnection(linger.connection, k_ESteamNetConnectionEnd_App_Generic, "Shutting down", false);
+		}
+
+		m_Lingering.clear();
+
 		CloseSocket();
+
+		m_GNSInterface->DestroyPollGroup(m_PollGroup);
+		m_PollGroup = k_HSteamNetPollGroup_Invalid;
+	}
+
+	if (m_ServiceThread.joinable())
+	{
+		m_StopService = true;
+		m_ServiceThread.join();
 	}
 
 	GameNetworkingSockets_Kill();
@@ -67,6 +130,22 @@ CGNSNetSystem::~CGNSNetSystem()
 	s_pCallbackInstance = nullptr;
 }
 
+void CGNSNetSystem::ServiceThread()
+{
+	while (!m_StopService)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		// processes whatever arrives on the sockets and runs the library's timers
+		SteamNetworkingSockets_Poll(NET_SERVICEWAIT);
+
+		// returning before the wait was up means a packet came in or a timer ran, either may
+		// have queued a message, Tick_Wait checks and goes back to sleep if not
+		if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(NET_SERVICEWAIT))
+			Tick_Wake();
+	}
+}
+
 void CGNSNetSystem::SetPort(std::uint16_t port)
 {
 	m_Port = port;
@@ -113,6 +192,16 @@ qsocket_t* CGNSNetSystem::Connect(const char* host)
 	if (!host)
 		return nullptr;
 
+	// Local clients talk to the server through a pair of ring buffers, -gnsloopback uses a library socket pair instead
+	if (0 == strcmp(host, "local") && !COM_CheckParm("-gnsloopback"))
+	{
+		// Start server if needed.
+		Listen();
+
+		// Let the server finish connection at the same time a remote connection comes in.
+		return ConnectLoopback(&m_PendingServerLoopbackSocket);
+	}
+
 	// Create a loopback connection for local hosts.
 	if (0 == strcmp(host, "local"))
 	{
@@ -144,6 +233,8 @@ qsocket_t* CGNSNetSystem::Connect(const char* host)
 
 		m_Connections.push_back(std::move(serverSocket));
 
+		AddToPollGroup(m_Connections.back().get());
+
 		// Let the server finish connection at the same time a remote connection comes in.
 		m_PendingServerLoopbackSocket = m_Connections.back().get();
 
@@ -177,6 +268,36 @@ qsocket_t* CGNSNetSystem::Connect(const char* host)
 	return m_Connections.back().get();
 }
 
+qsocket_t* CGNSNetSystem::ConnectLoopback(qsocket_t** server)
+{
+	SetNetTime();
+
+	auto loopback = std::make_shared<loopback_t>();
+
+	auto clientSocket = std::make_unique<qsocket_t>();
+
+	clientSocket->connecttime = net_time;
+	clientSocket->address = "local";
+	clientSocket->loopback = loopback;
+
+	m_Connections.push_back(std::move(clientSocket));
+
+	auto returnSocket = m_Connections.back().get();
+
+	auto serverSocket = std::make_unique<qsocket_t>();
+
+	serverSocket->connecttime = net_time;
+	serverSocket->address = "local";
+	serverSocket->loopback = loopback;
+	serverSocket->loopbackserver = true;
+
+	m_Connections.push_back(std::move(serverSocket));
+
+	*server = m_Connections.back().get();
+
+	return returnSocket;
+}
+
 bool CGNSNetSystem::CanSendMessage(qsocket_t* conn)
 {
 	if (!conn)
@@ -193,9 +314,33 @@ bool CGNSNetSystem::CanSendMessage(qsocket_t* conn)
 
 int CGNSNetSystem::GetMessage(qsocket_t* conn)
 {
+	ReleaseMessage();
+
 	if (!conn)
 		return -1;
 
+	if (conn->loopback)
+	{
+		auto& channel = conn->loopbackserver ? conn->loopback->toserver : conn->loopback->toclient;
+
+		SetNetTime();
+
+		// messages sent before the other end closed are still delivered
+		const int ret = channel.Read(&net_message);
+
+		if (ret == 1)
+			messagesReceived++;
+		else if (ret == 2)
+			unreliableMessagesReceived++;
+		else if (conn->loopback->closed)
+		{
+			Con_Printf("NET_GetMessage: disconnected socket\n");
+			return -1;
+		}
+
+		return ret;
+	}
+
 	if (!IsValidConnection(conn))
 	{
 		Con_Printf("NET_GetMessage: disconnected socket\n");
@@ -205,13 +350,47 @@ int CGNSNetSystem::GetMessage(qsocket_t* conn)
 	SetNetTime();
 
 	SteamNetworkingMessage_t* message = nullptr;
-	int ret = m_GNSInterface->ReceiveMessagesOnConnection(conn->connection, &message, 1);
+	int ret;
 
-	if (ret > 0)
+	if (conn->pollgroup)
 	{
-		SZ_Clear(&net_message);
-		SZ_Write(&net_message, message->GetData(), message->GetSize());
+		// Received by ReceiveMessages, read it in place
+		if (conn->pending.empty())
+			return 0;
 
+		message = conn->pending.front();
+		conn->pending.pop_front();
+
+		if (message->GetSize() > NET_MAXMESSAGE)
+		{
+			Con_Printf("NET_GetMessage: oversize message from %s\n", conn->address.c_str());
+			message->Release();
+			return -1;
+		}
+
+		m_HeldMessage = message;
+		m_NetMessageData = net_message.data;
+		m_NetMessageSize = net_message.maxsize;
+
+		net_message.data = static_cast<byte*>(message->m_pData);
+		net_message.maxsize = message->GetSize();
+		net_message.cursize = message->GetSize();
+
+		ret = 1;
+	}
+	else
+	{
+		ret = m_GNSInterface->ReceiveMessagesOnConnection(conn->connection, &message, 1);
+
+		if (ret > 0)
+		{
+			SZ_Clear(&net_message);
+			SZ_Write(&net_message, message->GetData(), message->GetSize());
+		}
+	}
+
+	if (ret > 0)
+	{
 		ret = (message->m_nFlags & k_nSteamNetworkingSend_Reliable) != 0 ? 1 : 2;
 
 		if (ret == 1)
@@ -220,7 +399,7 @@ int CGNSNetSystem::GetMessage(qsocket_t* conn)
 			unreliableMessagesReceived++;
 	}
 
-	if (message)
+	if (message && message != m_HeldMessage)
 	{
 		message->Release();
 	}
@@ -228,6 +407,62 @@ int CGNSNetSystem::GetMessage(qsocket_t* conn)
 	return ret;
 }
 
+void CGNSNetSystem::ReceiveMessages()
+{
+	SteamNetworkingMessage_t* messages[NET_RECEIVEBATCH];
+	int count;
+
+	SetNetTime();
+
+	do
+	{
+		count = m_GNSInterface->ReceiveMessagesOnPollGroup(m_PollGroup, messages, NET_RECEIVEBATCH);
+
+		for (int i = 0; i < count; ++i)
+		{
+			auto message = messages[i];
+			// Connection user data is the owning qsocket_t, set by AddToPollGroup
+			if (message->m_nConnUserData == -1)
+			{
+				message->Release();
+				continue;
+			}
+
+			reinterpret_cast<qsocket_t*>(static_cast<intptr_t>(message->m_nConnUserData))->pending.push_back(message);
+		}
+	} while (count == NET_RECEIVEBATCH);
+}
+
+bool CGNSNetSystem::MessagesWaiting()
+{
+	// queue whatever arrived, GetMessage hands it out in order later
+	ReceiveMessages();
+
+	for (const auto& conn : m_Connections)
+	{
+		if (!conn->pending.empty())
+			return true;
+
+		if (conn->loopbackserver && !conn->loopback->toserver.Empty())
+			return true;
+	}
+
+	return false;
+}
+
+void CGNSNetSystem::ReleaseMessage()
+{
+	if (!m_HeldMessage)
+		return;
+
+	net_message.data = m_NetMessageData;
+	net_message.maxsize = m_NetMessageSize;
+	net_message.cursize = 0;
+
+	m_HeldMessage->Release();
+	m_HeldMessage = nullptr;
+}
+
 int CGNSNetSystem::SendMessage(qsocket_t* conn, sizebuf_t* data)
 {
 	if (!conn)
@@ -240,6 +475,10 @@ int CGNSNetSystem::SendMessage(qsocket_t* conn, sizebuf_t* data)
 	}
 
 	SetNetTime();
+
+	if (conn->loopback)
+		return LoopbackSend(conn, data->data, data->cursize, true);
+
 	const int r = m_GNSInterface->SendMessageToConnection(
 		conn->connection,
 		data->data,
@@ -264,6 +503,10 @@ int CGNSNetSystem::SendUnreliableMessage(qsocket_t* conn, sizebuf_t* data)
 	}
 
 	SetNetTime();
+
+	if (conn->loopback)
+		return LoopbackSend(conn, data->data, data->cursize, false);
+
 	const int r = m_GNSInterface->SendMessageToConnection(
 		conn->connection,
 		data->data,
@@ -276,79 +519,236 @@ int CGNSNetSystem::SendUnreliableMessage(qsocket_t* conn, sizebuf_t* data)
 	return r;
 }
 
-int CGNSNetSystem::SendToAll(sizebuf_t* data, int blocktime)
+void CGNSNetSystem::AllocateMessage(netmessage_t* msg, int maxsize)
 {
-	int			i;
-	int			count = 0;
-	bool		state1[MAX_SCOREBOARD];
-	bool		state2[MAX_SCOREBOARD];
+	FreeMessage(msg);
 
-	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
+	msg->message = SteamNetworkingUtils()->AllocateMessage(maxsize);
+
+	msg->buf.data = static_cast<byte*>(msg->message->m_pData);
+	msg->buf.maxsize = maxsize;
+	msg->buf.cursize = 0;
+	msg->buf.allowoverflow = false;
+	msg->buf.overflowed = false;
+}
+
+void CGNSNetSystem::FreeMessage(netmessage_t* msg)
+{
+	if (msg->message)
 	{
-		if (!host_client->netconnection)
-			continue;
-		if (host_client->active)
+		msg->message->Release();
+		msg->message = nullptr;
+	}
+
+	msg->buf.data = nullptr;
+	msg->buf.maxsize = 0;
+	msg->buf.cursize = 0;
+}
+
+void CGNSNetSystem::QueueMessage(qsocket_t* conn, netmessage_t* msg, bool reliable)
+{
+	auto message = msg->message;
+
+	msg->message = nullptr;
+	msg->buf.data = nullptr;
+	msg->buf.maxsize = 0;
+
+	if (!message)
+		return;
+
+	// the buffer may be larger than what was written
+	message->m_cbSize = msg->buf.cursize;
+	msg->buf.cursize = 0;
+
+	if (!conn)
+	{
+		message->Release();
+		return;
+	}
+
+	Enqueue(conn, message, reliable);
+}
+
+void CGNSNetSystem::BeginSharedMessage(const sizebuf_t* data)
+{
+	EndSharedMessage();
+
+	m_SharedMessage = static_cast<sharedmessage_t*>(malloc(offsetof(sharedmessage_t, data) + data->cursize));
+
+	if (!m_SharedMessage)
+		Sys_Error("BeginSharedMessage: out of memory");
+
+	// the reference held until EndSharedMessage
+	new (&m_SharedMessage->refcount) std::atomic<int>(1);
+	m_SharedMessage->size = data->cursize;
+	memcpy(m_SharedMessage->data, data->data, data->cursize);
+}
+
+void CGNSNetSystem::QueueSharedMessage(qsocket_t* conn, bool reliable)
+{
+	if (!m_SharedMessage || !conn)
+		return;
+
+	// an empty message only costs the header, the data points at the shared copy
+	auto message = SteamNetworkingUtils()->AllocateMessage(0);
+
+	++m_SharedMessage->refcount;
+
+	message->m_pData = m_SharedMessage->data;
+	message->m_cbSize = m_SharedMessage->size;
+	message->m_nUserData = static_cast<int64>(reinterpret_cast<intptr_t>(m_SharedMessage));
+	message->m_pfnFreeData = &FreeSharedMessage;
+
+	Enqueue(conn, message, reliable);
+}
+
+void CGNSNetSystem::EndSharedMessage()
+{
+	if (!m_SharedMessage)
+		return;
+
+	ReleaseShared(m_SharedMessage);
+	m_SharedMessage = nullptr;
+}
+
+int CGNSNetSystem::SendQueuedMessages()
+{
+	int failed = m_LoopbackSendFailures;
+
+	m_LoopbackSendFailures = 0;
+
+	if (m_SendQueue.empty())
+		return failed;
+
+	SetNetTime();
+
+	const int count = m_SendQueue.size();
+
+	m_SendResults.resize(count);
+
+	// the library takes ownership of every message, even the ones that fail
+	m_GNSInterface->SendMessages(count, m_SendQueue.data(), m_SendResults.data());
+
+	for (int i = 0; i < count; ++i)
+	{
+		const auto& info = m_SendQueueInfo[i];
+
+		if (m_SendResults[i] < 0)
 		{
-			SendMessage(host_client->netconnection, data);
-			state1[i] = true;
-			state2[i] = true;
+			info.conn->sendfailed = true;
+			++failed;
 		}
+		else if (info.reliable)
+			messagesSent++;
 		else
+			unreliableMessagesSent++;
+	}
+
+	m_SendQueue.clear();
+	m_SendQueueInfo.clear();
+
+	return failed;
+}
+
+void CGNSNetSystem::Enqueue(qsocket_t* conn, SteamNetworkingMessage_t* message, bool reliable)
+{
+	// nothing to batch for the loopback, it can be written right away
+	if (conn->loopback)
+	{
+		if (LoopbackSend(conn, message->m_pData, message->m_cbSize, reliable) == -1)
 		{
-			state1[i] = true;
-			state2[i] = true;
+			conn->sendfailed = true;
+			++m_LoopbackSendFailures;
 		}
+
+		message->Release();
+		return;
 	}
 
-	const double start = Sys_FloatTime();
-	while (count)
+	message->m_conn = conn->connection;
+	message->m_nFlags = (reliable ? k_nSteamNetworkingSend_Reliable : k_nSteamNetworkingSend_Unreliable) | k_nSteamNetworkingSend_NoNagle;
+
+	m_SendQueue.push_back(message);
+	m_SendQueueInfo.push_back({conn, reliable});
+}
+
+void CGNSNetSystem::ReleaseShared(sharedmessage_t* shared)
+{
+	// may be called from the library's service thread
+	if (--shared->refcount == 0)
 	{
-		count = 0;
-		for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
-		{
-			if (!state1[i])
-			{
-				if (CanSendMessage(host_client->netconnection))
-				{
-					state1[i] = true;
-					SendMessage(host_client->netconnection, data);
-				}
-				else
-				{
-					GetMessage(host_client->netconnection);
-				}
-				count++;
-				continue;
-			}
+		shared->refcount.~atomic();
+		free(shared);
+	}
+}
 
-			if (!state2[i])
-			{
-				if (CanSendMessage(host_client->netconnection))
-				{
-					state2[i] = true;
-				}
-				else
-				{
-					GetMessage(host_client->netconnection);
-				}
-				count++;
-				continue;
-			}
+void CGNSNetSystem::FreeSharedMessage(SteamNetworkingMessage_t* message)
+{
+	ReleaseShared(reinterpret_cast<sharedmessage_t*>(static_cast<intptr_t>(message->m_nUserData)));
+}
+
+int CGNSNetSystem::SendToAll(sizebuf_t* data)
+{
+	int			i;
+	int			count = 0;
+
+	SetNetTime();
+
+	BeginSharedMessage(data);
+
+	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
+	{
+		if (!host_client->netconnection || !host_client->active)
+			continue;
+
+		if (!IsValidConnection(host_client->netconnection))
+		{
+			count++;
+			continue;
 		}
-		if ((Sys_FloatTime() - start) > blocktime)
-			break;
+
+		QueueSharedMessage(host_client->netconnection, true);
 	}
-	return count;
+
+	EndSharedMessage();
+
+	// delivery is tracked per connection from here on, see UpdateLingering
+	return count + SendQueuedMessages();
 }
 
 void CGNSNetSystem::Close(qsocket_t* conn)
 {
-	if (!conn || conn->connection == k_HSteamNetConnection_Invalid)
+	if (!conn || (conn->connection == k_HSteamNetConnection_Invalid && !conn->loopback))
 		return;
 
 	SetNetTime();
 
-	m_GNSInterface->CloseConnection(conn->connection, k_ESteamNetConnectionEnd_App_Generic, "Closing connection", false);
+	ReleasePending(conn);
+
+	// drop anything still queued for it so the queue never refers to a closed socket
+	for (std::size_t i = 0; i < m_SendQueue.size();)
+	{
+		if (m_SendQueueInfo[i].conn == conn)
+		{
+			m_SendQueue[i]->Release();
+			m_SendQueue.erase(m_SendQueue.begin() + i);
+			m_SendQueueInfo.erase(m_SendQueueInfo.begin() + i);
+		}
+		else
+			++i;
+	}
+
+	if (conn->loopback)
+	{
+		// the other end finds out once it has read everything sent before this
+		conn->loopback->closed = true;
+	}
+	else
+	{
+		// keep sending reliable data that hasn't arrived yet (like a disconnect or reconnect) in the background
+		m_GNSInterface->CloseConnection(conn->connection, k_ESteamNetConnectionEnd_App_Generic, "Closing connection", true);
+		m_Lingering.push_back({conn->connection, conn->address, net_time});
+	}
 
 	m_Connections.erase(std::remove_if(m_Connections.begin(), m_Connections.end(), [&](const auto& other)
 		{
@@ -375,14 +775,76 @@ void CGNSNetSystem::RunFrame()
 		m_PendingServerLoopbackSocket = nullptr;
 	}
 
+	UpdateLingering();
+
 	m_GNSInterface->RunCallbacks();
 }
 
+void CGNSNetSystem::UpdateLingering()
+{
+	if (m_Lingering.empty())
+		return;
+
+	SetNetTime();
+
+	m_Lingering.erase(std::remove_if(m_Lingering.begin(), m_Lingering.end(), [&](const LingeringConnection& linger)
+		{
+			SteamNetConnectionRealTimeStatus_t status;
+
+			if (m_GNSInterface->GetConnectionRealTimeStatus(linger.connection, &status, 0, nullptr) != k_EResultOK)
+			{
+				// the library has finished with it
+				return true;
+			}
+
+			if (status.m_cbPendingReliable == 0 && status.m_cbSentUnackedReliable == 0)
+			{
+				Con_DPrintf("%s: reliable data delivered\n", linger.address.c_str());
+				m_GNSInterface->CloseConnection(linger.connection, k_ESteamNetConnectionEnd_App_Generic, "Closing connection", false);
+				return true;
+			}
+
+			if (net_time - linger.closetime > NET_LINGERTIME)
+			{
+				Con_DPrintf("%s: gave up delivering reliable data\n", linger.address.c_str());
+				m_GNSInterface->CloseConnection(linger.connection, k_ESteamNetConnectionEnd_App_Generic, "Closing connection", false);
+				return true;
+			}
+
+			return false;
+		}), m_Lingering.end());
+}
+
 bool CGNSNetSystem::IsValidConnection(qsocket_t* conn) const
 {
+	if (conn && conn->loopback)
+		return !conn->loopback->closed;
+
 	return conn && m_GNSInterface->GetConnectionInfo(conn->connection, nullptr);
 }
 
+int CGNSNetSystem::LoopbackSend(qsocket_t* conn, const void* data, int size, bool reliable)
+{
+	auto& channel = conn->loopbackserver ? conn->loopback->toclient : conn->loopback->toserver;
+
+	if (!channel.Write(data, size, reliable))
+	{
+		// unreliable data is allowed to get lost, but losing reliable data breaks the connection
+		if (!reliable)
+			return 1;
+
+		Con_Printf("NET_SendMessage: loopback overflow\n");
+		return -1;
+	}
+
+	if (reliable)
+		messagesSent++;
+	else
+		unreliableMessagesSent++;
+
+	return 1;
+}
+
 void CGNSNetSystem::CloseSocket()
 {
 	if (m_GNSSocket != k_HSteamListenSocket_Invalid)
@@ -392,6 +854,24 @@ void CGNSNetSystem::CloseSocket()
 	}
 }
 
+void CGNSNetSystem::AddToPollGroup(qsocket_t* conn)
+{
+	m_GNSInterface->SetConnectionUserData(conn->connection, static_cast<int64>(reinterpret_cast<intptr_t>(conn)));
+	m_GNSInterface->SetConnectionPollGroup(conn->connection, m_PollGroup);
+
+	conn->pollgroup = true;
+}
+
+void CGNSNetSystem::ReleasePending(qsocket_t* conn)
+{
+	for (auto message : conn->pending)
+	{
+		message->Release();
+	}
+
+	conn->pending.clear();
+}
+
 void CGNSNetSystem::OnServerSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* pInfo)
 {
 	switch (pInfo->m_info.m_eState)
@@ -486,6 +966,8 @@ void CGNSNetSystem::OnServerSteamNetConnectionStatusChanged(SteamNetConnectionSt
 
 		m_Connections.push_back(std::move(connection));
 
+		AddToPollGroup(m_Connections.back().get());
+
 		SV_NewClient(m_Connections.back().get());
 		break;
 	}
@@ -20,12 +20,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #pragma once
 
+#include <atomic>
+#include <thread>
 #include <vector>
 
 #include <steam/steamnetworkingsockets.h>
 
 #include "net.h"
 
+struct sharedmessage_t;
+
 /**
 *	@brief GameNetworkingSockets-based networking system.
 */
@@ -43,15 +47,37 @@ public:
 
 	qsocket_t* Connect(const char* host) override;
 
+	qsocket_t* ConnectLoopback(qsocket_t** server) override;
+
 	bool CanSendMessage(qsocket_t* conn) override;
 
 	int GetMessage(qsocket_t* conn) override;
 
+	void ReceiveMessages() override;
+
+	bool MessagesWaiting() override;
+
+	void ReleaseMessage() override;
+
 	int SendMessage(qsocket_t* conn, sizebuf_t* data) override;
 
 	int SendUnreliableMessage(qsocket_t* conn, sizebuf_t* data) override;
 
-	int SendToAll(sizebuf_t* data, int blocktime) override;
+	void AllocateMessage(netmessage_t* msg, int maxsize) override;
+
+	void FreeMessage(netmessage_t* msg) override;
+
+	void QueueMessage(qsocket_t* conn, netmessage_t* msg, bool reliable) override;
+
+	void BeginSharedMessage(const sizebuf_t* data) override;
+
+	void QueueSharedMessage(qsocket_t* conn, bool reliable) override;
+
+	void EndSharedMessage() override;
+
+	int SendQueuedMessages() override;
+
+	int SendToAll(sizebuf_t* data) override;
 
 	void Close(qsocket_t* conn) override;
 
@@ -62,6 +88,21 @@ private:
 
 	void CloseSocket();
 
+	void UpdateLingering();
+
+	void AddToPollGroup(qsocket_t* conn);
+
+	void ReleasePending(qsocket_t* conn);
+
+	void Enqueue(qsocket_t* conn, SteamNetworkingMessage_t* message, bool reliable);
+
+	int LoopbackSend(qsocket_t* conn, const void* data, int size, bool reliable);
+
+	void ServiceThread();
+
+	static void ReleaseShared(sharedmessage_t* shared);
+	static void FreeSharedMessage(SteamNetworkingMessage_t* message);
+
 	void OnServerSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* pInfo);
 	void OnClientSteamNetConnectionStatusChanged(SteamNetConnectionStatusChangedCallback_t* pInfo);
 
@@ -86,4 +127,55 @@ private:
 	std::vector<std::unique_ptr<qsocket_t>> m_Connections;
 
 	qsocket_t* m_PendingServerLoopbackSocket = nullptr;
+
+	/**
+	*	@brief All server side connections, so the server can receive from every client at once
+	*/
+	HSteamNetPollGroup m_PollGroup = k_HSteamNetPollGroup_Invalid;
+
+	/**
+	*	@brief The message net_message currently points into, and the buffer it points to otherwise
+	*/
+	SteamNetworkingMessage_t* m_HeldMessage = nullptr;
+	byte* m_NetMessageData = nullptr;
+	int m_NetMessageSize = 0;
+
+	/**
+	*	@brief Messages waiting for SendQueuedMessages, and who they are for
+	*/
+	struct QueuedSend
+	{
+		qsocket_t* conn;
+		bool reliable;
+	};
+
+	std::vector<SteamNetworkingMessage_t*> m_SendQueue;
+	std::vector<QueuedSend> m_SendQueueInfo;
+	std::vector<int64> m_SendResults;
+
+	sharedmessage_t* m_SharedMessage = nullptr;
+
+	/**
+	*	@brief Queued loopback messages are written immediately, failures are reported by the next SendQueuedMessages
+	*/
+	int m_LoopbackSendFailures = 0;
+
+	/**
+	*	@brief Closed connections that are still delivering reliable data
+	*/
+	struct LingeringConnection
+	{
+		HSteamNetConnection connection;
+		std::string address;
+		double closetime;
+	};
+
+	std::vector<LingeringConnection> m_Lingering;
+
+	/**
+	*	@brief Dedicated servers run the library's socket polling here instead of its own service thread,
+	*	so the tick scheduler can be woken when data arrives
+	*/
+	std::thread m_ServiceThread;
+	std::atomic<bool> m_StopService{false};
 };
@@ -0,0 +1,102 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "quakedef.h"
+#include "CLoopbackChannel.h"
+
+static_assert((CLoopbackChannel::Size & (CLoopbackChannel::Size - 1)) == 0, "loopback size must be a power of two");
+
+#define LOOPBACK_RELIABLE	0x80000000u
+
+static std::size_t LoopbackRecordSize(int size)
+{
+	return sizeof(std::uint32_t) + ((size + 3) & ~3);
+}
+
+CLoopbackChannel::CLoopbackChannel()
+	: m_Buffer(std::make_unique<byte[]>(Size))
+{
+}
+
+bool CLoopbackChannel::Write(const void* data, int size, bool reliable)
+{
+	if (size < 0 || size > NET_MAXMESSAGE)
+		return false;
+
+	const std::size_t head = m_Head.load(std::memory_order_relaxed);
+	const std::size_t tail = m_Tail.load(std::memory_order_acquire);
+	const std::size_t needed = LoopbackRecordSize(size);
+
+	if (Size - (head - tail) < needed)
+		return false;
+
+	const std::uint32_t header = static_cast<std::uint32_t>(size) | (reliable ? LOOPBACK_RELIABLE : 0);
+
+	CopyIn(head, &header, sizeof(header));
+	CopyIn(head + sizeof(header), data, size);
+
+	m_Head.store(head + needed, std::memory_order_release);
+
+	return true;
+}
+
+int CLoopbackChannel::Read(sizebuf_t* buf)
+{
+	const std::size_t tail = m_Tail.load(std::memory_order_relaxed);
+	const std::size_t head = m_Head.load(std::memory_order_acquire);
+
+	if (head == tail)
+		return 0;
+
+	std::uint32_t header;
+	CopyOut(tail, &header, sizeof(header));
+
+	const int size = header & ~LOOPBACK_RELIABLE;
+
+	SZ_Clear(buf);
+	CopyOut(tail + sizeof(header), SZ_GetSpace(buf, size), size);
+
+	m_Tail.store(tail + LoopbackRecordSize(size), std::memory_order_release);
+
+	return (header & LOOPBACK_RELIABLE) ? 1 : 2;
+}
+
+void CLoopbackChannel::CopyIn(std::size_t pos, const void* data, std::size_t size)
+{
+	pos &= Size - 1;
+
+	const std::size_t first = std::min(size, Size - pos);
+
+	memcpy(m_Buffer.get() + pos, data, first);
+	memcpy(m_Buffer.get(), static_cast<const byte*>(data) + first, size - first);
+}
+
+void CLoopbackChannel::CopyOut(std::size_t pos, void* data, std::size_t size) const
+{
+	pos &= Size - 1;
+
+	const std::size_t first = std::min(size, Size - pos);
+
+	memcpy(data, m_Buffer.get() + pos, first);
+	memcpy(static_cast<byte*>(data) + first, m_Buffer.get(), size - first);
+}
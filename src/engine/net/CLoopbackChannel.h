@@ -0,0 +1,76 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+*	@brief Single producer, single consumer ring buffer of messages for the in-process loopback connection.
+*	@details Messages are stored back to back as a 4 byte header (size and reliable flag) followed by the data,
+*	padded to 4 bytes so a header never wraps around the end of the buffer.
+*/
+class CLoopbackChannel final
+{
+public:
+	static constexpr std::size_t Size = 1 << 20;
+
+	CLoopbackChannel();
+
+	/**
+	*	@return false if the message doesn't fit, the reader has fallen too far behind
+	*/
+	bool Write(const void* data, int size, bool reliable);
+
+	/**
+	*	@brief Copies the oldest message into buf
+	*	@return 0 if no message is waiting, 1 for a reliable message, 2 for an unreliable one
+	*/
+	int Read(sizebuf_t* buf);
+
+	bool Empty() const
+	{
+		return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_relaxed);
+	}
+
+private:
+	void CopyIn(std::size_t pos, const void* data, std::size_t size);
+	void CopyOut(std::size_t pos, void* data, std::size_t size) const;
+
+private:
+	std::unique_ptr<byte[]> m_Buffer;
+
+	// total bytes ever written and read, only the writer stores m_Head and only the reader m_Tail
+	std::atomic<std::size_t> m_Head{0};
+	std::atomic<std::size_t> m_Tail{0};
+};
+
+/**
+*	@brief Both directions of a local client's connection to the server running in the same process
+*/
+struct loopback_t
+{
+	CLoopbackChannel toserver;
+	CLoopbackChannel toclient;
+
+	std::atomic<bool> closed{false};
+};
@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <string>
 
@@ -30,6 +31,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define NET_MAXMESSAGE		8192
 
+struct loopback_t;
+
 struct qsocket_t
 {
 	/**
@@ -40,6 +43,37 @@ struct qsocket_t
 	double connecttime;
 
 	std::string address;
+
+	/**
+	*	@brief Set for both ends of a local client's connection, which bypasses the networking library entirely
+	*/
+	std::shared_ptr<loopback_t> loopback;
+	bool loopbackserver = false;
+
+	/**
+	*	@brief Server connections are received in batches through a poll group instead of one at a time
+	*/
+	bool pollgroup = false;
+
+	/**
+	*	@brief Messages that were received in a batch for this connection but not read yet
+	*/
+	std::deque<SteamNetworkingMessage_t*> pending;
+
+	/**
+	*	@brief Set when a queued message to this connection could not be sent, the owner should drop it
+	*/
+	bool sendfailed = false;
+};
+
+/**
+*	@brief An outgoing message that is built in place in a buffer owned by the networking library
+*/
+struct netmessage_t
+{
+	sizebuf_t buf{};
+
+	SteamNetworkingMessage_t* message = nullptr;
 };
 
 struct INetSystem
@@ -57,6 +91,13 @@ struct INetSystem
 	*/
 	virtual qsocket_t* Connect(const char* host) = 0;
 
+	/**
+	*	@brief Creates a connected pair of in-process sockets, for clients that live inside the server process.
+	*	@param server Receives the server end, which the caller hands to SV_NewClient.
+	*	@return The client end.
+	*/
+	virtual qsocket_t* ConnectLoopback(qsocket_t** server) = 0;
+
 	/**
 	*	@brief Returns true or false if the given qsocket can currently accept a message to be transmitted.
 	*/
@@ -70,6 +111,23 @@ struct INetSystem
 	*			-1 if the connection died
 	*/
 	virtual int GetMessage(qsocket_t* conn) = 0;
+
+	/**
+	*	@brief Receives everything waiting on the server's connections in as few calls as possible
+	*	and queues it on the owning connection for GetMessage. Call once per server frame before reading clients.
+	*/
+	virtual void ReceiveMessages() = 0;
+
+	/**
+	*	@brief Whether any server connection has a message waiting, without reading it
+	*/
+	virtual bool MessagesWaiting() = 0;
+
+	/**
+	*	@brief Server messages are read in place, this gives net_message back its own buffer
+	*	@details Called automatically by the next GetMessage, call it when done parsing if net_message may be used otherwise.
+	*/
+	virtual void ReleaseMessage() = 0;
 	
 	/**
 	*	@return 0 if the message connot be delivered reliably, but the connection is still considered valid
@@ -81,9 +139,44 @@ struct INetSystem
 	virtual int SendUnreliableMessage(qsocket_t* conn, sizebuf_t* data) = 0;
 
 	/**
-	*	@brief This is a reliable *blocking* send to all attached clients.
+	*	@brief Points msg->buf at a new library owned buffer of maxsize bytes, freeing any message it still had
+	*/
+	virtual void AllocateMessage(netmessage_t* msg, int maxsize) = 0;
+
+	virtual void FreeMessage(netmessage_t* msg) = 0;
+
+	/**
+	*	@brief Hands the message over to be sent by the next SendQueuedMessages, msg no longer owns it afterwards
+	*/
+	virtual void QueueMessage(qsocket_t* conn, netmessage_t* msg, bool reliable) = 0;
+
+	/**
+	*	@brief Takes one copy of data that several connections will be sent, for QueueSharedMessage
+	*/
+	virtual void BeginSharedMessage(const sizebuf_t* data) = 0;
+
+	/**
+	*	@brief Queues the current shared data for conn without copying it again
+	*/
+	virtual void QueueSharedMessage(qsocket_t* conn, bool reliable) = 0;
+
+	/**
+	*	@brief The shared data is freed once the messages queued with it have been sent
+	*/
+	virtual void EndSharedMessage() = 0;
+
+	/**
+	*	@brief Sends everything queued in one batch, messages to the same connection keep the order they were queued in
+	*	@return The number of messages that could not be sent, their connections have sendfailed set
+	*/
+	virtual int SendQueuedMessages() = 0;
+
+	/**
+	*	@brief Queues a reliable message to all active clients and returns without waiting for it to arrive.
+	*	@details Connections that are closed afterwards keep delivering it in the background for a few seconds.
+	*	@return The number of clients it could not be sent to
 	*/
-	virtual int SendToAll(sizebuf_t* data, int blocktime) = 0;
+	virtual int SendToAll(sizebuf_t* data) = 0;
 
 	/**
 	*	@brief if a dead connection is returned by a get or send function, this function should be called when it is convenient
@@ -20,6 +20,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // protocol.h -- communications protocols
 
 #define	PROTOCOL_VERSION	15
+#define	PROTOCOL_DELTA		16		// entities sent as svc_packetentities deltas against
+									// the last frame the client acknowledged
+
+// frames remembered on both ends for delta compression, must be a power of 2
+#define	UPDATE_BACKUP	16
+#define	UPDATE_MASK		(UPDATE_BACKUP - 1)
 
 // if the high bit of the servercmd is set, the low bits are fast update flags:
 #define	U_MOREBITS	(1<<0)
@@ -39,6 +45,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	U_SKIN		(1<<12)
 #define	U_EFFECTS	(1<<13)
 #define	U_LONGENTITY	(1<<14)
+#define	U_REMOVE		(1<<15)		// svc_packetentities only, the entity left the frame
 
 
 #define	SU_VIEWHEIGHT	(1<<0)
@@ -129,6 +136,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define svc_sellscreen		33
 
 #define svc_cutscene		34
+#define	svc_packetentities	35		// [long] sequence [long] delta sequence, <see code>
 
 //
 // client to server
@@ -41,6 +41,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #endif
 
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <math.h>
 #include <string.h>
 #include <stdarg.h>
@@ -98,7 +100,7 @@ void	VID_UnlockBuffer(void);
 //
 // per-level limits
 //
-#define	MAX_EDICTS		600			// FIXME: ouch! ouch! ouch!
+#define	MAX_EDICTS		8192		// sounds send the entity number in 13 bits
 #define	MAX_LIGHTSTYLES	64
 #define	MAX_MODELS		256			// these are sent over the net as bytes
 #define	MAX_SOUNDS		256			// so they cannot be blindly increased
@@ -218,6 +220,20 @@ typedef struct
 	int		effects;
 } entity_state_t;
 
+// an entity as it was sent in a svc_packetentities frame
+typedef struct
+{
+	int				number;
+	bool			nolerp;		// U_NOLERP
+	entity_state_t	state;
+} packet_entity_t;
+
+typedef struct
+{
+	int				sequence;	// 0 if the slot holds no frame
+	std::vector<packet_entity_t>	entities;	// sorted by number
+} packet_frame_t;
+
 
 #include "wad.h"
 #include "client/renderer/draw.h"
@@ -246,6 +262,10 @@ typedef struct
 #include "client/view.h"
 #include "client/ui/menu.h"
 #include "crc.h"
+#include "jobs.h"
+#include "tick.h"
+#include "modcache.h"
+#include "datacache.h"
 #include "client/sound/ICDAudio.h"
 
 //GL stuff begin
@@ -311,8 +331,7 @@ typedef struct
 	char* cachedir;		// for development over ISDN lines
 	int		argc;
 	const char** argv;
-	void* membase;
-	int		memsize;
+	int		memsize;		// initial size of the level arena
 } quakeparms_t;
 
 
@@ -18,6 +18,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#include <algorithm>
+
 #include "quakedef.h"
 
 /*
@@ -200,7 +202,7 @@ void PF_setmodel(edict_t* e, const char* m)
 		Host_Error("no precache: %s\n", m);
 
 	e->v.model = m;
-	e->v.modelindex = i; //SV_ModelIndex (m);
+	ED_SetModelIndex(e, i); //SV_ModelIndex (m);
 
 	auto mod = sv.models[(int)e->v.modelindex];  // Mod_ForName (m, true);
 
@@ -662,20 +664,45 @@ findradius (origin, radius)
 */
 edict_t* PF_findradius(const float* org, float rad)
 {
-	vec3_t	eorg;
+	vec3_t	eorg, mins, maxs;
+	static edict_t* list[MAX_EDICTS];	// too big for the stack
+	int		count;
 
 	auto chain = sv.edicts;
 
-	auto ent = sv.edicts + 1;
-	for (int i = 1; i < sv.num_edicts; i++, ++ent)
+	if (rad < 0)
+		return chain;
+
+	// every non SOLID_NOT entity is linked, and its absolute box contains
+	// the center that is tested, so the broadphase gives all candidates
+	for (int j = 0; j < 3; j++)
+	{
+		mins[j] = org[j] - rad;
+		maxs[j] = org[j] + rad;
+	}
+
+	count = SV_AreaEdicts(mins, maxs, list, MAX_EDICTS, AREA_SOLID);
+	count += SV_AreaEdicts(mins, maxs, list + count, MAX_EDICTS - count, AREA_TRIGGERS);
+
+	// chain them in the same order as a scan of the edict list would
+	std::sort(list, list + count, [](const edict_t* lhs, const edict_t* rhs)
+		{
+			return lhs->entnum < rhs->entnum;
+		});
+
+	const float radsquared = rad * rad;
+
+	for (int i = 0; i < count; i++)
 	{
+		auto ent = list[i];
+
 		if (ent->free)
 			continue;
 		if (ent->v.solid == SOLID_NOT)
 			continue;
 		for (int j = 0; j < 3; j++)
 			eorg[j] = org[j] - (ent->v.origin[j] + (ent->v.mins[j] + ent->v.maxs[j]) * 0.5);
-		if (Length(eorg) > rad)
+		if (DotProduct(eorg, eorg) > radsquared)
 			continue;
 
 		ent->v.chain = chain;
@@ -685,15 +712,17 @@ edict_t* PF_findradius(const float* org, float rad)
 	return chain;
 }
 
-char	pr_string_temp[128];
+#define	PR_STRING_TEMP	128		// strings built here last until the end of the frame
 
 const char* PF_ftos(float v)
 {
+	char* s = reinterpret_cast<char*>(Scratch_Alloc(PR_STRING_TEMP));
+
 	if (v == (int)v)
-		sprintf(pr_string_temp, "%d", (int)v);
+		sprintf(s, "%d", (int)v);
 	else
-		sprintf(pr_string_temp, "%5.1f", v);
-	return pr_string_temp;
+		sprintf(s, "%5.1f", v);
+	return s;
 }
 
 float PF_fabs(float v)
@@ -703,8 +732,10 @@ float PF_fabs(float v)
 
 const char* PF_vtos(const float* v)
 {
-	sprintf(pr_string_temp, "'%5.1f %5.1f %5.1f'", v[0], v[1], v[2]);
-	return pr_string_temp;
+	char* s = reinterpret_cast<char*>(Scratch_Alloc(PR_STRING_TEMP));
+
+	sprintf(s, "'%5.1f %5.1f %5.1f'", v[0], v[1], v[2]);
+	return s;
 }
 
 edict_t* PF_Spawn()
@@ -713,7 +744,7 @@ edict_t* PF_Spawn()
 
 	//Mimic QuakeC behavior where a null string is an empty string.
 	//TODO: verify that !classname checks are updated everywhere.
-	ent->v.classname = "";
+	ED_SetClassname(ent, "");
 
 	return ent;
 }
@@ -764,6 +795,12 @@ edict_t* PF_Find(edict_t* ent, const char* f, const char* s)
 		return sv.edicts;
 	}
 
+	if (member == &entvars_t::classname)
+	{
+		auto ed = ED_FindClassname(e, s);
+		return ed ? ed : sv.edicts;
+	}
+
 	for (e++; e < sv.num_edicts; e++)
 	{
 		auto ed = EDICT_NUM(e);
@@ -915,6 +952,13 @@ void PF_lightstyle(int style, const char* val)
 			MSG_WriteString(&client->message, val);
 		}
 	}
+
+	if (auto demo = SV_DemoReliable(); demo)
+	{
+		MSG_WriteChar(demo, svc_lightstyle);
+		MSG_WriteChar(demo, style);
+		MSG_WriteString(demo, val);
+	}
 }
 
 float PF_rint(float f)
@@ -1016,9 +1060,9 @@ void PF_aim(edict_t* ent, float speed, float* aimDirection)
 	bestdist = sv_aim.value;
 	edict_t* bestent = NULL;
 
-	auto check = sv.edicts + 1;
-	for (int i = 1; i < sv.num_edicts; i++, ++check)
+	for (int i = 1; i < sv.num_edicts; i++)
 	{
+		auto check = EDICT_NUM(i);
 		if (check->v.takedamage != DAMAGE_AIM)
 			continue;
 		if (check == ent)
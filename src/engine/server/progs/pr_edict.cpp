@@ -19,6 +19,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // sv_edict.c -- entity dictionary
 
+#include <map>
+#include <set>
+#include <string>
+
 #include "quakedef.h"
 #include "game/IGame.h"
 
@@ -32,6 +36,96 @@ constexpr int type_size[etypes_count] = {1,sizeof(const char*) / 4,1,3,1,sizeof(
 
 bool ED_ParseEpair(void* base, const fielddescription& key, const char* s);
 
+/*
+===============================================================================
+
+CLASSNAME INDEX
+
+Edict numbers bucketed by classname so find() on classname only looks at
+matching entities. The buckets may hold stale entries (edicts that were freed
+or whose classname was wiped without going through here), lookups verify each
+candidate, but every edict with a classname must be in its bucket.
+===============================================================================
+*/
+
+static std::map<std::string, std::set<int>, std::less<>> ed_classnames;
+
+/*
+=================
+ED_ClearClassnames
+=================
+*/
+void ED_ClearClassnames(void)
+{
+	ed_classnames.clear();
+}
+
+static void ED_UnindexClassname(edict_t* ed)
+{
+	if (!ed->v.classname)
+		return;
+
+	auto it = ed_classnames.find(ed->v.classname);
+	if (it != ed_classnames.end())
+		it->second.erase(ed->entnum);
+}
+
+static void ED_IndexClassname(edict_t* ed)
+{
+	if (!ed->v.classname)
+		return;
+
+	auto it = ed_classnames.find(ed->v.classname);
+	if (it == ed_classnames.end())
+		it = ed_classnames.emplace(ed->v.classname, std::set<int>()).first;
+
+	it->second.insert(ed->entnum);
+}
+
+/*
+=================
+ED_SetClassname
+
+All classname changes must go through here to keep the index up to date
+=================
+*/
+void ED_SetClassname(edict_t* ed, const char* classname)
+{
+	ED_UnindexClassname(ed);
+	ed->v.classname = classname;
+	ED_IndexClassname(ed);
+}
+
+/*
+=================
+ED_FindClassname
+
+Returns the first edict after start with the given classname, or NULL
+=================
+*/
+edict_t* ED_FindClassname(int start, const char* classname)
+{
+	auto it = ed_classnames.find(classname);
+	if (it == ed_classnames.end())
+		return NULL;
+
+	for (auto e = it->second.upper_bound(start); e != it->second.end(); ++e)
+	{
+		if (*e >= sv.num_edicts)
+			break;
+
+		auto ed = EDICT_NUM(*e);
+		if (ed->free)
+			continue;
+		if (ed->v.classname && !strcmp(ed->v.classname, classname))
+			return ed;
+	}
+
+	return NULL;
+}
+
+//===========================================================================
+
 /*
 =================
 ED_ClearEdict
@@ -41,8 +135,159 @@ Sets everything to NULL
 */
 void ED_ClearEdict(edict_t* e)
 {
+	ED_UnindexClassname(e);
 	memset(&e->v, 0, sizeof(entvars_t));
 	e->free = false;
+	ED_MirrorEdict(e);
+}
+
+/*
+=================
+ED_MirrorEdict
+=================
+*/
+void ED_MirrorEdict(edict_t* ed)
+{
+	edictmirror_t& mirror = sv.mirror;
+	const int n = ed->entnum;
+
+	if (ed->free)
+		mirror.inuse[n >> 5] &= ~(1u << (n & 31));
+	else
+		mirror.inuse[n >> 5] |= 1u << (n & 31);
+
+	if (!ed->free && ed->v.movetype != MOVETYPE_NONE)
+		mirror.moving[n >> 5] |= 1u << (n & 31);
+	else
+		mirror.moving[n >> 5] &= ~(1u << (n & 31));
+
+	mirror.modelindex[n] = ed->v.modelindex;
+	mirror.movetype[n] = ed->v.movetype;
+	mirror.nextthink[n] = ed->v.nextthink;
+
+	if (!ed->free)
+		SV_ScheduleThink(n, ed->v.nextthink);
+}
+
+/*
+=================
+ED_SetModelIndex
+=================
+*/
+void ED_SetModelIndex(edict_t* ed, float modelindex)
+{
+	ed->v.modelindex = modelindex;
+	sv.mirror.modelindex[ed->entnum] = modelindex;
+}
+
+/*
+=================
+ED_SetMovetype
+=================
+*/
+void ED_SetMovetype(edict_t* ed, float movetype)
+{
+	const int n = ed->entnum;
+
+	ed->v.movetype = movetype;
+	sv.mirror.movetype[n] = movetype;
+
+	if (movetype != MOVETYPE_NONE && !ed->free)
+		sv.mirror.moving[n >> 5] |= 1u << (n & 31);
+	else
+	{
+		sv.mirror.moving[n >> 5] &= ~(1u << (n & 31));
+		// a pending think may have been dropped by the scheduler while it was moving
+		SV_ScheduleThink(n, sv.mirror.nextthink[n]);
+	}
+}
+
+/*
+=================
+ED_SetNextThink
+=================
+*/
+void ED_SetNextThink(edict_t* ed, float nextthink)
+{
+	ed->v.nextthink = nextthink;
+	sv.mirror.nextthink[ed->entnum] = nextthink;
+	SV_ScheduleThink(ed->entnum, nextthink);
+}
+
+/*
+=================
+ED_AllocEdictChunk
+=================
+*/
+static void ED_AllocEdictChunk(void)
+{
+	edict_t* chunk;
+	int		i, first;
+
+	if (sv.num_edict_chunks << EDICT_CHUNK_SHIFT >= sv.max_edicts)
+		Sys_Error("ED_AllocEdictChunk: no free edicts");
+
+	first = sv.num_edict_chunks << EDICT_CHUNK_SHIFT;
+
+	chunk = reinterpret_cast<edict_t*>(Hunk_AllocName(EDICT_CHUNK_SIZE * sizeof(edict_t), "edicts"));
+	for (i = 0; i < EDICT_CHUNK_SIZE; i++)
+		chunk[i].entnum = first + i;
+
+	// new edicts are all zeros, so not free
+	for (i = 0; i < EDICT_CHUNK_SIZE / 32; i++)
+		sv.mirror.inuse[(first >> 5) + i] = ~0u;
+
+	sv.edict_chunks[sv.num_edict_chunks++] = chunk;
+}
+
+/*
+=================
+ED_InitEdicts
+
+Called at level start, the hunk has already been cleared
+=================
+*/
+void ED_InitEdicts(int maxedicts)
+{
+	sv.max_edicts = maxedicts;
+	sv.num_edict_chunks = 0;
+	const int numchunks = (maxedicts + EDICT_CHUNK_SIZE - 1) >> EDICT_CHUNK_SHIFT;
+	const int size = numchunks << EDICT_CHUNK_SHIFT;
+
+	sv.edict_chunks = reinterpret_cast<edict_t**>(Hunk_AllocName(numchunks * sizeof(edict_t*), "edicts"));
+
+	edictmirror_t& mirror = sv.mirror;
+	mirror.inuse = reinterpret_cast<unsigned int*>(Hunk_AllocName(size / 8, "edictmirror"));
+	mirror.moving = reinterpret_cast<unsigned int*>(Hunk_AllocName(size / 8, "edictmirror"));
+	mirror.due = reinterpret_cast<unsigned int*>(Hunk_AllocName(size / 8, "edictmirror"));
+	mirror.modelindex = reinterpret_cast<float*>(Hunk_AllocName(size * sizeof(float), "edictmirror"));
+	mirror.movetype = reinterpret_cast<float*>(Hunk_AllocName(size * sizeof(float), "edictmirror"));
+	mirror.nextthink = reinterpret_cast<float*>(Hunk_AllocName(size * sizeof(float), "edictmirror"));
+	mirror.num_leafs = reinterpret_cast<int*>(Hunk_AllocName(size * sizeof(int), "edictmirror"));
+	mirror.leafnums = reinterpret_cast<short(*)[MAX_ENT_LEAFS]>(Hunk_AllocName(size * sizeof(short[MAX_ENT_LEAFS]), "edictmirror"));
+	mirror.headnode = reinterpret_cast<mnode_t**>(Hunk_AllocName(size * sizeof(mnode_t*), "edictmirror"));
+	mirror.clusters = reinterpret_cast<uint64_t(*)[CLUSTER_WORDS]>(Hunk_AllocName(size * sizeof(uint64_t[CLUSTER_WORDS]), "edictmirror"));
+	mirror.clusterwords = size / 64;
+	mirror.clusterents = reinterpret_cast<uint64_t*>(Hunk_AllocName(MAX_LEAF_CLUSTERS * mirror.clusterwords * sizeof(uint64_t), "edictmirror"));
+
+	SV_ClearThinks();
+
+	ED_AllocEdictChunk();
+	sv.edicts = sv.edict_chunks[0];
+}
+
+/*
+=================
+ED_ReserveEdicts
+=================
+*/
+void ED_ReserveEdicts(int count)
+{
+	if (count > sv.max_edicts)
+		Sys_Error("ED_ReserveEdicts: %i is more than the %i edict limit", count, sv.max_edicts);
+
+	while (sv.num_edict_chunks << EDICT_CHUNK_SHIFT < count)
+		ED_AllocEdictChunk();
 }
 
 /*
@@ -73,9 +318,11 @@ edict_t* ED_Alloc(void)
 		}
 	}
 
-	if (i == MAX_EDICTS)
+	if (i == sv.max_edicts)
 		Sys_Error("ED_Alloc: no free edicts");
 
+	ED_ReserveEdicts(i + 1);
+
 	sv.num_edicts++;
 	e = EDICT_NUM(i);
 	ED_ClearEdict(e);
@@ -108,6 +355,7 @@ void ED_Free(edict_t* ed)
 	ed->v.solid = 0;
 
 	ed->freetime = sv.time;
+	ED_MirrorEdict(ed);
 }
 
 //===========================================================================
@@ -939,7 +1187,10 @@ char* ED_ParseEdict(char* data, edict_t* ent)
 
 	// clear it
 	if (ent != sv.edicts)	// hack
+	{
+		ED_UnindexClassname(ent);
 		memset(&ent->v, 0, sizeof(entvars_t));
+	}
 
 	// go through all the dictionary pairs
 	while (1)
@@ -1010,6 +1261,10 @@ char* ED_ParseEdict(char* data, edict_t* ent)
 	if (!init)
 		ent->free = true;
 
+	// fields were set directly, pick up the parsed classname and mirrored fields
+	ED_IndexClassname(ent);
+	ED_MirrorEdict(ent);
+
 	return data;
 }
 
@@ -1100,6 +1355,8 @@ void PR_LoadProgs()
 	//Zero out globals
 	memset(pr_global_struct, 0, sizeof(*pr_global_struct));
 
+	ED_ClearClassnames();
+
 	g_Game->NewMapStarted();
 }
 
@@ -1108,7 +1365,7 @@ void PR_VerifyFunctionsLinked()
 {
 	for (int i = 0; i < sv.num_edicts; ++i)
 	{
-		auto e = &sv.edicts[i];
+		auto e = EDICT_NUM(i);
 
 		if (e->free)
 		{
@@ -1150,16 +1407,16 @@ void PR_Init(void)
 
 edict_t* EDICT_NUM(int n)
 {
-	if (n < 0 || n >= sv.max_edicts)
+	if (n < 0 || n >= sv.num_edict_chunks << EDICT_CHUNK_SHIFT)
 		Sys_Error("EDICT_NUM: bad number %i", n);
-	return sv.edicts + n;
+	return sv.edict_chunks[n >> EDICT_CHUNK_SHIFT] + (n & (EDICT_CHUNK_SIZE - 1));
 }
 
 int NUM_FOR_EDICT(edict_t* e)
 {
-	const int b = e - sv.edicts;
+	const int b = e->entnum;
 
-	if (b < 0 || b >= sv.num_edicts)
+	if (b < 0 || b >= sv.num_edicts || EDICT_NUM(b) != e)
 		Sys_Error("NUM_FOR_EDICT: bad pointer");
 	return b;
 }
@@ -32,13 +32,22 @@ struct fielddescription
 };
 
 #define	MAX_ENT_LEAFS	16
+
+typedef struct
+{
+	int			node;				// sv_areanodes index the entity falls under
+	unsigned int	sequence;		// order of linking, entities in the same node are visited in this order
+	int			cells[4];			// area grid cell range (mins x y, maxs x y), cells[0] is -1 for the large lists
+	bool		trigger;			// linked in the trigger lists instead of the solid lists
+	int			query;				// last area grid query that visited this entity
+} arealink_t;
+
 typedef struct edict_s
 {
 	bool		free;
+	int			entnum;				// index in the edict store, set when the chunk is allocated
 	link_t		area;				// linked to a division node or leaf
-
-	int			num_leafs;
-	short		leafnums[MAX_ENT_LEAFS];
+	arealink_t	arealink;			// broadphase bookkeeping, see world.cpp
 
 	entity_state_t	baseline;
 
@@ -48,6 +57,47 @@ typedef struct edict_s
 } edict_t;
 #define	EDICT_FROM_AREA(l) STRUCT_FROM_LINK(l,edict_t,area)
 
+// edicts are allocated in chunks so they never move once allocated
+#define	EDICT_CHUNK_SHIFT	8
+#define	EDICT_CHUNK_SIZE	(1 << EDICT_CHUNK_SHIFT)
+
+/*
+The fields the per-frame sweeps over all edicts look at, kept in arrays indexed
+by edict number so a sweep reads a few cache lines per entity instead of whole
+edicts.  free, modelindex, movetype and nextthink are copies kept in sync by
+ED_MirrorEdict and the ED_Set* functions, the leafs touched by the entity are
+only stored here.
+
+Leafs are also grouped in clusters of 64, one word of a PVS row, so the
+entities that might be visible from a PVS can be found from the clusters it
+touches without testing every edict.
+*/
+
+#define	LEAF_CLUSTER_SHIFT	6
+#define	MAX_LEAF_CLUSTERS	(MAX_MAP_LEAFS >> LEAF_CLUSTER_SHIFT)
+#define	CLUSTER_WORDS		(MAX_LEAF_CLUSTERS / 64)
+
+typedef struct
+{
+	unsigned int* inuse;			// bit per edict, set when it isn't free
+	unsigned int* moving;			// bit per edict, set when it's in use and movetype isn't MOVETYPE_NONE
+	unsigned int* due;				// bit per edict, set when it has to think this frame, see SV_Physics
+	float* modelindex;
+	float* movetype;
+	float* nextthink;
+	int* num_leafs;
+	short	(*leafnums)[MAX_ENT_LEAFS];
+	struct mnode_s** headnode;		// set when more than MAX_ENT_LEAFS leafs are touched
+	uint64_t	(*clusters)[CLUSTER_WORDS];	// bit per leaf cluster touched
+	int			clusterwords;		// words per row of clusterents
+	uint64_t* clusterents;			// [MAX_LEAF_CLUSTERS][clusterwords] bit per edict touching the cluster
+} edictmirror_t;
+
+inline bool ED_InUse(const edictmirror_t& mirror, int n)
+{
+	return (mirror.inuse[n >> 5] & (1u << (n & 31))) != 0;
+}
+
 //============================================================================
 
 extern	globalvars_t* pr_global_struct;
@@ -58,9 +108,32 @@ void PR_Init(void);
 
 void PR_LoadProgs(void);
 
+void ED_InitEdicts(int maxedicts);
+// sets up the edict store for a new level, allocating the first chunk
+
+void ED_ReserveEdicts(int count);
+// makes sure edict numbers below count can be used
+
+void ED_ClearEdict(edict_t* e);
+// sets all fields to 0 and marks the edict as used
+
+void ED_MirrorEdict(edict_t* ed);
+// copies the mirrored fields to sv.mirror, needed after they were written directly
+
+void ED_SetModelIndex(edict_t* ed, float modelindex);
+void ED_SetMovetype(edict_t* ed, float movetype);
+void ED_SetNextThink(edict_t* ed, float nextthink);
+// modelindex, movetype and nextthink must be assigned through these to keep sv.mirror up to date
+
 edict_t* ED_Alloc(void);
 void ED_Free(edict_t* ed);
 
+void ED_SetClassname(edict_t* ed, const char* classname);
+// sets ed->v.classname, keeping the classname index used by find() up to date
+
+edict_t* ED_FindClassname(int start, const char* classname);
+// returns the first edict after edict number start with the given classname, or NULL
+
 char* ED_NewString(const char* string);
 // returns a copy of the string allocated from the server's string heap
 
@@ -27,6 +27,7 @@ typedef struct
 	int			serverflags;		// episode completion information
 	bool		changelevel_issued;	// cleared when at SV_SpawnServer
 	int spawncount;
+	int			maxedicts;			// -maxedicts, edict limit for every level
 } server_static_t;
 
 //=============================================================================
@@ -56,10 +57,13 @@ typedef struct
 	const char* sound_precache[MAX_SOUNDS];	// NULL terminated
 	const char* lightstyles[MAX_LIGHTSTYLES];
 	int			num_edicts;
-	int			max_edicts;
+	int			max_edicts;			// -maxedicts, no more than MAX_EDICTS
+	int			num_edict_chunks;	// allocated chunks of EDICT_CHUNK_SIZE edicts
+	edict_t** edict_chunks;		// chunks never move, so edict pointers stay valid
 	edict_t* edicts;			// can NOT be array indexed, because
-									// edict_t is variable sized, but can
+									// the edicts are split in chunks, but can
 									// be used to reference the world ent
+	edictmirror_t	mirror;			// [max_edicts] copies of the fields scanned every frame
 	server_state_t	state;			// some actions are only valid during load
 
 	sizebuf_t	datagram;
@@ -68,6 +72,9 @@ typedef struct
 	sizebuf_t	reliable_datagram;	// copied to all clients at end of frame
 	byte		reliable_datagram_buf[MAX_DATAGRAM];
 
+	sizebuf_t	demo_reliable;		// copy of what went to each client's own message, while recording
+	byte		demo_reliable_buf[MAX_MSGLEN];
+
 	sizebuf_t	signon;
 	byte		signon_buf[8192];
 } server_t;
@@ -107,6 +114,9 @@ typedef struct client_s
 
 	// client known data for deltas	
 	int				old_frags;
+
+	int				protocol;			// PROTOCOL_VERSION or PROTOCOL_DELTA
+	int				delta_sequence;		// last svc_packetentities frame acknowledged, 0 if none
 } client_t;
 
 
@@ -202,6 +212,7 @@ extern	cvar_t	deathmatch;
 extern	cvar_t	coop;
 extern	cvar_t	fraglimit;
 extern	cvar_t	timelimit;
+extern	cvar_t	sv_protocol;
 
 extern	server_static_t	svs;				// persistant server info
 extern	server_t		sv;					// local server
@@ -223,8 +234,15 @@ void SV_StartSound(edict_t* entity, int channel, const char* sample, int volume,
 	float attenuation);
 
 void SV_DropClient(bool crash);
+void SV_NewClient(qsocket_t* newClient);
 
 void SV_SendClientMessages(void);
+bool SV_WriteEntitiesToClient(edict_t* clent, sizebuf_t* msg);
+int SV_WriteAllEntities(int start, sizebuf_t* msg);
+void SV_WriteServerinfo(sizebuf_t* msg, int protocol, int viewentity);
+void SV_WriteGameState(sizebuf_t* msg);
+byte* SV_FatPVS(vec3_t org);
+void SV_FatPVSBench_f(void);
 void SV_ClearDatagram(void);
 
 int SV_ModelIndex(const char* name);
@@ -239,16 +257,56 @@ void SV_ClientPrintf(const char* fmt, ...);
 void SV_BroadcastPrintf(const char* fmt, ...);
 
 void SV_Physics(void);
+void SV_ClearThinks(void);
+void SV_ScheduleThink(int entnum, float nextthink);
+void SV_PhysicsBench_f(void);
+void SV_FrameBench_f(void);
+void SV_BotBench_f(void);
 
 bool SV_CheckBottom(edict_t* ent);
 bool SV_movestep(edict_t* ent, vec3_t move, bool relink);
 
 void SV_WriteClientdataToMessage(edict_t* ent, sizebuf_t* msg);
+void SV_WriteClientdata(edict_t* ent, sizebuf_t* msg);
 
 void SV_MoveToGoal(edict_t* ent, float dist);
 
 void SV_RunClients(void);
 void SV_SaveSpawnparms();
+
+typedef enum
+{
+	PROF_FRAME,
+	PROF_NETWORK,
+	PROF_RUNCLIENTS,
+	PROF_STARTFRAME,
+	PROF_PHYSICS,
+	PROF_MOVE_CLIENT,
+	PROF_MOVE_PUSH,
+	PROF_MOVE_NONE,
+	PROF_MOVE_NOCLIP,
+	PROF_MOVE_STEP,
+	PROF_MOVE_TOSS,
+	PROF_MOVE_FOLLOW,
+	PROF_THINK,
+	PROF_SENDMESSAGES,
+	PROF_NUMPHASES
+} profphase_t;
+
+extern bool sv_profiling;
+
+void SV_ProfInit(void);
+void SV_ProfReset(void);
+void SV_ProfBeginTick(void);
+void SV_ProfEndTick(void);
+long long SV_ProfTime(void);		// start time for SV_ProfEnd, 0 when not profiling
+void SV_ProfEnd(profphase_t phase, long long start);
+void SV_ProfThink(edict_t* ent, void (*think)(edict_t*), long long start);
+
+void SV_DemoInit(void);
+void SV_WriteDemoFrame(void);
+void SV_StopDemo(void);
+sizebuf_t* SV_DemoReliable(void);
 #ifdef QUAKE2
 void SV_SpawnServer(const char* server, const char* startspot);
 #else
@@ -0,0 +1,327 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_bench.c -- server throughput benchmark with in-process bot clients
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "quakedef.h"
+
+/*
+Bots connect through loopback sockets, so the server sees them as ordinary
+clients: they go through the signon, their moves are parsed by
+SV_ReadClientMove, and everything the server sends them is counted before
+being thrown away.  They stay on the base protocol, since acknowledging
+PROTOCOL_DELTA frames would mean parsing the entity updates.
+*/
+
+typedef enum
+{
+	BOT_CONNECTED,		// waiting for the serverinfo to go out
+	BOT_PRESPAWN,		// sent prespawn, waiting for the signon data
+	BOT_SPAWN,			// sent spawn, waiting for the client state
+	BOT_BEGIN			// sent begin, moves once the server has spawned it
+} botstage_t;
+
+typedef struct
+{
+	qsocket_t*	socket;			// the bot's end of the connection
+	client_t*	client;
+	botstage_t	stage;
+	long long	received;		// bytes the server sent it
+	float		yaw, turn;
+} benchbot_t;
+
+/*
+================
+SV_BenchHeapUsed
+
+Bytes allocated from the C heap, where the C library can tell
+================
+*/
+static long long SV_BenchHeapUsed(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	return (long long)mallinfo2().uordblks;
+#else
+	return -1;
+#endif
+}
+
+/*
+================
+SV_BenchStringCmd
+================
+*/
+static void SV_BenchStringCmd(benchbot_t* bot, const char* cmd)
+{
+	byte		data[128];
+	sizebuf_t	buf{};
+
+	buf.data = data;
+	buf.maxsize = sizeof(data);
+
+	MSG_WriteByte(&buf, clc_stringcmd);
+	MSG_WriteString(&buf, cmd);
+
+	g_Networking->SendMessage(bot->socket, &buf);
+}
+
+/*
+================
+SV_BenchMove
+
+Runs forward while weaving and turning, jumps now and then and fires in
+bursts.  Each bot has its own phase, so the same bot count and tick count
+always produce the same input.
+================
+*/
+static void SV_BenchMove(benchbot_t* bot, int num, int tick)
+{
+	byte		data[128];
+	sizebuf_t	buf{};
+	int			bits;
+
+	buf.data = data;
+	buf.maxsize = sizeof(data);
+
+	if ((tick + num * 7) % 40 == 0)
+		bot->turn = -bot->turn;
+	bot->yaw = anglemod(bot->yaw + bot->turn);
+
+	bits = 0;
+	if ((tick + num * 5) % 64 < 8)
+		bits |= 1;
+	if ((tick + num * 3) % 50 == 0)
+		bits |= 2;
+
+	MSG_WriteByte(&buf, clc_move);
+	MSG_WriteFloat(&buf, sv.time);
+	MSG_WriteAngle(&buf, 0);
+	MSG_WriteAngle(&buf, bot->yaw);
+	MSG_WriteAngle(&buf, 0);
+	MSG_WriteShort(&buf, 320);
+	MSG_WriteShort(&buf, (int)(350 * sin((tick + num * 11) * 0.1)));
+	MSG_WriteShort(&buf, 0);
+	MSG_WriteByte(&buf, bits);
+	MSG_WriteByte(&buf, 0);
+#ifdef QUAKE2
+	MSG_WriteByte(&buf, 128);
+#endif
+
+	g_Networking->SendUnreliableMessage(bot->socket, &buf);
+}
+
+/*
+================
+SV_BenchBotFrame
+
+Reads what the server sent, then answers like a client would.  The next
+signon command goes out once the server has flushed the previous stage.
+================
+*/
+static void SV_BenchBotFrame(benchbot_t* bot, int num, int tick)
+{
+	char	cmd[64];
+
+	while (g_Networking->GetMessage(bot->socket) > 0)
+		bot->received += net_message.cursize;
+
+	const bool flushed = !bot->client->message.cursize && !bot->client->sendsignon;
+
+	switch (bot->stage)
+	{
+	case BOT_CONNECTED:
+		if (!flushed)
+			break;
+		SV_BenchStringCmd(bot, "prespawn");
+		bot->stage = BOT_PRESPAWN;
+		break;
+
+	case BOT_PRESPAWN:
+		if (!flushed)
+			break;
+		sprintf(cmd, "name bot%i", num);
+		SV_BenchStringCmd(bot, cmd);
+		SV_BenchStringCmd(bot, "spawn");
+		bot->stage = BOT_SPAWN;
+		break;
+
+	case BOT_SPAWN:
+		if (!flushed)
+			break;
+		SV_BenchStringCmd(bot, "begin");
+		bot->stage = BOT_BEGIN;
+		break;
+
+	case BOT_BEGIN:
+		if (bot->client->spawned)
+			SV_BenchMove(bot, num, tick);
+		break;
+	}
+}
+
+/*
+================
+SV_BotBench_f
+
+Connects a number of bots, runs the server for a fixed number of ticks as
+fast as it can, and reports tick times, bytes sent per bot and heap growth.
+Tick times cover the whole Host_ServerFrame, bot work is not counted.
+For a headless run:
+
+quakeds -dedicated 32 +map e1m1 +sv_botbench 24 2000 +quit
+
+sv_botbench [bots] [ticks]
+================
+*/
+void SV_BotBench_f(void)
+{
+	int			i, numbots, ticks, freeslots, spawned;
+	long long	heapstart, received;
+	double		total, interval;
+	float		save_frametime;
+	client_t* save_client;
+	qsocket_t* serversocket;
+	std::vector<benchbot_t>	bots;
+	std::vector<double>		times;
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_botbench: no map running\n");
+		return;
+	}
+
+	numbots = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 16;
+	ticks = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 1000;
+	if (ticks < 1)
+		ticks = 1;
+
+	freeslots = 0;
+	for (i = 0; i < svs.maxclients; i++)
+	{
+		if (!svs.clients[i].active)
+			freeslots++;
+	}
+
+	if (numbots > freeslots)
+	{
+		Con_Printf("only %i free client slots, use -dedicated <maxplayers> to raise the limit\n", freeslots);
+		numbots = freeslots;
+	}
+
+	if (numbots < 1)
+		return;
+
+	for (i = 0; i < numbots; i++)
+	{
+		benchbot_t	bot{};
+
+		bot.socket = g_Networking->ConnectLoopback(&serversocket);
+		SV_NewClient(serversocket);
+
+		bot.client = std::find_if(svs.clients, svs.clients + svs.maxclients, [&](const client_t& cl)
+			{
+				return cl.active && cl.netconnection == serversocket;
+			});
+		bot.stage = BOT_CONNECTED;
+		bot.yaw = i * 360.0f / numbots;
+		bot.turn = 1 + (i % 4);
+
+		bots.push_back(bot);
+	}
+
+	save_frametime = host_frametime;
+	interval = std::max(sys_ticrate.value, 0.001f);
+	host_frametime = interval;
+
+	times.reserve(ticks);
+	heapstart = SV_BenchHeapUsed();
+
+	for (i = 0; i < ticks && sv.active; i++)
+	{
+		for (int j = 0; j < numbots; j++)
+			SV_BenchBotFrame(&bots[j], j, i);
+
+		const auto start = std::chrono::steady_clock::now();
+		const int scratchmark = Scratch_Mark();		// all the ticks run inside one host frame
+
+		SV_ProfBeginTick();
+		Host_ServerFrame();
+		SV_ProfEndTick();
+
+		Scratch_FreeToMark(scratchmark);
+
+		times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	const long long heapgrowth = SV_BenchHeapUsed() - heapstart;
+
+	host_frametime = save_frametime;
+
+	// disconnect the bots
+	save_client = host_client;
+	spawned = 0;
+	received = 0;
+
+	for (auto& bot : bots)
+	{
+		if (bot.client->spawned)
+			spawned++;
+		received += bot.received;
+
+		if (bot.client->active && bot.client->netconnection)
+		{
+			host_client = bot.client;
+			SV_DropClient(false);
+		}
+
+		g_Networking->Close(bot.socket);
+	}
+
+	host_client = save_client;
+
+	if (times.empty())
+		return;
+
+	total = 0;
+	for (auto time : times)
+		total += time;
+
+	std::sort(times.begin(), times.end());
+
+	const int count = (int)times.size();
+
+	Con_Printf("%i ticks of %.1f ms, %i bots (%i spawned), %i edicts\n", count, interval * 1000, numbots, spawned, sv.num_edicts);
+	Con_Printf("%.1f ticks/sec\n", count / total);
+	Con_Printf("tick: %.3f ms avg, %.3f ms p50, %.3f ms p99, %.3f ms max\n",
+		total * 1000 / count, times[count / 2] * 1000, times[count * 99 / 100] * 1000, times[count - 1] * 1000);
+	Con_Printf("sent %.0f bytes per bot, %.1f per bot per tick\n",
+		(double)received / numbots, (double)received / numbots / count);
+
+	if (heapstart >= 0)
+		Con_Printf("heap grew %lli bytes\n", heapgrowth);
+}
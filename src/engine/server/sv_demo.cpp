@@ -0,0 +1,461 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_demo.c -- server side demo recording
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "quakedef.h"
+
+/*
+Server demos use the client demo format, so they play back with
+playdemo.  Every tick is written once from the server's view: all
+entities with a model whatever the PVS, the broadcast reliable and
+unreliable messages, what was sent to every client one at a time (frags,
+light styles, prints), and the client data of the first spawned player,
+whom playback follows.
+
+A tick starts with svc_time.  When it doesn't fit in one message the rest
+go in messages that start with svc_nop instead, which playback reads
+straight away rather than waiting for the next time.
+
+Every sv_demokeyframe seconds a keyframe restates the names, frags, colors,
+light styles and level stats.  Entity updates are always relative to the
+baselines, so the signon messages at the start of the file plus any
+keyframe are a complete state.  <demo>.dmi lists "time offset" for each
+keyframe, so a player can seek by reading the signon and then jumping to
+the nearest keyframe.
+
+The tick only builds the messages.  A writer thread does the file IO, so
+a slow disk never stalls the server.
+*/
+
+cvar_t	sv_demokeyframe = {"sv_demokeyframe", "10"};	// seconds between keyframes
+
+#define	DEMO_FILEBUFFER	(1024 * 1024)
+
+typedef struct
+{
+	std::vector<byte>	data;
+	bool				index;		// goes to the keyframe index instead of the demo
+} demowrite_t;
+
+static FILE* sv_demofile;
+static FILE* sv_demoindex;
+
+static std::thread				sv_demothread;
+static std::mutex				sv_demolock;
+static std::condition_variable	sv_demowake;
+static std::vector<demowrite_t>	sv_demoqueue;
+static bool						sv_demostop;
+
+static long long	sv_demooffset;		// bytes queued for the demo file so far
+static double		sv_demonextkey;
+static int			sv_demoview;		// client slot playback follows, -1 for none
+
+/*
+================
+SV_DemoWriter
+
+Writer thread, exits once stopped and drained
+================
+*/
+static void SV_DemoWriter(void)
+{
+	std::vector<demowrite_t>	writing;
+
+	while (1)
+	{
+		{
+			std::unique_lock<std::mutex> lock(sv_demolock);
+
+			sv_demowake.wait(lock, []() { return sv_demostop || !sv_demoqueue.empty(); });
+
+			writing.swap(sv_demoqueue);
+
+			if (writing.empty())
+				break;		// stopped, and everything is written
+		}
+
+		for (auto& write : writing)
+			fwrite(write.data.data(), 1, write.data.size(), write.index ? sv_demoindex : sv_demofile);
+
+		writing.clear();
+	}
+}
+
+/*
+================
+SV_DemoQueue
+================
+*/
+static void SV_DemoQueue(std::vector<byte>&& data, bool index)
+{
+	if (data.empty())
+		return;
+
+	if (!index)
+		sv_demooffset += data.size();
+
+	{
+		std::lock_guard<std::mutex> lock(sv_demolock);
+		sv_demoqueue.push_back({std::move(data), index});
+	}
+
+	sv_demowake.notify_one();
+}
+
+/*
+================
+SV_DemoMessage
+
+Adds msg as a demo message to out and clears it
+================
+*/
+static void SV_DemoMessage(std::vector<byte>& out, sizebuf_t* msg)
+{
+	int		i, len;
+	float	f;
+	vec3_t	angles;
+
+	if (!msg->cursize)
+		return;
+
+	if (sv_demoview >= 0 && svs.clients[sv_demoview].active)
+	{
+		VectorCopy(svs.clients[sv_demoview].edict->v.v_angle, angles);
+	}
+	else
+	{
+		VectorCopy(vec3_origin, angles);
+	}
+
+	len = LittleLong(msg->cursize);
+	out.insert(out.end(), (byte*)&len, (byte*)&len + 4);
+
+	for (i = 0; i < 3; i++)
+	{
+		f = LittleFloat(angles[i]);
+		out.insert(out.end(), (byte*)&f, (byte*)&f + 4);
+	}
+
+	out.insert(out.end(), msg->data, msg->data + msg->cursize);
+
+	SZ_Clear(msg);
+}
+
+/*
+================
+SV_DemoFindView
+
+The first spawned player, since playback needs someone to look through
+================
+*/
+static int SV_DemoFindView(void)
+{
+	int		i;
+
+	for (i = 0; i < svs.maxclients; i++)
+	{
+		if (svs.clients[i].active && svs.clients[i].spawned)
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+================
+SV_DemoSplit
+
+Ends the message that holds the tick so far, the rest of the tick carries on
+in a message of its own
+================
+*/
+static void SV_DemoSplit(std::vector<byte>& out, sizebuf_t* msg)
+{
+	SV_DemoMessage(out, msg);
+	MSG_WriteByte(msg, svc_nop);
+}
+
+/*
+================
+SV_DemoWrite
+
+Adds buf to the tick, splitting first if it doesn't fit
+================
+*/
+static void SV_DemoWrite(std::vector<byte>& out, sizebuf_t* msg, sizebuf_t* buf)
+{
+	if (msg->cursize + buf->cursize > msg->maxsize)
+		SV_DemoSplit(out, msg);
+	SZ_Write(msg, buf->data, buf->cursize);
+}
+
+/*
+================
+SV_DemoReliable
+
+Messages written to every client's own reliable stream also go here while
+recording, so the demo gets one copy.  NULL when not recording
+================
+*/
+sizebuf_t* SV_DemoReliable(void)
+{
+	return sv_demofile ? &sv.demo_reliable : NULL;
+}
+
+/*
+================
+SV_WriteDemoFrame
+
+Called once per tick from SV_SendClientMessages, before the broadcast
+messages are cleared
+================
+*/
+void SV_WriteDemoFrame(void)
+{
+	static byte	data[MAX_MSGLEN];
+	sizebuf_t	msg{};
+	std::vector<byte>	out;
+	char		line[64];
+	int			e;
+
+	if (!sv_demofile)
+		return;
+
+	msg.data = data;
+	msg.maxsize = sizeof(data);
+
+	// the keyframe index points at the message that starts the tick
+	if (sv.time >= sv_demonextkey)
+	{
+		sprintf(line, "%.3f %lld\n", sv.time, sv_demooffset);
+		SV_DemoQueue(std::vector<byte>(line, line + strlen(line)), true);
+	}
+
+	MSG_WriteByte(&msg, svc_time);
+	MSG_WriteFloat(&msg, sv.time);
+
+	// playback follows the first player, switch when they leave
+	if (sv_demoview < 0 || !svs.clients[sv_demoview].active || !svs.clients[sv_demoview].spawned)
+	{
+		sv_demoview = SV_DemoFindView();
+		if (sv_demoview >= 0)
+		{
+			MSG_WriteByte(&msg, svc_setview);
+			MSG_WriteShort(&msg, sv_demoview + 1);
+		}
+	}
+
+	if (sv.time >= sv_demonextkey)
+	{
+		sv_demonextkey = sv.time + std::max(sv_demokeyframe.value, 1.f);
+
+		SV_WriteGameState(&msg);
+		SV_DemoSplit(out, &msg);
+	}
+
+	SV_DemoWrite(out, &msg, &sv.reliable_datagram);
+
+	if (sv.demo_reliable.overflowed)
+		Con_DPrintf("SV_WriteDemoFrame: dropped reliable messages\n");
+	else
+		SV_DemoWrite(out, &msg, &sv.demo_reliable);
+	sv.demo_reliable.overflowed = false;
+	SZ_Clear(&sv.demo_reliable);
+
+	// the client's own update is built after this and clears the damage and
+	// fixangle, so only read them here
+	if (sv_demoview >= 0)
+	{
+		if (msg.cursize + MAX_DATAGRAM > msg.maxsize)
+			SV_DemoSplit(out, &msg);
+		SV_WriteClientdata(svs.clients[sv_demoview].edict, &msg);
+	}
+
+	// entities that don't fit continue in the next message
+	for (e = SV_WriteAllEntities(1, &msg); e < sv.num_edicts; e = SV_WriteAllEntities(e, &msg))
+		SV_DemoSplit(out, &msg);
+
+	SV_DemoWrite(out, &msg, &sv.datagram);
+
+	SV_DemoMessage(out, &msg);
+
+	SV_DemoQueue(std::move(out), false);
+}
+
+/*
+================
+SV_StopDemo
+================
+*/
+void SV_StopDemo(void)
+{
+	byte		data[4];
+	sizebuf_t	msg{};
+	std::vector<byte>	out;
+
+	if (!sv_demofile)
+		return;
+
+	msg.data = data;
+	msg.maxsize = sizeof(data);
+
+	MSG_WriteByte(&msg, svc_disconnect);
+	SV_DemoMessage(out, &msg);
+	SV_DemoQueue(std::move(out), false);
+
+	{
+		std::lock_guard<std::mutex> lock(sv_demolock);
+		sv_demostop = true;
+	}
+
+	sv_demowake.notify_one();
+	sv_demothread.join();
+
+	fclose(sv_demofile);
+	fclose(sv_demoindex);
+	sv_demofile = NULL;
+	sv_demoindex = NULL;
+
+	Con_Printf("Completed server demo, %lli bytes\n", sv_demooffset);
+}
+
+/*
+================
+SV_Record_f
+
+sv_record <demoname>
+================
+*/
+static void SV_Record_f(void)
+{
+	static byte	data[sizeof(sv.signon_buf) + 2];
+	sizebuf_t	msg{};
+	std::vector<byte>	out;
+	char		name[MAX_OSPATH];
+	char		indexname[MAX_OSPATH];
+	char		track[16];
+
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf("sv_record <demoname>\n");
+		return;
+	}
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_record: no map running\n");
+		return;
+	}
+
+	if (strstr(Cmd_Argv(1), ".."))
+	{
+		Con_Printf("Relative pathnames are not allowed.\n");
+		return;
+	}
+
+	SV_StopDemo();
+
+	sprintf(name, "%s/%s", com_gamedir, Cmd_Argv(1));
+	COM_DefaultExtension(name, ".dem");
+	COM_StripExtension(name, indexname);
+	strcat(indexname, ".dmi");
+
+	Con_Printf("recording to %s.\n", name);
+
+	sv_demofile = fopen(name, "wb");
+	sv_demoindex = sv_demofile ? fopen(indexname, "w") : NULL;
+
+	if (!sv_demoindex)
+	{
+		Con_Printf("ERROR: couldn't open.\n");
+		if (sv_demofile)
+			fclose(sv_demofile);
+		sv_demofile = NULL;
+		return;
+	}
+
+	setvbuf(sv_demofile, NULL, _IOFBF, DEMO_FILEBUFFER);
+
+	sv_demostop = false;
+	sv_demooffset = 0;
+	sv_demonextkey = sv.time;
+	sv_demoview = SV_DemoFindView();
+	SZ_Clear(&sv.demo_reliable);
+	sv.demo_reliable.overflowed = false;
+
+	sv_demothread = std::thread(SV_DemoWriter);
+
+	// the same signon a connecting client gets
+	sprintf(track, "%i\n", -1);
+	out.insert(out.end(), track, track + strlen(track));
+
+	msg.data = data;
+	msg.maxsize = sizeof(data);
+
+	SV_WriteServerinfo(&msg, PROTOCOL_VERSION, sv_demoview >= 0 ? sv_demoview + 1 : 1);
+	SV_DemoMessage(out, &msg);
+
+	SZ_Write(&msg, sv.signon.data, sv.signon.cursize);
+	MSG_WriteByte(&msg, svc_signonnum);
+	MSG_WriteByte(&msg, 2);
+	SV_DemoMessage(out, &msg);
+
+	MSG_WriteByte(&msg, svc_time);
+	MSG_WriteFloat(&msg, sv.time);
+	SV_WriteGameState(&msg);
+	MSG_WriteByte(&msg, svc_signonnum);
+	MSG_WriteByte(&msg, 3);
+	SV_DemoMessage(out, &msg);
+
+	SV_DemoQueue(std::move(out), false);
+}
+
+/*
+================
+SV_StopRecord_f
+================
+*/
+static void SV_StopRecord_f(void)
+{
+	if (!sv_demofile)
+	{
+		Con_Printf("Not recording a server demo.\n");
+		return;
+	}
+
+	SV_StopDemo();
+}
+
+/*
+================
+SV_DemoInit
+================
+*/
+void SV_DemoInit(void)
+{
+	Cvar_RegisterVariable(&sv_demokeyframe);
+	Cmd_AddCommand("sv_record", SV_Record_f);
+	Cmd_AddCommand("sv_stoprecord", SV_StopRecord_f);
+}
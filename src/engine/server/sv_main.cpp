@@ -19,6 +19,15 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // sv_main.c -- server main program
 
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define	SV_PVS_SSE2
+#endif
+
 #include "quakedef.h"
 #include "game/IGame.h"
 
@@ -27,6 +36,8 @@ server_static_t	svs;
 
 char	localmodels[MAX_MODELS][5];			// inline model names for precache
 
+static void SV_ClearFatPVSCache(client_t* client);
+
 //============================================================================
 
 /*
@@ -47,6 +58,10 @@ void SV_Init(void)
 	extern	cvar_t	sv_accelerate;
 	extern	cvar_t	sv_idealpitchscale;
 	extern	cvar_t	sv_aim;
+	extern	cvar_t	sv_broadphase;
+	extern	cvar_t	sv_tracememo;
+	extern	cvar_t	sv_parallelsend;
+	extern	cvar_t	sv_pvsbudget;
 
 	Cvar_RegisterVariable(&sv_maxvelocity);
 	Cvar_RegisterVariable(&sv_gravity);
@@ -58,9 +73,29 @@ void SV_Init(void)
 	Cvar_RegisterVariable(&sv_idealpitchscale);
 	Cvar_RegisterVariable(&sv_aim);
 	Cvar_RegisterVariable(&sv_nostep);
+	Cvar_RegisterVariable(&sv_broadphase);
+	Cvar_RegisterVariable(&sv_tracememo);
+	Cvar_RegisterVariable(&sv_parallelsend);
+	Cvar_RegisterVariable(&sv_protocol);
+	Cvar_RegisterVariable(&sv_pvsbudget);
+
+	Cmd_AddCommand("sv_broadphasebench", SV_BroadphaseBench_f);
+	Cmd_AddCommand("sv_tracebench", SV_TraceBench_f);
+	Cmd_AddCommand("sv_physicsbench", SV_PhysicsBench_f);
+	Cmd_AddCommand("sv_framebench", SV_FrameBench_f);
+	Cmd_AddCommand("sv_fatpvsbench", SV_FatPVSBench_f);
+	Cmd_AddCommand("sv_botbench", SV_BotBench_f);
+
+	SV_ProfInit();
+	SV_DemoInit();
 
 	for (i = 0; i < MAX_MODELS; i++)
 		sprintf(localmodels[i], "*%i", i);
+
+	svs.maxedicts = MAX_EDICTS;
+	i = COM_CheckParm("-maxedicts");
+	if (i && i < com_argc - 1)
+		svs.maxedicts = std::clamp(Q_atoi(com_argv[i + 1]), EDICT_CHUNK_SIZE, MAX_EDICTS);
 }
 
 /*
@@ -179,61 +214,290 @@ CLIENT SPAWNING
 ==============================================================================
 */
 
+/*
+=============================================================================
+
+DELTA FRAMES
+
+Clients that negotiated PROTOCOL_DELTA get their entities as
+svc_packetentities frames, deltaed against the last frame they acknowledged
+in clc_move.  Entities that didn't change since then aren't sent at all.
+
+=============================================================================
+*/
+
+// the largest entity written by SV_WriteDeltaEntity
+#define	MAX_PACKETENTITY_BYTES	18
+
+cvar_t	sv_protocol = {"sv_protocol", "16"};	// highest protocol offered to clients
+
+typedef struct
+{
+	int				sequence;		// of the last frame built
+	packet_frame_t	frames[UPDATE_BACKUP];
+} clientframes_t;
+
+static std::vector<clientframes_t>	sv_clientframes;	// [maxclients]
+
 /*
 ================
-SV_SendServerinfo
+SV_ClearClientFrames
+================
+*/
+static void SV_ClearClientFrames(client_t* client)
+{
+	int		i;
 
-Sends the first message from the server to a connected client.
-This will be sent on the initial connection and upon each server load.
+	if ((int)sv_clientframes.size() < svs.maxclients)
+		sv_clientframes.resize(svs.maxclients);
+
+	auto& frames = sv_clientframes[client - svs.clients];
+
+	frames.sequence = 0;
+	for (i = 0; i < UPDATE_BACKUP; i++)
+	{
+		frames.frames[i].sequence = 0;
+		frames.frames[i].entities.clear();
+	}
+
+	client->delta_sequence = 0;
+}
+
+/*
+================
+SV_EntityState
 ================
 */
-void SV_SendServerinfo(client_t* client)
+static void SV_EntityState(edict_t* ent, packet_entity_t* pe)
+{
+	pe->number = ent->entnum;
+	pe->nolerp = ent->v.movetype == MOVETYPE_STEP;	// don't mess up the step animation
+	VectorCopy(ent->v.origin, pe->state.origin);
+	VectorCopy(ent->v.angles, pe->state.angles);
+	pe->state.modelindex = ent->v.modelindex;
+	pe->state.frame = ent->v.frame;
+	pe->state.colormap = ent->v.colormap;
+	pe->state.skin = ent->v.skin;
+	pe->state.effects = ent->v.effects;
+}
+
+/*
+================
+SV_WriteDeltaEntity
+
+Writes the fields of to that differ from from, and leaves the state the
+client will have after reading them in out.  Returns false if nothing had to
+be sent.
+================
+*/
+static bool SV_WriteDeltaEntity(const packet_entity_t* from, const packet_entity_t* to,
+	packet_entity_t* out, bool force, sizebuf_t* msg)
+{
+	int		i;
+	int		bits;
+	float	miss;
+
+	*out = *from;
+	out->number = to->number;
+
+	bits = 0;
+
+	for (i = 0; i < 3; i++)
+	{
+		miss = to->state.origin[i] - from->state.origin[i];
+		if (miss < -0.1 || miss > 0.1)
+		{
+			bits |= U_ORIGIN1 << i;
+			out->state.origin[i] = to->state.origin[i];
+		}
+	}
+
+	if (to->state.angles[0] != from->state.angles[0])
+		bits |= U_ANGLE1;
+
+	if (to->state.angles[1] != from->state.angles[1])
+		bits |= U_ANGLE2;
+
+	if (to->state.angles[2] != from->state.angles[2])
+		bits |= U_ANGLE3;
+
+	if (to->state.colormap != from->state.colormap)
+		bits |= U_COLORMAP;
+
+	if (to->state.skin != from->state.skin)
+		bits |= U_SKIN;
+
+	if (to->state.frame != from->state.frame)
+		bits |= U_FRAME;
+
+	if (to->state.effects != from->state.effects)
+		bits |= U_EFFECTS;
+
+	if (to->state.modelindex != from->state.modelindex)
+		bits |= U_MODEL;
+
+	if (!bits && !force && to->nolerp == from->nolerp)
+		return false;
+
+	// the flag is resent with every update, an omitted entity keeps it
+	out->nolerp = to->nolerp;
+	if (to->nolerp)
+		bits |= U_NOLERP;
+
+	MSG_WriteShort(msg, to->number);
+	MSG_WriteShort(msg, bits);
+
+	if (bits & U_MODEL)
+		MSG_WriteByte(msg, out->state.modelindex = to->state.modelindex);
+	if (bits & U_FRAME)
+		MSG_WriteByte(msg, out->state.frame = to->state.frame);
+	if (bits & U_COLORMAP)
+		MSG_WriteByte(msg, out->state.colormap = to->state.colormap);
+	if (bits & U_SKIN)
+		MSG_WriteByte(msg, out->state.skin = to->state.skin);
+	if (bits & U_EFFECTS)
+		MSG_WriteByte(msg, out->state.effects = to->state.effects);
+	if (bits & U_ORIGIN1)
+		MSG_WriteCoord(msg, to->state.origin[0]);
+	if (bits & U_ANGLE1)
+		MSG_WriteAngle(msg, out->state.angles[0] = to->state.angles[0]);
+	if (bits & U_ORIGIN2)
+		MSG_WriteCoord(msg, to->state.origin[1]);
+	if (bits & U_ANGLE2)
+		MSG_WriteAngle(msg, out->state.angles[1] = to->state.angles[1]);
+	if (bits & U_ORIGIN3)
+		MSG_WriteCoord(msg, to->state.origin[2]);
+	if (bits & U_ANGLE3)
+		MSG_WriteAngle(msg, out->state.angles[2] = to->state.angles[2]);
+
+	return true;
+}
+
+/*
+================
+SV_WriteServerinfo
+
+The first signon message: server info, precache lists, music and view
+================
+*/
+void SV_WriteServerinfo(sizebuf_t* msg, int protocol, int viewentity)
 {
 	const char** s;
 	char			message[2048];
 
-	MSG_WriteByte(&client->message, svc_print);
+	MSG_WriteByte(msg, svc_print);
 	sprintf(message, "%c\nVERSION %4.2f SERVER", 2, VERSION);
-	MSG_WriteString(&client->message, message);
+	MSG_WriteString(msg, message);
 
-	MSG_WriteByte(&client->message, svc_serverinfo);
-	MSG_WriteLong(&client->message, PROTOCOL_VERSION);
-	MSG_WriteByte(&client->message, svs.maxclients);
+	MSG_WriteByte(msg, svc_serverinfo);
+	MSG_WriteLong(msg, protocol);
+	MSG_WriteByte(msg, svs.maxclients);
 
 	if (!coop.value && deathmatch.value)
-		MSG_WriteByte(&client->message, GAME_DEATHMATCH);
+		MSG_WriteByte(msg, GAME_DEATHMATCH);
 	else
-		MSG_WriteByte(&client->message, GAME_COOP);
+		MSG_WriteByte(msg, GAME_COOP);
 
 	strncpy(message, sv.edicts->v.message, sizeof(message) - 1);
 	message[sizeof(message) - 1] = '\0';
 
-	MSG_WriteString(&client->message, message);
+	MSG_WriteString(msg, message);
 
 	for (s = sv.model_precache + 1; *s; s++)
-		MSG_WriteString(&client->message, *s);
-	MSG_WriteByte(&client->message, 0);
+		MSG_WriteString(msg, *s);
+	MSG_WriteByte(msg, 0);
 
 	for (s = sv.sound_precache + 1; *s; s++)
-		MSG_WriteString(&client->message, *s);
-	MSG_WriteByte(&client->message, 0);
+		MSG_WriteString(msg, *s);
+	MSG_WriteByte(msg, 0);
 
 	// send music
-	MSG_WriteByte(&client->message, svc_cdtrack);
-	MSG_WriteByte(&client->message, sv.edicts->v.sounds);
-	MSG_WriteByte(&client->message, sv.edicts->v.sounds);
+	MSG_WriteByte(msg, svc_cdtrack);
+	MSG_WriteByte(msg, sv.edicts->v.sounds);
+	MSG_WriteByte(msg, sv.edicts->v.sounds);
 
 	// set view	
-	MSG_WriteByte(&client->message, svc_setview);
-	MSG_WriteShort(&client->message, NUM_FOR_EDICT(client->edict));
+	MSG_WriteByte(msg, svc_setview);
+	MSG_WriteShort(msg, viewentity);
+
+	MSG_WriteByte(msg, svc_signonnum);
+	MSG_WriteByte(msg, 1);
+}
+
+/*
+================
+SV_SendServerinfo
 
-	MSG_WriteByte(&client->message, svc_signonnum);
-	MSG_WriteByte(&client->message, 1);
+Sends the first message from the server to a connected client.
+This will be sent on the initial connection and upon each server load.
+================
+*/
+void SV_SendServerinfo(client_t* client)
+{
+	// a new level starts the delta frames over
+	SV_ClearClientFrames(client);
+	SV_ClearFatPVSCache(client);
+
+	SV_WriteServerinfo(&client->message, client->protocol, NUM_FOR_EDICT(client->edict));
 
 	client->sendsignon = true;
 	client->spawned = false;		// need prespawn, spawn, etc
 }
 
+/*
+================
+SV_WriteGameState
+
+Current names, colors, frag counts, light styles and level stats, for a
+client that is spawning and for demo keyframes
+================
+*/
+void SV_WriteGameState(sizebuf_t* msg)
+{
+	int			i;
+	client_t* client;
+
+	for (i = 0, client = svs.clients; i < svs.maxclients; i++, client++)
+	{
+		MSG_WriteByte(msg, svc_updatename);
+		MSG_WriteByte(msg, i);
+		MSG_WriteString(msg, client->name);
+		MSG_WriteByte(msg, svc_updatefrags);
+		MSG_WriteByte(msg, i);
+		MSG_WriteShort(msg, client->old_frags);
+		MSG_WriteByte(msg, svc_updatecolors);
+		MSG_WriteByte(msg, i);
+		MSG_WriteByte(msg, client->colors);
+	}
+
+	// send all current light styles
+	for (i = 0; i < MAX_LIGHTSTYLES; i++)
+	{
+		MSG_WriteByte(msg, svc_lightstyle);
+		MSG_WriteByte(msg, (char)i);
+		MSG_WriteString(msg, sv.lightstyles[i]);
+	}
+
+	//
+	// send some stats
+	//
+	MSG_WriteByte(msg, svc_updatestat);
+	MSG_WriteByte(msg, STAT_TOTALSECRETS);
+	MSG_WriteLong(msg, pr_global_struct->total_secrets);
+
+	MSG_WriteByte(msg, svc_updatestat);
+	MSG_WriteByte(msg, STAT_TOTALMONSTERS);
+	MSG_WriteLong(msg, pr_global_struct->total_monsters);
+
+	MSG_WriteByte(msg, svc_updatestat);
+	MSG_WriteByte(msg, STAT_SECRETS);
+	MSG_WriteLong(msg, pr_global_struct->found_secrets);
+
+	MSG_WriteByte(msg, svc_updatestat);
+	MSG_WriteByte(msg, STAT_MONSTERS);
+	MSG_WriteLong(msg, pr_global_struct->killed_monsters);
+}
+
 /*
 ================
 SV_ConnectClient
@@ -274,6 +538,7 @@ void SV_ConnectClient(int clientnum)
 	client->message.allowoverflow = true;		// we can catch it
 
 	client->privileged = false;
+	client->protocol = PROTOCOL_VERSION;	// until the client asks for more
 
 	if (sv.loadgame)
 		memcpy(client->spawn_parms, spawn_parms, sizeof(spawn_parms));
@@ -332,202 +597,892 @@ void SV_ClearDatagram(void)
 	SZ_Clear(&sv.datagram);
 }
 
-/*
-=============================================================================
+/*
+=============================================================================
+
+The PVS must include a small area around the client to allow head bobbing
+or other small motion on the client side.  Otherwise, a bob might cause an
+entity that should be visible to not show up, especially when the bob
+crosses a waterline.
+
+=============================================================================
+*/
+
+/*
+The leaf PVS rows are decompressed once per map into sv_pvsmatrix, padded to
+64 bit words so they can be ORed a word (or two with SSE2) at a time.  Maps
+whose matrix would exceed sv_pvsbudget megabytes keep only the most recently
+used rows, decompressing the others on demand.
+*/
+
+cvar_t	sv_pvsbudget = {"sv_pvsbudget", "32"};	// megabytes for decompressed PVS rows
+
+#define	MAX_PVS_WORDS	(MAX_MAP_LEAFS / 64)
+
+static model_t* sv_pvsmodel;			// the matrix was built for this model
+static int		sv_pvswords;			// words per row
+static std::vector<uint64_t>	sv_pvsmatrix;	// [numleafs + 1][sv_pvswords], or the LRU slots
+
+// LRU fallback for maps that don't fit in the budget
+static bool		sv_pvslru;
+static std::vector<int>	sv_pvsslot;		// [numleafs + 1] slot holding the row, or -1
+static std::vector<int>	sv_pvsslotleaf;	// [slots] leaf in the slot, or -1
+static std::vector<int>	sv_pvsprev, sv_pvsnext;	// [slots] recently used list, head is newest
+static int		sv_pvshead, sv_pvstail;
+static std::mutex	sv_pvsmutex;		// the send jobs share the LRU
+
+/*
+================
+SV_DecompressPVSRow
+================
+*/
+static void SV_DecompressPVSRow(model_t* model, int leafnum, uint64_t* row)
+{
+	Q_memset(row, 0, sv_pvswords * sizeof(*row));
+	Q_memcpy(row, Mod_LeafPVS(model->leafs + leafnum, model), (model->numleafs + 7) >> 3);
+}
+
+/*
+================
+SV_BuildPVSMatrix
+
+Called at map load
+================
+*/
+static void SV_BuildPVSMatrix(model_t* model)
+{
+	int			i, rows, slots;
+	size_t		budget;
+
+	sv_pvsmodel = model;
+	sv_pvswords = (model->numleafs + 63) >> 6;
+	rows = model->numleafs + 1;
+
+	budget = (size_t)(std::max(sv_pvsbudget.value, 0.f) * 1024 * 1024);
+	slots = (int)std::min<size_t>(budget / (sv_pvswords * sizeof(uint64_t)), rows);
+
+	sv_pvslru = slots < rows;
+
+	if (!sv_pvslru)
+	{
+		sv_pvsmatrix.assign((size_t)rows * sv_pvswords, 0);
+		for (i = 0; i < rows; i++)
+			SV_DecompressPVSRow(model, i, &sv_pvsmatrix[(size_t)i * sv_pvswords]);
+
+		sv_pvsslot.clear();
+		sv_pvsslotleaf.clear();
+		sv_pvsprev.clear();
+		sv_pvsnext.clear();
+		return;
+	}
+
+	// always keep a few rows, a fat pvs can touch several leafs
+	slots = std::max(slots, 16);
+
+	Con_DPrintf("PVS matrix for %s needs %i rows, caching %i\n", model->name, rows, slots);
+
+	sv_pvsmatrix.assign((size_t)slots * sv_pvswords, 0);
+	sv_pvsslot.assign(rows, -1);
+	sv_pvsslotleaf.assign(slots, -1);
+	sv_pvsprev.resize(slots);
+	sv_pvsnext.resize(slots);
+	for (i = 0; i < slots; i++)
+	{
+		sv_pvsprev[i] = i - 1;
+		sv_pvsnext[i] = i + 1 < slots ? i + 1 : -1;
+	}
+	sv_pvshead = 0;
+	sv_pvstail = slots - 1;
+}
+
+/*
+================
+SV_TouchPVSSlot
+
+Moves a slot to the head of the recently used list
+================
+*/
+static void SV_TouchPVSSlot(int slot)
+{
+	if (slot == sv_pvshead)
+		return;
+
+	// unlink
+	sv_pvsnext[sv_pvsprev[slot]] = sv_pvsnext[slot];
+	if (sv_pvsnext[slot] != -1)
+		sv_pvsprev[sv_pvsnext[slot]] = sv_pvsprev[slot];
+	else
+		sv_pvstail = sv_pvsprev[slot];
+
+	// link at the head
+	sv_pvsprev[slot] = -1;
+	sv_pvsnext[slot] = sv_pvshead;
+	sv_pvsprev[sv_pvshead] = slot;
+	sv_pvshead = slot;
+}
+
+/*
+================
+SV_OrWords
+
+dest |= src
+================
+*/
+static void SV_OrWords(uint64_t* dest, const uint64_t* src, int words)
+{
+	int		i = 0;
+
+#ifdef SV_PVS_SSE2
+	for (; i + 2 <= words; i += 2)
+	{
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + i));
+		const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_or_si128(d, s));
+	}
+#endif
+
+	for (; i < words; i++)
+		dest[i] |= src[i];
+}
+
+/*
+================
+SV_OrLeafPVS
+
+dest |= the PVS of the leaf
+================
+*/
+static void SV_OrLeafPVS(uint64_t* dest, int leafnum)
+{
+	int		slot;
+
+	if (!sv_pvslru)
+	{
+		SV_OrWords(dest, &sv_pvsmatrix[(size_t)leafnum * sv_pvswords], sv_pvswords);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(sv_pvsmutex);
+
+	slot = sv_pvsslot[leafnum];
+	if (slot == -1)
+	{
+		// take over the least recently used row
+		slot = sv_pvstail;
+		if (sv_pvsslotleaf[slot] != -1)
+			sv_pvsslot[sv_pvsslotleaf[slot]] = -1;
+		sv_pvsslotleaf[slot] = leafnum;
+		sv_pvsslot[leafnum] = slot;
+		SV_DecompressPVSRow(sv_pvsmodel, leafnum, &sv_pvsmatrix[(size_t)slot * sv_pvswords]);
+	}
+
+	SV_TouchPVSSlot(slot);
+	SV_OrWords(dest, &sv_pvsmatrix[(size_t)slot * sv_pvswords], sv_pvswords);
+}
+
+/*
+================
+SV_FindFatPVSLeafs
+
+Collects the non solid leafs within 8 units of org
+================
+*/
+static void SV_FindFatPVSLeafs(vec3_t org, mnode_t* node, std::vector<int>& leafs)
+{
+	mplane_t* plane;
+	float	d;
+
+	while (1)
+	{
+		// if this is a leaf, accumulate the pvs bits
+		if (node->contents < 0)
+		{
+			if (node->contents != CONTENTS_SOLID)
+				leafs.push_back((mleaf_t*)node - sv.worldmodel->leafs);
+			return;
+		}
+
+		plane = node->plane;
+		d = DotProduct(org, plane->normal) - plane->dist;
+		if (d > 8)
+			node = node->children[0];
+		else if (d < -8)
+			node = node->children[1];
+		else
+		{	// go down both
+			SV_FindFatPVSLeafs(org, node->children[0], leafs);
+			node = node->children[1];
+		}
+	}
+}
+
+/*
+================
+SV_BuildFatPVS
+================
+*/
+static void SV_BuildFatPVS(const std::vector<int>& leafs, uint64_t* pvs)
+{
+	Q_memset(pvs, 0, sv_pvswords * sizeof(*pvs));
+	for (int leafnum : leafs)
+		SV_OrLeafPVS(pvs, leafnum);
+}
+
+// each thread building client datagrams gets its own fat pvs
+static thread_local uint64_t	fatpvs[MAX_PVS_WORDS];
+static thread_local std::vector<int>	fatleafs;
+
+/*
+=============
+SV_FatPVS
+
+Calculates a PVS that is the inclusive or of all leafs within 8 pixels of the
+given point.
+=============
+*/
+byte* SV_FatPVS(vec3_t org)
+{
+	fatleafs.clear();
+	SV_FindFatPVSLeafs(org, sv.worldmodel->nodes, fatleafs);
+	SV_BuildFatPVS(fatleafs, fatpvs);
+	return reinterpret_cast<byte*>(fatpvs);
+}
+
+// the last fat pvs of each client, reused while the view stays in the same leafs
+typedef struct
+{
+	int				spawncount;
+	std::vector<int>	leafs;
+	uint64_t		pvs[MAX_PVS_WORDS];
+} fatpvscache_t;
+
+static std::vector<fatpvscache_t>	sv_fatpvscache;	// [maxclients]
+
+/*
+=============
+SV_ClearFatPVSCache
+=============
+*/
+static void SV_ClearFatPVSCache(client_t* client)
+{
+	if ((int)sv_fatpvscache.size() < svs.maxclients)
+		sv_fatpvscache.resize(svs.maxclients);
+
+	sv_fatpvscache[client - svs.clients].spawncount = -1;
+}
+
+/*
+=============
+SV_CachedFatPVS
+=============
+*/
+static byte* SV_CachedFatPVS(fatpvscache_t& cache, vec3_t org)
+{
+	fatleafs.clear();
+	SV_FindFatPVSLeafs(org, sv.worldmodel->nodes, fatleafs);
+
+	if (cache.spawncount != svs.spawncount || cache.leafs != fatleafs)
+	{
+		SV_BuildFatPVS(fatleafs, cache.pvs);
+		cache.leafs = fatleafs;
+		cache.spawncount = svs.spawncount;
+	}
+
+	return reinterpret_cast<byte*>(cache.pvs);
+}
+
+/*
+=============
+SV_ClientFatPVS
+
+SV_FatPVS for a client's view, only touches that client's cache so the send
+jobs can call it
+=============
+*/
+static byte* SV_ClientFatPVS(client_t* client, vec3_t org)
+{
+	return SV_CachedFatPVS(sv_fatpvscache[client - svs.clients], org);
+}
+
+/*
+=============
+SV_AddToFatPVSBytes
+
+The fat PVS the way it was built before sv_pvsmatrix, decompressing every
+leaf and ORing a byte at a time.  Kept for sv_fatpvsbench.
+=============
+*/
+static void SV_AddToFatPVSBytes(vec3_t org, mnode_t* node, byte* fat, int fatbytes)
+{
+	int		i;
+	byte* pvs;
+	mplane_t* plane;
+	float	d;
+
+	while (1)
+	{
+		// if this is a leaf, accumulate the pvs bits
+		if (node->contents < 0)
+		{
+			if (node->contents != CONTENTS_SOLID)
+			{
+				pvs = Mod_LeafPVS((mleaf_t*)node, sv.worldmodel);
+				for (i = 0; i < fatbytes; i++)
+					fat[i] |= pvs[i];
+			}
+			return;
+		}
+
+		plane = node->plane;
+		d = DotProduct(org, plane->normal) - plane->dist;
+		if (d > 8)
+			node = node->children[0];
+		else if (d < -8)
+			node = node->children[1];
+		else
+		{	// go down both
+			SV_AddToFatPVSBytes(org, node->children[0], fat, fatbytes);
+			node = node->children[1];
+		}
+	}
+}
+
+/*
+=============
+SV_FatPVSBench_f
+
+Times a fat PVS at the center of every leaf of the current map, built by
+decompressing every leaf, from sv_pvsmatrix, and from a per client cache
+that is hit every other call.  "all" queues the benchmark on e1m1 through
+e4m8.
+
+sv_fatpvsbench [passes]
+sv_fatpvsbench all [passes]
+=============
+*/
+void SV_FatPVSBench_f(void)
+{
+	static const int	episodemaps[4] = {8, 7, 7, 8};
+	typedef struct { vec3_t org; } benchpoint_t;
+
+	int			i, j, l, passes, fatbytes, mismatches;
+	int			episode, map;
+	char		name[MAX_QPATH];
+	FILE* f;
+	double		start, bytetime, matrixtime, cachedtime;
+	byte* pvs;
+	mleaf_t* leaf;
+	unsigned	sink;
+	std::vector<benchpoint_t>	points;
+	std::vector<byte>	reference(MAX_MAP_LEAFS / 8);
+	static fatpvscache_t	cache;
+
+	if (Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "all"))
+	{
+		passes = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 10;
+		for (episode = 1; episode <= 4; episode++)
+		{
+			for (map = 1; map <= episodemaps[episode - 1]; map++)
+			{
+				sprintf(name, "maps/e%im%i.bsp", episode, map);
+				if (COM_FOpenFile(name, &f) == -1)
+				{
+					Con_Printf("sv_fatpvsbench: %s not found\n", name);
+					continue;
+				}
+				fclose(f);
+				Cbuf_AddText(va("map e%im%i\nsv_fatpvsbench %i\n", episode, map, passes));
+			}
+		}
+		return;
+	}
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_fatpvsbench: no map running\n");
+		return;
+	}
+
+	passes = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 10;
+	if (passes < 1)
+		passes = 1;
+
+	for (l = 1, leaf = sv.worldmodel->leafs + 1; l <= sv.worldmodel->numleafs; l++, leaf++)
+	{
+		if (leaf->contents == CONTENTS_SOLID)
+			continue;
+		points.emplace_back();
+		for (j = 0; j < 3; j++)
+			points.back().org[j] = (leaf->minmaxs[j] + leaf->minmaxs[3 + j]) * 0.5f;
+	}
+
+	fatbytes = (sv.worldmodel->numleafs + 31) >> 3;
+
+	// make sure the matrix gives the same answer
+	mismatches = 0;
+	for (auto& point : points)
+	{
+		Q_memset(reference.data(), 0, fatbytes);
+		SV_AddToFatPVSBytes(point.org, sv.worldmodel->nodes, reference.data(), fatbytes);
+		pvs = SV_FatPVS(point.org);
+		for (l = 0; l < sv.worldmodel->numleafs; l++)
+		{
+			if (((reference[l >> 3] ^ pvs[l >> 3]) >> (l & 7)) & 1)
+			{
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	sink = 0;
+
+	start = Sys_FloatTime();
+	for (i = 0; i < passes; i++)
+	{
+		for (auto& point : points)
+		{
+			Q_memset(reference.data(), 0, fatbytes);
+			SV_AddToFatPVSBytes(point.org, sv.worldmodel->nodes, reference.data(), fatbytes);
+			sink += reference[0];
+		}
+	}
+	bytetime = Sys_FloatTime() - start;
+
+	start = Sys_FloatTime();
+	for (i = 0; i < passes; i++)
+		for (auto& point : points)
+			sink += SV_FatPVS(point.org)[0];
+	matrixtime = Sys_FloatTime() - start;
+
+	cache.spawncount = -1;
+	start = Sys_FloatTime();
+	for (i = 0; i < passes; i++)
+	{
+		for (auto& point : points)
+		{
+			sink += SV_CachedFatPVS(cache, point.org)[0];
+			sink += SV_CachedFatPVS(cache, point.org)[0];
+		}
+	}
+	cachedtime = (Sys_FloatTime() - start) / 2;
+
+	Con_Printf("%s: %i leafs, %i points, %s %i KB, %i mismatches\n", sv.name, sv.worldmodel->numleafs,
+		(int)points.size(), sv_pvslru ? "lru" : "matrix", (int)(sv_pvsmatrix.size() * sizeof(uint64_t) / 1024), mismatches);
+	Con_Printf("per pass: decompress %.3f ms, matrix %.3f ms, cached %.3f ms (%u)\n",
+		bytetime * 1000 / passes, matrixtime * 1000 / passes, cachedtime * 1000 / passes, sink & 1);
+}
+
+//=============================================================================
+
+
+/*
+=============
+SV_HeadNodeVisible
+
+Checks the leafs under node that the entity's box touches against the pvs,
+for entities in too many leafs to list
+=============
+*/
+static bool SV_HeadNodeVisible(mnode_t* node, edict_t* ent, const byte* pvs)
+{
+	int		sides;
+	int		leafnum;
+
+	while (1)
+	{
+		if (node->contents == CONTENTS_SOLID)
+			return false;
+
+		if (node->contents < 0)
+		{
+			leafnum = (mleaf_t*)node - sv.worldmodel->leafs - 1;
+			return (pvs[leafnum >> 3] & (1 << (leafnum & 7))) != 0;
+		}
+
+		sides = BOX_ON_PLANE_SIDE(ent->v.absmin, ent->v.absmax, node->plane);
+
+		if (sides == 3 && SV_HeadNodeVisible(node->children[0], ent, pvs))
+			return true;
+
+		node = sides == 1 ? node->children[0] : node->children[1];
+	}
+}
+
+/*
+=============
+SV_FindCandidateEntities
+
+Marks the entities touching a leaf cluster that has a visible leaf, and the
+client itself.  Only those can pass SV_VisibleEntity.
+=============
+*/
+static const std::vector<uint64_t>& SV_FindCandidateEntities(edict_t* clent, const byte* pvs)
+{
+	int		c;
+	const int	words = (sv.num_edicts + 63) >> 6;
+	const uint64_t* pvswords = reinterpret_cast<const uint64_t*>(pvs);
+	static thread_local std::vector<uint64_t>	candidates;
+
+	candidates.assign(words, 0);
+
+	for (c = 0; c < sv_pvswords; c++)
+	{
+		if (pvswords[c])
+			SV_OrWords(candidates.data(), &sv.mirror.clusterents[c * sv.mirror.clusterwords], words);
+	}
+
+	candidates[clent->entnum >> 6] |= 1ull << (clent->entnum & 63);
+
+	return candidates;
+}
+
+/*
+=============
+SV_VisibleEntity
+
+Returns the edict if entity e should be sent to clent with the given pvs
+=============
+*/
+static edict_t* SV_VisibleEntity(edict_t* clent, int e, const byte* pvs)
+{
+	int		i;
+	edict_t* ent;
+
+	ent = EDICT_NUM(e);
+
+	// ignore if not touching a PV leaf
+	if (e != clent->entnum)	// clent is ALLWAYS sent
+	{
+		// ignore ents without visible models
+		if (!sv.mirror.modelindex[e])
+			return NULL;
+
+		if (sv.mirror.headnode[e])
+		{
+			if (!SV_HeadNodeVisible(sv.mirror.headnode[e], ent, pvs))
+				return NULL;		// not visible
+		}
+		else
+		{
+			const int num_leafs = sv.mirror.num_leafs[e];
+			const short* leafnums = sv.mirror.leafnums[e];
+
+			for (i = 0; i < num_leafs; i++)
+				if (pvs[leafnums[i] >> 3] & (1 << (leafnums[i] & 7)))
+					break;
+
+			if (i == num_leafs)
+				return NULL;		// not visible
+		}
+	}
+
+#ifdef QUAKE2
+	// don't send if flagged for NODRAW and there are no lighting effects
+	if (ent->v.effects == EF_NODRAW)
+		return NULL;
+#endif
+
+	if (ent != clent && !ent->v.model)
+		return NULL;
+
+	return ent;
+}
+
+/*
+=============
+SV_WritePacketEntities
+
+Writes a svc_packetentities frame for a PROTOCOL_DELTA client.  If the
+message fills up, the entities that didn't fit keep the state the client
+already has and are sent with a later frame.  Only touches the client's own
+frames, so it can run on a job worker.
+=============
+*/
+static void SV_WritePacketEntities(client_t* client, sizebuf_t* msg)
+{
+	int		e, w;
+	uint64_t	bits;
+	int		sequence, delta;
+	int		oldindex, newindex, oldcount, newcount;
+	int		oldnum, newnum;
+	bool	full;
+	byte* pvs;
+	vec3_t	org;
+	edict_t* clent;
+	edict_t* ent;
+	packet_frame_t* from;
+	packet_frame_t* to;
+	packet_entity_t	baseline, written;
+	static thread_local std::vector<packet_entity_t>	visible;
+
+	auto& frames = sv_clientframes[client - svs.clients];
+
+	// find the client's PVS
+	clent = client->edict;
+	VectorAdd(clent->v.origin, clent->v.view_ofs, org);
+	pvs = SV_ClientFatPVS(client, org);
+
+	// candidates come out in entity order, which the delta needs
+	visible.clear();
+	const auto& candidates = SV_FindCandidateEntities(clent, pvs);
+	for (w = 0; w < (int)candidates.size(); w++)
+	{
+		for (bits = candidates[w]; bits; bits &= bits - 1)
+		{
+			e = w * 64 + Q_LowestBit64(bits);
+			if (!e || e >= sv.num_edicts)
+				continue;
+
+			ent = SV_VisibleEntity(clent, e, pvs);
+			if (!ent)
+				continue;
+			visible.emplace_back();
+			SV_EntityState(ent, &visible.back());
+		}
+	}
 
-The PVS must include a small area around the client to allow head bobbing
-or other small motion on the client side.  Otherwise, a bob might cause an
-entity that should be visible to not show up, especially when the bob
-crosses a waterline.
+	// delta against the acknowledged frame if it is still around
+	sequence = ++frames.sequence;
+	delta = client->delta_sequence;
+	if (delta > 0 && delta < sequence && sequence - delta < UPDATE_BACKUP
+		&& frames.frames[delta & UPDATE_MASK].sequence == delta)
+		from = &frames.frames[delta & UPDATE_MASK];
+	else
+	{
+		from = NULL;
+		delta = 0;		// from the baselines
+	}
 
-=============================================================================
-*/
+	to = &frames.frames[sequence & UPDATE_MASK];
+	to->sequence = sequence;
+	to->entities.clear();
 
-int		fatbytes;
-byte	fatpvs[MAX_MAP_LEAFS / 8];
+	MSG_WriteByte(msg, svc_packetentities);
+	MSG_WriteLong(msg, sequence);
+	MSG_WriteLong(msg, delta);
 
-void SV_AddToFatPVS(vec3_t org, mnode_t* node)
-{
-	int		i;
-	byte* pvs;
-	mplane_t* plane;
-	float	d;
+	oldindex = newindex = 0;
+	oldcount = from ? (int)from->entities.size() : 0;
+	newcount = (int)visible.size();
+	full = false;
 
-	while (1)
+	while (oldindex < oldcount || newindex < newcount)
 	{
-		// if this is a leaf, accumulate the pvs bits
-		if (node->contents < 0)
-		{
-			if (node->contents != CONTENTS_SOLID)
+		oldnum = oldindex < oldcount ? from->entities[oldindex].number : MAX_EDICTS;
+		newnum = newindex < newcount ? visible[newindex].number : MAX_EDICTS;
+
+		// leave room for the terminator
+		if (msg->maxsize - msg->cursize < MAX_PACKETENTITY_BYTES + 2)
+			full = true;
+
+		if (newnum == oldnum)
+		{	// delta from the previous state
+			if (!full && SV_WriteDeltaEntity(&from->entities[oldindex], &visible[newindex], &written, false, msg))
+				to->entities.push_back(written);
+			else
+				to->entities.push_back(from->entities[oldindex]);
+			oldindex++;
+			newindex++;
+		}
+		else if (newnum < oldnum)
+		{	// entering the frame, delta from the baseline
+			if (!full)
 			{
-				pvs = Mod_LeafPVS((mleaf_t*)node, sv.worldmodel);
-				for (i = 0; i < fatbytes; i++)
-					fatpvs[i] |= pvs[i];
+				ent = EDICT_NUM(newnum);
+				baseline.number = newnum;
+				baseline.nolerp = false;
+				baseline.state = ent->baseline;
+				SV_WriteDeltaEntity(&baseline, &visible[newindex], &written, true, msg);
+				to->entities.push_back(written);
 			}
-			return;
+			newindex++;
 		}
-
-		plane = node->plane;
-		d = DotProduct(org, plane->normal) - plane->dist;
-		if (d > 8)
-			node = node->children[0];
-		else if (d < -8)
-			node = node->children[1];
 		else
-		{	// go down both
-			SV_AddToFatPVS(org, node->children[0]);
-			node = node->children[1];
+		{	// left the frame
+			if (!full)
+			{
+				MSG_WriteShort(msg, oldnum);
+				MSG_WriteShort(msg, U_REMOVE);
+			}
+			else
+				to->entities.push_back(from->entities[oldindex]);
+			oldindex++;
 		}
 	}
+
+	MSG_WriteShort(msg, 0);	// end of packetentities
 }
 
 /*
 =============
-SV_FatPVS
+SV_WriteEntityUpdate
 
-Calculates a PVS that is the inclusive or of all leafs within 8 pixels of the
-given point.
+Writes an entity as the difference from its baseline.  Returns false if
+there wasn't room.
 =============
 */
-byte* SV_FatPVS(vec3_t org)
+static bool SV_WriteEntityUpdate(edict_t* ent, int e, sizebuf_t* msg)
 {
-	fatbytes = (sv.worldmodel->numleafs + 31) >> 3;
-	Q_memset(fatpvs, 0, fatbytes);
-	SV_AddToFatPVS(org, sv.worldmodel->nodes);
-	return fatpvs;
-}
+	int		i;
+	int		bits;
+	float	miss;
 
-//=============================================================================
+	if (msg->maxsize - msg->cursize < 16)
+		return false;
+
+	// send an update
+	bits = 0;
+
+	for (i = 0; i < 3; i++)
+	{
+		miss = ent->v.origin[i] - ent->baseline.origin[i];
+		if (miss < -0.1 || miss > 0.1)
+			bits |= U_ORIGIN1 << i;
+	}
+
+	if (ent->v.angles[0] != ent->baseline.angles[0])
+		bits |= U_ANGLE1;
+
+	if (ent->v.angles[1] != ent->baseline.angles[1])
+		bits |= U_ANGLE2;
 
+	if (ent->v.angles[2] != ent->baseline.angles[2])
+		bits |= U_ANGLE3;
+
+	if (ent->v.movetype == MOVETYPE_STEP)
+		bits |= U_NOLERP;	// don't mess up the step animation
+
+	if (ent->baseline.colormap != ent->v.colormap)
+		bits |= U_COLORMAP;
+
+	if (ent->baseline.skin != ent->v.skin)
+		bits |= U_SKIN;
+
+	if (ent->baseline.frame != ent->v.frame)
+		bits |= U_FRAME;
+
+	if (ent->baseline.effects != ent->v.effects)
+		bits |= U_EFFECTS;
+
+	if (ent->baseline.modelindex != ent->v.modelindex)
+		bits |= U_MODEL;
+
+	if (e >= 256)
+		bits |= U_LONGENTITY;
+
+	if (bits >= 256)
+		bits |= U_MOREBITS;
+
+	//
+	// write the message
+	//
+	MSG_WriteByte(msg, bits | U_SIGNAL);
+
+	if (bits & U_MOREBITS)
+		MSG_WriteByte(msg, bits >> 8);
+	if (bits & U_LONGENTITY)
+		MSG_WriteShort(msg, e);
+	else
+		MSG_WriteByte(msg, e);
+
+	if (bits & U_MODEL)
+		MSG_WriteByte(msg, ent->v.modelindex);
+	if (bits & U_FRAME)
+		MSG_WriteByte(msg, ent->v.frame);
+	if (bits & U_COLORMAP)
+		MSG_WriteByte(msg, ent->v.colormap);
+	if (bits & U_SKIN)
+		MSG_WriteByte(msg, ent->v.skin);
+	if (bits & U_EFFECTS)
+		MSG_WriteByte(msg, ent->v.effects);
+	if (bits & U_ORIGIN1)
+		MSG_WriteCoord(msg, ent->v.origin[0]);
+	if (bits & U_ANGLE1)
+		MSG_WriteAngle(msg, ent->v.angles[0]);
+	if (bits & U_ORIGIN2)
+		MSG_WriteCoord(msg, ent->v.origin[1]);
+	if (bits & U_ANGLE2)
+		MSG_WriteAngle(msg, ent->v.angles[1]);
+	if (bits & U_ORIGIN3)
+		MSG_WriteCoord(msg, ent->v.origin[2]);
+	if (bits & U_ANGLE3)
+		MSG_WriteAngle(msg, ent->v.angles[2]);
+
+	return true;
+}
 
 /*
 =============
 SV_WriteEntitiesToClient
 
+Only reads server state, so it can run on a job worker.  Returns false if the
+message filled up before every visible entity was written.
 =============
 */
-void SV_WriteEntitiesToClient(edict_t* clent, sizebuf_t* msg)
+bool SV_WriteEntitiesToClient(edict_t* clent, sizebuf_t* msg)
 {
-	int		e, i;
-	int		bits;
+	int		e;
 	byte* pvs;
 	vec3_t	org;
-	float	miss;
 	edict_t* ent;
 
 	// find the client's PVS
 	VectorAdd(clent->v.origin, clent->v.view_ofs, org);
-	pvs = SV_FatPVS(org);
+	pvs = SV_ClientFatPVS(svs.clients + clent->entnum - 1, org);
 
 	// send over all entities (excpet the client) that touch the pvs
-	ent = sv.edicts + 1;
-	for (e = 1; e < sv.num_edicts; e++, ++ent)
+	const auto& candidates = SV_FindCandidateEntities(clent, pvs);
+	for (e = 1; e < sv.num_edicts; e++)
 	{
-#ifdef QUAKE2
-		// don't send if flagged for NODRAW and there are no lighting effects
-		if (ent->v.effects == EF_NODRAW)
+		if (!(candidates[e >> 6] & (1ull << (e & 63))))
 			continue;
-#endif
-
-		// ignore if not touching a PV leaf
-		if (ent != clent)	// clent is ALLWAYS sent
-		{
-			// ignore ents without visible models
-			if (!ent->v.modelindex || !ent->v.model)
-				continue;
-
-			for (i = 0; i < ent->num_leafs; i++)
-				if (pvs[ent->leafnums[i] >> 3] & (1 << (ent->leafnums[i] & 7)))
-					break;
-
-			if (i == ent->num_leafs)
-				continue;		// not visible
-		}
-
-		if (msg->maxsize - msg->cursize < 16)
-		{
-			Con_Printf("packet overflow\n");
-			return;
-		}
-
-		// send an update
-		bits = 0;
-
-		for (i = 0; i < 3; i++)
-		{
-			miss = ent->v.origin[i] - ent->baseline.origin[i];
-			if (miss < -0.1 || miss > 0.1)
-				bits |= U_ORIGIN1 << i;
-		}
-
-		if (ent->v.angles[0] != ent->baseline.angles[0])
-			bits |= U_ANGLE1;
-
-		if (ent->v.angles[1] != ent->baseline.angles[1])
-			bits |= U_ANGLE2;
 
-		if (ent->v.angles[2] != ent->baseline.angles[2])
-			bits |= U_ANGLE3;
-
-		if (ent->v.movetype == MOVETYPE_STEP)
-			bits |= U_NOLERP;	// don't mess up the step animation
+		ent = SV_VisibleEntity(clent, e, pvs);
+		if (!ent)
+			continue;
 
-		if (ent->baseline.colormap != ent->v.colormap)
-			bits |= U_COLORMAP;
+		if (!SV_WriteEntityUpdate(ent, e, msg))
+			return false;
+	}
 
-		if (ent->baseline.skin != ent->v.skin)
-			bits |= U_SKIN;
+	return true;
+}
 
-		if (ent->baseline.frame != ent->v.frame)
-			bits |= U_FRAME;
+/*
+=============
+SV_WriteAllEntities
 
-		if (ent->baseline.effects != ent->v.effects)
-			bits |= U_EFFECTS;
+Writes every entity with a model regardless of any PVS, starting at start.
+Returns the entity to continue with once the message has been emptied, or
+sv.num_edicts when all of them were written.
+=============
+*/
+int SV_WriteAllEntities(int start, sizebuf_t* msg)
+{
+	int		e;
+	edict_t* ent;
 
-		if (ent->baseline.modelindex != ent->v.modelindex)
-			bits |= U_MODEL;
+	for (e = std::max(start, 1); e < sv.num_edicts; e++)
+	{
+		if (!ED_InUse(sv.mirror, e) || !sv.mirror.modelindex[e])
+			continue;
 
-		if (e >= 256)
-			bits |= U_LONGENTITY;
+		ent = EDICT_NUM(e);
 
-		if (bits >= 256)
-			bits |= U_MOREBITS;
+#ifdef QUAKE2
+		if (ent->v.effects == EF_NODRAW)
+			continue;
+#endif
 
-		//
-		// write the message
-		//
-		MSG_WriteByte(msg, bits | U_SIGNAL);
+		if (!ent->v.model)
+			continue;
 
-		if (bits & U_MOREBITS)
-			MSG_WriteByte(msg, bits >> 8);
-		if (bits & U_LONGENTITY)
-			MSG_WriteShort(msg, e);
-		else
-			MSG_WriteByte(msg, e);
-
-		if (bits & U_MODEL)
-			MSG_WriteByte(msg, ent->v.modelindex);
-		if (bits & U_FRAME)
-			MSG_WriteByte(msg, ent->v.frame);
-		if (bits & U_COLORMAP)
-			MSG_WriteByte(msg, ent->v.colormap);
-		if (bits & U_SKIN)
-			MSG_WriteByte(msg, ent->v.skin);
-		if (bits & U_EFFECTS)
-			MSG_WriteByte(msg, ent->v.effects);
-		if (bits & U_ORIGIN1)
-			MSG_WriteCoord(msg, ent->v.origin[0]);
-		if (bits & U_ANGLE1)
-			MSG_WriteAngle(msg, ent->v.angles[0]);
-		if (bits & U_ORIGIN2)
-			MSG_WriteCoord(msg, ent->v.origin[1]);
-		if (bits & U_ANGLE2)
-			MSG_WriteAngle(msg, ent->v.angles[1]);
-		if (bits & U_ORIGIN3)
-			MSG_WriteCoord(msg, ent->v.origin[2]);
-		if (bits & U_ANGLE3)
-			MSG_WriteAngle(msg, ent->v.angles[2]);
+		if (!SV_WriteEntityUpdate(ent, e, msg))
+			return e;
 	}
+
+	return sv.num_edicts;
 }
 
 /*
@@ -541,9 +1496,9 @@ void SV_CleanupEnts(void)
 	int		e;
 	edict_t* ent;
 
-	ent = sv.edicts + 1;
-	for (e = 1; e < sv.num_edicts; e++, ++ent)
+	for (e = 1; e < sv.num_edicts; e++)
 	{
+		ent = EDICT_NUM(e);
 		ent->v.effects = (int)ent->v.effects & ~EF_MUZZLEFLASH;
 	}
 
@@ -556,6 +1511,30 @@ SV_WriteClientdataToMessage
 ==================
 */
 void SV_WriteClientdataToMessage(edict_t* ent, sizebuf_t* msg)
+{
+	//
+	// send the current viewpos offset from the view entity
+	//
+	SV_SetIdealPitch();		// how much to look up / down ideally
+
+	SV_WriteClientdata(ent, msg);
+
+	// the damage and fixangle are only sent once
+	// a fixangle might get lost in a dropped packet.  Oh well.
+	ent->v.dmg_take = 0;
+	ent->v.dmg_save = 0;
+	ent->v.fixangle = 0;
+}
+
+/*
+==================
+SV_WriteClientdata
+
+Writes the client data without changing the edict, so it can be recorded
+without taking the damage and fixangle from the client's own update
+==================
+*/
+void SV_WriteClientdata(edict_t* ent, sizebuf_t* msg)
 {
 	int		bits;
 	int		i;
@@ -573,23 +1552,13 @@ void SV_WriteClientdataToMessage(edict_t* ent, sizebuf_t* msg)
 		MSG_WriteByte(msg, ent->v.dmg_take);
 		for (i = 0; i < 3; i++)
 			MSG_WriteCoord(msg, other->v.origin[i] + 0.5 * (other->v.mins[i] + other->v.maxs[i]));
-
-		ent->v.dmg_take = 0;
-		ent->v.dmg_save = 0;
 	}
 
-	//
-	// send the current viewpos offset from the view entity
-	//
-	SV_SetIdealPitch();		// how much to look up / down ideally
-
-// a fixangle might get lost in a dropped packet.  Oh well.
 	if (ent->v.fixangle)
 	{
 		MSG_WriteByte(msg, svc_setangle);
 		for (i = 0; i < 3; i++)
 			MSG_WriteAngle(msg, ent->v.angles[i]);
-		ent->v.fixangle = 0;
 	}
 
 	bits = 0;
@@ -691,40 +1660,131 @@ void SV_WriteClientdataToMessage(edict_t* ent, sizebuf_t* msg)
 	}
 }
 
+/*
+=============================================================================
+
+CLIENT DATAGRAMS
+
+The unreliable datagrams are built in three passes: the client data is
+written on the main thread, since it clears fields on the client's edict and
+traces for the ideal pitch, the entity updates for every client are written in
+parallel by the job workers, and the finished datagrams are then sent in
+client order on the main thread.
+
+=============================================================================
+*/
+
+typedef struct
+{
+	netmessage_t	msg;		// written straight into the networking library's buffer
+	bool		overflowed;		// entity updates didn't fit
+} clientdatagram_t;
+
+static std::vector<clientdatagram_t>	sv_clientdatagrams;
+
+cvar_t	sv_parallelsend = {"sv_parallelsend", "1"};
+
 /*
 =======================
-SV_SendClientDatagram
+SV_BeginClientDatagram
+
+Starts the datagram with the parts that have to be written on the main thread
 =======================
 */
-bool SV_SendClientDatagram(client_t* client)
+static void SV_BeginClientDatagram(client_t* client, clientdatagram_t* datagram)
 {
-	byte		buf[MAX_DATAGRAM];
-	sizebuf_t	msg;
-
-	msg.data = buf;
-	msg.maxsize = sizeof(buf);
-	msg.cursize = 0;
+	g_Networking->AllocateMessage(&datagram->msg, MAX_DATAGRAM);
+	datagram->overflowed = false;
 
-	MSG_WriteByte(&msg, svc_time);
-	MSG_WriteFloat(&msg, sv.time);
+	MSG_WriteByte(&datagram->msg.buf, svc_time);
+	MSG_WriteFloat(&datagram->msg.buf, sv.time);
 
 	// add the client specific data to the datagram
-	SV_WriteClientdataToMessage(client->edict, &msg);
+	SV_WriteClientdataToMessage(client->edict, &datagram->msg.buf);
+}
+
+/*
+=======================
+SV_FinishClientDatagram
+
+Safe to run on a job worker
+=======================
+*/
+static void SV_FinishClientDatagram(client_t* client, clientdatagram_t* datagram)
+{
+	sizebuf_t* msg = &datagram->msg.buf;
 
-	SV_WriteEntitiesToClient(client->edict, &msg);
+	if (client->protocol == PROTOCOL_DELTA)
+	{
+		// keep room for the server datagram, entities that don't fit go out next frame,
+		// but always leave enough for the svc_packetentities header and terminator
+		const int room = msg->maxsize - msg->cursize - 11;
+		const int reserve = std::clamp(sv.datagram.cursize, 0, std::max(room, 0));
+
+		msg->maxsize -= reserve;
+		SV_WritePacketEntities(client, msg);
+		msg->maxsize += reserve;
+	}
+	else
+		datagram->overflowed = !SV_WriteEntitiesToClient(client->edict, msg);
 
 	// copy the server datagram if there is space
-	if (msg.cursize + sv.datagram.cursize < msg.maxsize)
-		SZ_Write(&msg, sv.datagram.data, sv.datagram.cursize);
+	if (msg->cursize + sv.datagram.cursize < msg->maxsize)
+		SZ_Write(msg, sv.datagram.data, sv.datagram.cursize);
+}
 
-	// send the datagram
-	if (g_Networking->SendUnreliableMessage(client->netconnection, &msg) == -1)
+/*
+=======================
+SV_SendClientDatagram
+
+Queues the datagram for SV_SendClientMessages to send with everything else
+=======================
+*/
+static void SV_SendClientDatagram(client_t* client, clientdatagram_t* datagram)
+{
+	if (datagram->overflowed)
+		Con_Printf("packet overflow\n");
+
+	g_Networking->QueueMessage(client->netconnection, &datagram->msg, false);
+}
+
+/*
+=======================
+SV_BuildClientDatagrams
+
+Builds the datagrams for all spawned clients
+=======================
+*/
+static void SV_BuildClientDatagrams(void)
+{
+	int			i;
+	client_t* client;
+	std::vector<int>	building;
+
+	if ((int)sv_clientdatagrams.size() < svs.maxclients)
+		sv_clientdatagrams.resize(svs.maxclients);
+
+	for (i = 0, client = svs.clients; i < svs.maxclients; i++, client++)
 	{
-		SV_DropClient(true);// if the message couldn't send, kick off
-		return false;
+		if (!client->active || !client->spawned)
+			continue;
+
+		SV_BeginClientDatagram(client, &sv_clientdatagrams[i]);
+		building.push_back(i);
 	}
 
-	return true;
+	if (!sv_parallelsend.value)
+	{
+		for (int clientnum : building)
+			SV_FinishClientDatagram(&svs.clients[clientnum], &sv_clientdatagrams[clientnum]);
+		return;
+	}
+
+	Jobs_ParallelFor((int)building.size(), [&](int job)
+		{
+			const int clientnum = building[job];
+			SV_FinishClientDatagram(&svs.clients[clientnum], &sv_clientdatagrams[clientnum]);
+		});
 }
 
 /*
@@ -736,6 +1796,9 @@ void SV_UpdateToReliableMessages(void)
 {
 	int			i, j;
 	client_t* client;
+	sizebuf_t* demo;
+
+	demo = SV_DemoReliable();
 
 	// check for changes to be sent over the reliable streams
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
@@ -751,18 +1814,25 @@ void SV_UpdateToReliableMessages(void)
 				MSG_WriteShort(&client->message, host_client->edict->v.frags);
 			}
 
+			if (demo)
+			{
+				MSG_WriteByte(demo, svc_updatefrags);
+				MSG_WriteByte(demo, i);
+				MSG_WriteShort(demo, host_client->edict->v.frags);
+			}
+
 			host_client->old_frags = host_client->edict->v.frags;
 		}
 	}
 
+	// spawned clients get sv.reliable_datagram as a message shared by all of
+	// them, the others may not flush their reliable stream for a while yet
 	for (j = 0, client = svs.clients; j < svs.maxclients; j++, client++)
 	{
-		if (!client->active)
+		if (!client->active || client->spawned)
 			continue;
 		SZ_Write(&client->message, sv.reliable_datagram.data, sv.reliable_datagram.cursize);
 	}
-
-	SZ_Clear(&sv.reliable_datagram);
 }
 
 
@@ -790,6 +1860,42 @@ void SV_SendNop(client_t* client)
 	client->last_message = realtime;
 }
 
+/*
+=======================
+SV_QueueReliable
+
+Queues bytes start to end of the client's reliable stream
+=======================
+*/
+static void SV_QueueReliable(client_t* client, int start, int end, netmessage_t* msg)
+{
+	if (end <= start)
+		return;
+
+	g_Networking->AllocateMessage(msg, end - start);
+	SZ_Write(&msg->buf, client->message.data + start, end - start);
+	g_Networking->QueueMessage(client->netconnection, msg, true);
+}
+
+/*
+=======================
+SV_InsertReliable
+
+Puts data into the reliable stream at ofs, for when the shared copy can't be sent
+=======================
+*/
+static void SV_InsertReliable(sizebuf_t* buf, int ofs, const sizebuf_t* data)
+{
+	const int oldsize = buf->cursize;
+
+	SZ_GetSpace(buf, data->cursize);
+	if (buf->overflowed)
+		return;
+
+	memmove(buf->data + ofs + data->cursize, buf->data + ofs, oldsize - ofs);
+	memcpy(buf->data + ofs, data->data, data->cursize);
+}
+
 /*
 =======================
 SV_SendClientMessages
@@ -798,11 +1904,26 @@ SV_SendClientMessages
 void SV_SendClientMessages(void)
 {
 	int			i;
+	int			sharedofs[MAX_SCOREBOARD];
+	netmessage_t	reliable;
 
 	// update frags, names, etc
 	SV_UpdateToReliableMessages();
 
+	// record the tick before anything gets cleared
+	SV_WriteDemoFrame();
+
+	// sv.reliable_datagram goes to spawned clients as one shared copy, at the
+	// point in their reliable stream where it would have been appended
+	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
+		sharedofs[i] = host_client->message.cursize;
+
+	if (sv.reliable_datagram.cursize)
+		g_Networking->BeginSharedMessage(&sv.reliable_datagram);
+
 	// build individual updates
+	SV_BuildClientDatagrams();
+
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
 		if (!host_client->active)
@@ -810,8 +1931,7 @@ void SV_SendClientMessages(void)
 
 		if (host_client->spawned)
 		{
-			if (!SV_SendClientDatagram(host_client))
-				continue;
+			SV_SendClientDatagram(host_client, &sv_clientdatagrams[i]);
 		}
 		else
 		{
@@ -838,11 +1958,16 @@ void SV_SendClientMessages(void)
 			continue;
 		}
 
-		if (host_client->message.cursize || host_client->dropasap)
+		// only spawned clients can still owe sv.reliable_datagram here
+		const bool shared = host_client->spawned && sv.reliable_datagram.cursize;
+
+		if (host_client->message.cursize || shared || host_client->dropasap)
 		{
 			if (!g_Networking->CanSendMessage(host_client->netconnection))
 			{
 				//				I_Printf ("can't write\n");
+				if (shared)
+					SV_InsertReliable(&host_client->message, sharedofs[i], &sv.reliable_datagram);
 				continue;
 			}
 
@@ -850,9 +1975,13 @@ void SV_SendClientMessages(void)
 				SV_DropClient(false);	// went to another level
 			else
 			{
-				if (g_Networking->SendMessage(host_client->netconnection
-					, &host_client->message) == -1)
-					SV_DropClient(true);	// if the message couldn't send, kick off
+				// the reliable stream itself has to be copied out, it keeps growing across frames
+				SV_QueueReliable(host_client, 0, shared ? sharedofs[i] : host_client->message.cursize, &reliable);
+				if (shared)
+				{
+					g_Networking->QueueSharedMessage(host_client->netconnection, true);
+					SV_QueueReliable(host_client, sharedofs[i], host_client->message.cursize, &reliable);
+				}
 				SZ_Clear(&host_client->message);
 				host_client->last_message = realtime;
 				host_client->sendsignon = false;
@@ -860,6 +1989,17 @@ void SV_SendClientMessages(void)
 		}
 	}
 
+	g_Networking->EndSharedMessage();
+	SZ_Clear(&sv.reliable_datagram);
+
+	if (g_Networking->SendQueuedMessages())
+	{
+		for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
+		{
+			if (host_client->active && host_client->netconnection && host_client->netconnection->sendfailed)
+				SV_DropClient(true);	// if the message couldn't send, kick off
+		}
+	}
 
 	// clear muzzle flashes
 	SV_CleanupEnts();
@@ -972,7 +2112,7 @@ void SV_SendReconnect(void)
 
 	MSG_WriteChar(&msg, svc_stufftext);
 	MSG_WriteString(&msg, "reconnect\n");
-	g_Networking->SendToAll(&msg, 5);
+	g_Networking->SendToAll(&msg);
 
 	if (cls.state != ca_dedicated)
 	{
@@ -1027,6 +2167,7 @@ void SV_SpawnServer(const char* server)
 {
 	edict_t* ent;
 	int			i;
+	std::vector<std::string>	prefetch;
 
 	++svs.spawncount;
 
@@ -1038,6 +2179,12 @@ void SV_SpawnServer(const char* server)
 	Con_DPrintf("SpawnServer: %s\n", server);
 	svs.changelevel_issued = false;		// now safe to issue another
 
+	// a server demo can't span maps, the signon data changes
+	SV_StopDemo();
+
+	// think stats are keyed by this map's classname strings
+	SV_ProfReset();
+
 	//Start up server if needed.
 	g_Networking->Listen();
 
@@ -1062,6 +2209,15 @@ void SV_SpawnServer(const char* server)
 
 	Cvar_SetValue("skill", (float)current_skill);
 
+	//
+	// the models the last level precached are the best guess at what this
+	// one will, read and decode them on the job workers along with the map
+	//
+	prefetch.push_back(va("maps/%s.bsp", server));
+	for (i = 2; i < MAX_MODELS && sv.model_precache[i]; i++)
+		if (sv.model_precache[i][0] != '*')
+			prefetch.push_back(sv.model_precache[i]);
+
 	//
 	// set up the new server
 	//
@@ -1078,10 +2234,8 @@ void SV_SpawnServer(const char* server)
 	// load progs to get entity field count
 	PR_LoadProgs();
 
-	// allocate server memory
-	sv.max_edicts = MAX_EDICTS;
-
-	sv.edicts = reinterpret_cast<edict_t*>(Hunk_AllocName(sv.max_edicts * sizeof(edict_t), "edicts"));
+	// allocate server memory, more edicts are allocated as needed
+	ED_InitEdicts(svs.maxedicts);
 
 	sv.datagram.maxsize = sizeof(sv.datagram_buf);
 	sv.datagram.cursize = 0;
@@ -1091,11 +2245,17 @@ void SV_SpawnServer(const char* server)
 	sv.reliable_datagram.cursize = 0;
 	sv.reliable_datagram.data = sv.reliable_datagram_buf;
 
+	sv.demo_reliable.maxsize = sizeof(sv.demo_reliable_buf);
+	sv.demo_reliable.cursize = 0;
+	sv.demo_reliable.data = sv.demo_reliable_buf;
+	sv.demo_reliable.allowoverflow = true;
+
 	sv.signon.maxsize = sizeof(sv.signon_buf);
 	sv.signon.cursize = 0;
 	sv.signon.data = sv.signon_buf;
 
 	// leave slots at start for clients only
+	ED_ReserveEdicts(svs.maxclients + 1);
 	sv.num_edicts = svs.maxclients + 1;
 	for (i = 0; i < svs.maxclients; i++)
 	{
@@ -1110,10 +2270,13 @@ void SV_SpawnServer(const char* server)
 
 	strcpy(sv.name, server);
 	sprintf(sv.modelname, "maps/%s.bsp", server);
+	COM_PrefetchFiles(prefetch, Mod_DecodeModel);
 	sv.worldmodel = Mod_ForName(sv.modelname, false);
 	if (!sv.worldmodel)
 	{
 		Con_Printf("Couldn't spawn server %s\n", sv.modelname);
+		Mod_ReleaseDecoded();
+		COM_ReleasePrefetch();
 		sv.active = false;
 		return;
 	}
@@ -1124,6 +2287,8 @@ void SV_SpawnServer(const char* server)
 	//
 	SV_ClearWorld();
 
+	SV_BuildPVSMatrix(sv.worldmodel);
+
 	sv.sound_precache[0] = "";
 
 	sv.model_precache[0] = "";
@@ -1138,12 +2303,11 @@ void SV_SpawnServer(const char* server)
 	// load the rest of the entities
 	//	
 	ent = EDICT_NUM(0);
-	memset(&ent->v, 0, sizeof(entvars_t));
-	ent->free = false;
+	ED_ClearEdict(ent);
 	ent->v.model = sv.worldmodel->name;
-	ent->v.modelindex = 1;		// world model
+	ED_SetModelIndex(ent, 1);		// world model
 	ent->v.solid = SOLID_BSP;
-	ent->v.movetype = MOVETYPE_PUSH;
+	ED_SetMovetype(ent, MOVETYPE_PUSH);
 
 	if (coop.value)
 		pr_global_struct->coop = coop.value;
@@ -1159,6 +2323,8 @@ void SV_SpawnServer(const char* server)
 	pr_global_struct->serverflags = svs.serverflags;
 
 	ED_LoadFromFile(sv.worldmodel->entities);
+	Mod_ReleaseDecoded();
+	COM_ReleasePrefetch();
 
 	sv.active = true;
 
@@ -19,6 +19,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // sv_phys.c
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 #include "quakedef.h"
 #include "game/IGame.h"
 
@@ -63,21 +73,24 @@ void SV_CheckAllEnts(void)
 {
 	int			e;
 	edict_t* check;
+	float		movetype;
 
 	// see if any solid entities are inside the final position
-	check = sv.edicts + 1;
-	for (e = 1; e < sv.num_edicts; e++, ++check)
+	for (e = 1; e < sv.num_edicts; e++)
 	{
-		if (check->free)
+		if (!ED_InUse(sv.mirror, e))
 			continue;
-		if (check->v.movetype == MOVETYPE_PUSH
-			|| check->v.movetype == MOVETYPE_NONE
+		movetype = sv.mirror.movetype[e];
+		if (movetype == MOVETYPE_PUSH
+			|| movetype == MOVETYPE_NONE
 #ifdef QUAKE2
-			|| check->v.movetype == MOVETYPE_FOLLOW
+			|| movetype == MOVETYPE_FOLLOW
 #endif
-			|| check->v.movetype == MOVETYPE_NOCLIP)
+			|| movetype == MOVETYPE_NOCLIP)
 			continue;
 
+		check = EDICT_NUM(e);
+
 		if (SV_TestEntityPosition(check))
 			Con_Printf("entity in invalid position\n");
 	}
@@ -136,9 +149,15 @@ bool SV_RunThink(edict_t* ent)
 		thinktime = sv.time;	// don't let things stay in the past.
 								// it is possible to start that way
 								// by a trigger with a local time.
-	ent->v.nextthink = 0;
+	ED_SetNextThink(ent, 0);
 	pr_global_struct->time = thinktime;
+
+	const long long start = SV_ProfTime();
+	const auto think = ent->v.think;
 	g_Game->EntityThink(ent, sv.edicts);
+	if (sv_profiling)
+		SV_ProfThink(ent, think, start);
+
 	return !ent->free;
 }
 
@@ -428,8 +447,10 @@ void SV_PushMove(edict_t* pusher, float movetime)
 	vec3_t		mins, maxs, move;
 	vec3_t		entorig, pushorig;
 	int			num_moved;
-	edict_t* moved_edict[MAX_EDICTS];
-	vec3_t		moved_from[MAX_EDICTS];
+	float		movetype;
+	// too big for the stack, pushers are never moved recursively
+	static edict_t* moved_edict[MAX_EDICTS];
+	static vec3_t	moved_from[MAX_EDICTS];
 
 	if (!pusher->v.velocity[0] && !pusher->v.velocity[1] && !pusher->v.velocity[2])
 	{
@@ -455,19 +476,21 @@ void SV_PushMove(edict_t* pusher, float movetime)
 
 	// see if any solid entities are inside the final position
 	num_moved = 0;
-	check = sv.edicts + 1;
-	for (e = 1; e < sv.num_edicts; e++, ++check)
+	for (e = 1; e < sv.num_edicts; e++)
 	{
-		if (check->free)
+		if (!ED_InUse(sv.mirror, e))
 			continue;
-		if (check->v.movetype == MOVETYPE_PUSH
-			|| check->v.movetype == MOVETYPE_NONE
+		movetype = sv.mirror.movetype[e];
+		if (movetype == MOVETYPE_PUSH
+			|| movetype == MOVETYPE_NONE
 #ifdef QUAKE2
-			|| check->v.movetype == MOVETYPE_FOLLOW
+			|| movetype == MOVETYPE_FOLLOW
 #endif
-			|| check->v.movetype == MOVETYPE_NOCLIP)
+			|| movetype == MOVETYPE_NOCLIP)
 			continue;
 
+		check = EDICT_NUM(e);
+
 		// if the entity is standing on the pusher, it will definately be moved
 		if (!(((int)check->v.flags & FL_ONGROUND)
 			&& check->v.groundentity == pusher))
@@ -575,9 +598,15 @@ void SV_Physics_Pusher(edict_t* ent)
 
 	if (thinktime > oldltime && thinktime <= ent->v.ltime)
 	{
-		ent->v.nextthink = 0;
+		ED_SetNextThink(ent, 0);
 		pr_global_struct->time = sv.time;
+
+		const long long start = SV_ProfTime();
+		const auto think = ent->v.think;
 		g_Game->EntityThink(ent, sv.edicts);
+		if (sv_profiling)
+			SV_ProfThink(ent, think, start);
+
 		if (ent->free)
 			return;
 	}
@@ -1173,8 +1202,177 @@ void SV_Physics_Step(edict_t* ent)
 	SV_CheckWaterTransition(ent);
 }
 
+/*
+===============================================================================
+
+THINK SCHEDULING
+
+Entities that don't move only have to be looked at when they think.  Every
+nextthink assignment is pushed on a min-heap, and at the start of a frame
+the entries that are due are popped and their edicts flagged in
+sv.mirror.due.  Entries are never removed when nextthink changes again,
+stale ones are recognized by comparing against the current nextthink.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	float	nextthink;
+	int		entnum;
+} thinkentry_t;
+
+static std::vector<thinkentry_t>	sv_thinkheap;
+
+static bool	sv_inphysics;		// SV_Physics is walking the edicts
+static int	sv_physicsedict;	// the edict it is at
+
+static bool SV_ThinkEntryLater(const thinkentry_t& lhs, const thinkentry_t& rhs)
+{
+	if (lhs.nextthink != rhs.nextthink)
+		return lhs.nextthink > rhs.nextthink;
+	return lhs.entnum > rhs.entnum;
+}
+
+/*
+================
+SV_ClearThinks
+
+Called when the edicts are set up for a new level
+================
+*/
+void SV_ClearThinks(void)
+{
+	sv_thinkheap.clear();
+	sv_inphysics = false;
+}
+
+/*
+================
+SV_ScheduleThink
+
+Called whenever an edict's nextthink is set
+================
+*/
+void SV_ScheduleThink(int entnum, float nextthink)
+{
+	int		i;
+
+	if (nextthink <= 0)
+		return;		// not thinking
+
+	// set for later in the frame that is running, SV_Physics will still get to it
+	if (sv_inphysics && entnum > sv_physicsedict && nextthink <= sv.time + host_frametime)
+		sv.mirror.due[entnum >> 5] |= 1u << (entnum & 31);
+
+	// throw out the stale entries when they start to pile up
+	if (sv_thinkheap.size() > 4 * (std::size_t)sv.num_edicts + 256)
+	{
+		sv_thinkheap.clear();
+		for (i = 0; i < sv.num_edicts; i++)
+		{
+			if (i != entnum && ED_InUse(sv.mirror, i) && sv.mirror.nextthink[i] > 0)
+				sv_thinkheap.push_back({sv.mirror.nextthink[i], i});
+		}
+		std::make_heap(sv_thinkheap.begin(), sv_thinkheap.end(), SV_ThinkEntryLater);
+	}
+
+	sv_thinkheap.push_back({nextthink, entnum});
+	std::push_heap(sv_thinkheap.begin(), sv_thinkheap.end(), SV_ThinkEntryLater);
+}
+
+/*
+================
+SV_PopDueThinks
+
+Flags the edicts that have to think this frame
+================
+*/
+static void SV_PopDueThinks(void)
+{
+	const double frameend = sv.time + host_frametime;
+
+	while (!sv_thinkheap.empty() && sv_thinkheap.front().nextthink <= frameend)
+	{
+		const thinkentry_t entry = sv_thinkheap.front();
+		std::pop_heap(sv_thinkheap.begin(), sv_thinkheap.end(), SV_ThinkEntryLater);
+		sv_thinkheap.pop_back();
+
+		if (entry.entnum < sv.num_edicts && sv.mirror.nextthink[entry.entnum] == entry.nextthink)
+			sv.mirror.due[entry.entnum >> 5] |= 1u << (entry.entnum & 31);
+	}
+}
+
+/*
+================
+SV_NextPhysicsEdict
+
+First edict from start on that SV_Physics has to look at: the clients,
+everything that moves and everything that is due to think.  The bits are
+read as they are now, entities that start moving or thinking further on in
+the frame are picked up just like the full scan of the edicts would.
+================
+*/
+static int SV_NextPhysicsEdict(int start)
+{
+	int				word, last;
+	unsigned int	bits;
+
+	if (start <= svs.maxclients)
+		return start;
+
+	last = (sv.num_edicts - 1) >> 5;
+	for (word = start >> 5; word <= last; word++)
+	{
+		bits = sv.mirror.moving[word] | sv.mirror.due[word];
+		if (word == start >> 5)
+			bits &= ~0u << (start & 31);
+		if (!bits)
+			continue;
+
+		for (int bit = 0; bit < 32; bit++)
+		{
+			if (bits & (1u << bit))
+				return (word << 5) + bit;
+		}
+	}
+
+	return sv.num_edicts;
+}
+
 //============================================================================
 
+/*
+================
+SV_MovePhase
+
+The profiler phase for the movetype handler SV_Physics is about to run
+================
+*/
+static profphase_t SV_MovePhase(edict_t* ent, int num)
+{
+	if (num > 0 && num <= svs.maxclients)
+		return PROF_MOVE_CLIENT;
+
+	switch ((int)ent->v.movetype)
+	{
+	case MOVETYPE_PUSH:
+		return PROF_MOVE_PUSH;
+	case MOVETYPE_NONE:
+		return PROF_MOVE_NONE;
+	case MOVETYPE_NOCLIP:
+		return PROF_MOVE_NOCLIP;
+	case MOVETYPE_STEP:
+		return PROF_MOVE_STEP;
+#ifdef QUAKE2
+	case MOVETYPE_FOLLOW:
+		return PROF_MOVE_FOLLOW;
+#endif
+	default:
+		return PROF_MOVE_TOSS;
+	}
+}
+
 /*
 ================
 SV_Physics
@@ -1184,28 +1382,67 @@ SV_Physics
 void SV_Physics(void)
 {
 	int		i;
+	float	thinktime;
 	edict_t* ent;
+	long long	start;
+	profphase_t	movephase;
 
 	// let the progs know that a new frame has started
 	pr_global_struct->time = sv.time;
+	start = SV_ProfTime();
 	g_Game->StartFrame(sv.edicts);
+	SV_ProfEnd(PROF_STARTFRAME, start);
+
+	// StartFrame may have moved things, so start with a clean trace memo
+	SV_NewTraceFrame();
 
 	//SV_CheckAllEnts ();
 
+	SV_PopDueThinks();
+
 	//
 	// treat each object in turn
 	//
-	ent = sv.edicts;
-	for (i = 0; i < sv.num_edicts; i++, ++ent)
+	sv_inphysics = true;
+	for (i = 0; i < sv.num_edicts; i++)
 	{
-		if (ent->free)
+		// only force_retouch has to visit every edict
+		if (!pr_global_struct->force_retouch)
+		{
+			i = SV_NextPhysicsEdict(i);
+			if (i >= sv.num_edicts)
+				break;
+		}
+
+		sv_physicsedict = i;
+		sv.mirror.due[i >> 5] &= ~(1u << (i & 31));
+
+		if (!ED_InUse(sv.mirror, i))
 			continue;
 
+		// entities that don't move only need a look when they are due to think,
+		// see SV_RunThink
+		if (sv.mirror.movetype[i] == MOVETYPE_NONE && i > svs.maxclients
+			&& !pr_global_struct->force_retouch)
+		{
+			thinktime = sv.mirror.nextthink[i];
+			if (thinktime <= 0 || thinktime > sv.time + host_frametime)
+				continue;
+		}
+
+		ent = EDICT_NUM(i);
+
 		if (pr_global_struct->force_retouch)
 		{
 			SV_LinkEdict(ent, true);	// force retouch even for stationary
 		}
 
+		if (sv_profiling)
+		{
+			movephase = SV_MovePhase(ent, i);
+			start = SV_ProfTime();
+		}
+
 		if (i > 0 && i <= svs.maxclients)
 			SV_Physics_Client(ent, i);
 		else if (ent->v.movetype == MOVETYPE_PUSH)
@@ -1230,14 +1467,299 @@ void SV_Physics(void)
 			SV_Physics_Toss(ent);
 		else
 			Sys_Error("SV_Physics: bad movetype %i", (int)ent->v.movetype);
+
+		if (sv_profiling)
+			SV_ProfEnd(movephase, start);
 	}
 
+	sv_inphysics = false;
+
 	if (pr_global_struct->force_retouch)
 		pr_global_struct->force_retouch--;
 
 	sv.time += host_frametime;
 }
 
+/*
+===============================================================================
+
+BENCHMARKS
+
+===============================================================================
+*/
+
+static void SV_BenchThink(edict_t* self)
+{
+	ED_SetNextThink(self, pr_global_struct->time + 0.5);
+}
+
+/*
+================
+SV_SpawnBenchEdicts
+
+Spawns a crowd of tossed, bouncing, flying and idle entities around the
+existing ones so most of them are inside the level.  Some of the idle ones
+think twice a second.  The same seed gives the same entities.
+================
+*/
+static void SV_SpawnBenchEdicts(std::vector<edict_t*>& spawned, int count, bool visible)
+{
+	static const float movetypes[] = {MOVETYPE_TOSS, MOVETYPE_BOUNCE, MOVETYPE_FLY, MOVETYPE_NONE};
+
+	int			i, j, numanchors;
+	unsigned int	seed;
+	edict_t* ent, * anchor;
+
+	if (count > sv.max_edicts - sv.num_edicts)
+	{
+		count = sv.max_edicts - sv.num_edicts;
+		Con_Printf("only room for %i more edicts, use -maxedicts to raise the limit\n", count);
+	}
+
+	numanchors = sv.num_edicts;
+
+	// deterministic, without disturbing the game's rand()
+	seed = 0x2545f491;
+	auto random = [&seed]()
+	{
+		seed = seed * 1103515245 + 12345;
+		return ((seed >> 8) & 0xffff) / 65535.0f;
+	};
+
+	for (i = 0; i < count; i++)
+	{
+		do
+		{
+			anchor = EDICT_NUM(1 + (int)(random() * (numanchors - 2)));
+		} while (anchor->free && numanchors > 2);
+
+		ent = ED_Alloc();
+		ED_SetClassname(ent, "benchmark");
+		ED_SetMovetype(ent, movetypes[i & 3]);
+		ent->v.solid = (i & 4) ? SOLID_BBOX : SOLID_NOT;
+		for (j = 0; j < 3; j++)
+		{
+			ent->v.mins[j] = -4;
+			ent->v.maxs[j] = 4;
+			ent->v.origin[j] = anchor->v.origin[j] + (anchor->v.mins[j] + anchor->v.maxs[j]) * 0.5 + (random() - 0.5f) * 256;
+			ent->v.velocity[j] = (random() - 0.5f) * 600;
+		}
+		VectorSubtract(ent->v.maxs, ent->v.mins, ent->v.size);
+
+		if (visible && anchor->v.model && anchor->v.model[0] != '*' && anchor->v.modelindex)
+		{
+			ent->v.model = anchor->v.model;
+			ED_SetModelIndex(ent, (float)anchor->v.modelindex);
+		}
+
+		if (ent->v.movetype == MOVETYPE_NONE && (i & 15) == 3)
+		{
+			ent->v.think = SV_BenchThink;
+			ED_SetNextThink(ent, sv.time + random());
+		}
+
+		SV_LinkEdict(ent, false);
+
+		spawned.push_back(ent);
+	}
+}
+
+static void SV_RemoveBenchEdicts(std::vector<edict_t*>& spawned)
+{
+	for (auto e : spawned)
+	{
+		if (!e->free)
+			ED_Free(e);
+	}
+
+	spawned.clear();
+}
+
+/*
+================
+SV_PhysicsBench_f
+
+Spawns a crowd of moving entities, runs a number of physics frames with them
+and reports the frame times, then removes them again.
+The rest of the level keeps running during the frames.
+
+sv_physicsbench [entities] [frames]
+================
+*/
+void SV_PhysicsBench_f(void)
+{
+	int			i, count, frames;
+	double		start, time, total, fastest, slowest;
+	double		save_frametime;
+	std::vector<edict_t*>	spawned;
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_physicsbench: no map running\n");
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 8000;
+	frames = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 100;
+	if (count < 0)
+		count = 0;
+	if (frames < 1)
+		frames = 1;
+
+	SV_SpawnBenchEdicts(spawned, count, false);
+
+	save_frametime = host_frametime;
+	host_frametime = 0.05;
+
+	total = 0;
+	fastest = 1e9;
+	slowest = 0;
+	for (i = 0; i < frames; i++)
+	{
+		start = Sys_FloatTime();
+		SV_Physics();
+		time = Sys_FloatTime() - start;
+
+		total += time;
+		fastest = std::min(fastest, time);
+		slowest = std::max(slowest, time);
+	}
+
+	host_frametime = save_frametime;
+
+	Con_Printf("%i frames with %i edicts (%i spawned)\n", frames, sv.num_edicts, (int)spawned.size());
+	Con_Printf("SV_Physics: %.3f ms avg, %.3f ms min, %.3f ms max\n",
+		total * 1000 / frames, fastest * 1000, slowest * 1000);
+
+	SV_RemoveBenchEdicts(spawned);
+}
+
+/*
+================
+SV_ReadCycleCounter
+
+Time stamp counter where there is one, nanoseconds otherwise
+================
+*/
+static unsigned long long SV_ReadCycleCounter(void)
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*
+================
+SV_FrameBench_f
+
+Times a server frame (physics plus an entity update for every active client)
+with a few hundred entities, and the per-frame sweeps over all edicts done
+by reading the edicts themselves against reading sv.mirror.
+
+sv_framebench [entities] [frames]
+================
+*/
+void SV_FrameBench_f(void)
+{
+	int			i, e, j, count, frames, clients;
+	unsigned long long	start, framecycles, edictcycles, mirrorcycles;
+	double		save_frametime;
+	int			edicthits, mirrorhits;
+	std::vector<edict_t*>	spawned;
+	std::vector<byte>	buffer(MAX_DATAGRAM);
+	sizebuf_t	msg;
+	edict_t* ent;
+	client_t* client;
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_framebench: no map running\n");
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 500;
+	frames = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 100;
+	if (count < 0)
+		count = 0;
+	if (frames < 1)
+		frames = 1;
+
+	SV_SpawnBenchEdicts(spawned, count, true);
+
+	save_frametime = host_frametime;
+	host_frametime = 0.05;
+
+	msg.data = buffer.data();
+	msg.maxsize = buffer.size();
+	msg.allowoverflow = true;
+
+	framecycles = edictcycles = mirrorcycles = 0;
+	edicthits = mirrorhits = 0;
+	clients = 0;
+
+	for (i = 0; i < frames; i++)
+	{
+		start = SV_ReadCycleCounter();
+
+		SV_Physics();
+
+		clients = 0;
+		for (j = 0, client = svs.clients; j < svs.maxclients; j++, client++)
+		{
+			if (!client->active)
+				continue;
+			SZ_Clear(&msg);
+			SV_WriteEntitiesToClient(client->edict, &msg);
+			clients++;
+		}
+
+		framecycles += SV_ReadCycleCounter() - start;
+
+		// what the physics and entity update sweeps looked at before sv.mirror
+		start = SV_ReadCycleCounter();
+		edicthits = 0;
+		for (e = 1; e < sv.num_edicts; e++)
+		{
+			ent = EDICT_NUM(e);
+			if (ent->free)
+				continue;
+			if (ent->v.movetype == MOVETYPE_NONE
+				&& (ent->v.nextthink <= 0 || ent->v.nextthink > sv.time + host_frametime))
+				continue;
+			if (!ent->v.modelindex)
+				continue;
+			edicthits++;
+		}
+		edictcycles += SV_ReadCycleCounter() - start;
+
+		start = SV_ReadCycleCounter();
+		mirrorhits = 0;
+		for (e = 1; e < sv.num_edicts; e++)
+		{
+			if (!ED_InUse(sv.mirror, e))
+				continue;
+			if (sv.mirror.movetype[e] == MOVETYPE_NONE
+				&& (sv.mirror.nextthink[e] <= 0 || sv.mirror.nextthink[e] > sv.time + host_frametime))
+				continue;
+			if (!sv.mirror.modelindex[e])
+				continue;
+			mirrorhits++;
+		}
+		mirrorcycles += SV_ReadCycleCounter() - start;
+	}
+
+	host_frametime = save_frametime;
+
+	Con_Printf("%i frames with %i edicts (%i spawned), %i clients\n", frames, sv.num_edicts, (int)spawned.size(), clients);
+	Con_Printf("server frame:  %12llu cycles\n", framecycles / frames);
+	Con_Printf("edict sweep:   %12llu cycles, %i hits\n", edictcycles / frames, edicthits);
+	Con_Printf("mirror sweep:  %12llu cycles, %i hits\n", mirrorcycles / frames, mirrorhits);
+
+	SV_RemoveBenchEdicts(spawned);
+}
+
 
 #ifdef QUAKE2
 trace_t SV_Trace_Toss(edict_t* ent, edict_t* ignore)
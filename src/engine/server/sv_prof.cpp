@@ -0,0 +1,368 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_prof.c -- per tick server profiler
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "quakedef.h"
+#include "game/IGame.h"
+
+cvar_t	sv_profile = {"sv_profile", "0"};	// record per tick timings for profstats and profdump
+
+#define	PROF_TICKS		1024		// ticks kept for the percentiles
+#define	PROF_EVENTS		(1 << 18)	// trace events kept for profdump
+
+static const char* const prof_phasenames[PROF_NUMPHASES] =
+{
+	"tick",
+	"network",
+	"runclients",
+	"startframe",
+	"physics",
+	"move client",
+	"move push",
+	"move none",
+	"move noclip",
+	"move step",
+	"move toss",
+	"move follow",
+	"think",
+	"sendmessages"
+};
+
+typedef struct
+{
+	long long	start;			// nanoseconds since the profiler started
+	int			duration;
+	int			name;			// a profphase_t, or PROF_NUMPHASES + think index
+} profevent_t;
+
+typedef struct
+{
+	void		(*think)(edict_t*);
+	std::string	classname;
+	std::string	label;			// "classname function" for the trace
+	int			calls;
+	long long	total, max;
+} profthink_t;
+
+bool		sv_profiling;
+
+static std::chrono::steady_clock::time_point	prof_base;
+
+static long long	prof_tick[PROF_NUMPHASES];			// the tick being recorded
+static long long	prof_ticks[PROF_TICKS][PROF_NUMPHASES];
+static int			prof_numticks;
+static bool			prof_intick;
+
+static std::vector<profevent_t>	prof_events;		// ring
+static int			prof_numevents;
+
+static std::vector<profthink_t>	prof_thinks;
+static std::map<std::pair<void (*)(edict_t*), const char*>, int>	prof_thinkindex;
+
+/*
+================
+SV_ProfTime
+================
+*/
+long long SV_ProfTime(void)
+{
+	if (!sv_profiling)
+		return 0;
+
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - prof_base).count();
+}
+
+/*
+================
+SV_ProfAddEvent
+================
+*/
+static void SV_ProfAddEvent(int name, long long start, long long duration)
+{
+	profevent_t* ev = &prof_events[prof_numevents++ % PROF_EVENTS];
+
+	ev->start = start;
+	ev->duration = (int)std::min(duration, 0x7fffffffLL);
+	ev->name = name;
+}
+
+/*
+================
+SV_ProfEnd
+
+Adds the time since start to a phase.  Nested phases are inclusive, so
+physics includes the movetypes and the movetypes include their thinks.
+================
+*/
+void SV_ProfEnd(profphase_t phase, long long start)
+{
+	if (!sv_profiling || !prof_intick)
+		return;
+
+	const long long duration = SV_ProfTime() - start;
+
+	prof_tick[phase] += duration;
+	SV_ProfAddEvent(phase, start, duration);
+}
+
+/*
+================
+SV_ProfThink
+
+Charges a think call to its entity class and function
+================
+*/
+void SV_ProfThink(edict_t* ent, void (*think)(edict_t*), long long start)
+{
+	if (!sv_profiling || !prof_intick)
+		return;
+
+	const long long duration = SV_ProfTime() - start;
+
+	// the classname pointer is only stable within one map, see SV_ProfReset
+	const auto key = std::make_pair(think, ent->v.classname);
+
+	auto it = prof_thinkindex.find(key);
+
+	if (it == prof_thinkindex.end())
+	{
+		profthink_t	t{};
+		const char* function = think ? g_Game->FindFunctionName(reinterpret_cast<FunctionMap::Function>(think)) : nullptr;
+
+		t.think = think;
+		t.classname = ent->v.classname ? ent->v.classname : "";
+		t.label = t.classname + " " + (function ? function : "?");
+
+		it = prof_thinkindex.emplace(key, (int)prof_thinks.size()).first;
+		prof_thinks.push_back(std::move(t));
+	}
+
+	profthink_t* t = &prof_thinks[it->second];
+
+	t->calls++;
+	t->total += duration;
+	t->max = std::max(t->max, duration);
+
+	prof_tick[PROF_THINK] += duration;
+	SV_ProfAddEvent(PROF_NUMPHASES + it->second, start, duration);
+}
+
+/*
+================
+SV_ProfBeginTick
+================
+*/
+void SV_ProfBeginTick(void)
+{
+	sv_profiling = sv_profile.value && sv.active;
+	prof_intick = sv_profiling;
+
+	if (!sv_profiling)
+		return;
+
+	if (prof_events.empty())
+		prof_events.resize(PROF_EVENTS);
+
+	memset(prof_tick, 0, sizeof(prof_tick));
+	prof_tick[PROF_FRAME] = SV_ProfTime();
+}
+
+/*
+================
+SV_ProfEndTick
+================
+*/
+void SV_ProfEndTick(void)
+{
+	if (!sv_profiling || !prof_intick)
+		return;
+
+	const long long start = prof_tick[PROF_FRAME];
+	const long long duration = SV_ProfTime() - start;
+
+	prof_tick[PROF_FRAME] = duration;
+	SV_ProfAddEvent(PROF_FRAME, start, duration);
+
+	memcpy(prof_ticks[prof_numticks++ % PROF_TICKS], prof_tick, sizeof(prof_tick));
+	prof_intick = false;
+}
+
+/*
+================
+SV_ProfReset
+
+Called for every new map, since think stats are keyed by classname pointers
+================
+*/
+void SV_ProfReset(void)
+{
+	prof_numticks = 0;
+	prof_numevents = 0;
+	prof_intick = false;
+	prof_thinks.clear();
+	prof_thinkindex.clear();
+}
+
+/*
+================
+SV_ProfStats_f
+================
+*/
+static void SV_ProfStats_f(void)
+{
+	std::vector<long long>	times;
+	std::vector<int>		order;
+	int		i, phase, count;
+
+	if (Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "reset"))
+	{
+		SV_ProfReset();
+		return;
+	}
+
+	count = std::min(prof_numticks, PROF_TICKS);
+
+	if (!count)
+	{
+		Con_Printf("No ticks recorded, set sv_profile 1\n");
+		return;
+	}
+
+	Con_Printf("%i ticks, milliseconds\n", count);
+	Con_Printf("%-14s %7s %7s %7s %7s %7s\n", "phase", "avg", "p50", "p95", "p99", "max");
+
+	for (phase = 0; phase < PROF_NUMPHASES; phase++)
+	{
+		long long	total = 0;
+
+		times.resize(count);
+		for (i = 0; i < count; i++)
+		{
+			times[i] = prof_ticks[i][phase];
+			total += times[i];
+		}
+
+		std::sort(times.begin(), times.end());
+
+		Con_Printf("%-14s %7.3f %7.3f %7.3f %7.3f %7.3f\n", prof_phasenames[phase],
+			total / 1e6 / count,
+			times[count / 2] / 1e6,
+			times[count * 95 / 100] / 1e6,
+			times[count * 99 / 100] / 1e6,
+			times[count - 1] / 1e6);
+	}
+
+	if (prof_thinks.empty())
+		return;
+
+	order.resize(prof_thinks.size());
+	for (i = 0; i < (int)order.size(); i++)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), [](int a, int b)
+		{
+			return prof_thinks[a].total > prof_thinks[b].total;
+		});
+
+	Con_Printf("\nthinks by total time since the map started\n");
+	Con_Printf("%9s %8s %8s %9s  %s\n", "calls", "avg us", "max us", "total ms", "class function");
+
+	for (i = 0; i < (int)order.size() && i < 20; i++)
+	{
+		const profthink_t* t = &prof_thinks[order[i]];
+
+		Con_Printf("%9i %8.1f %8.1f %9.2f  %s\n", t->calls,
+			t->total / 1e3 / t->calls, t->max / 1e3, t->total / 1e6, t->label.c_str());
+	}
+}
+
+/*
+================
+SV_ProfDump_f
+
+Writes the recorded events as a Chrome trace, for chrome://tracing or Perfetto
+================
+*/
+static void SV_ProfDump_f(void)
+{
+	char	name[MAX_OSPATH];
+	FILE* f;
+	int		i, first, count;
+
+	if (!prof_numevents)
+	{
+		Con_Printf("No events recorded, set sv_profile 1\n");
+		return;
+	}
+
+	sprintf(name, "%s/%s", com_gamedir, Cmd_Argc() > 1 ? Cmd_Argv(1) : "svprofile.json");
+	COM_DefaultExtension(name, ".json");
+
+	f = fopen(name, "w");
+	if (!f)
+	{
+		Con_Printf("ERROR: couldn't open %s.\n", name);
+		return;
+	}
+
+	count = std::min(prof_numevents, PROF_EVENTS);
+	first = prof_numevents - count;
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	for (i = 0; i < count; i++)
+	{
+		const profevent_t* ev = &prof_events[(first + i) % PROF_EVENTS];
+		const char* label;
+
+		if (ev->name < PROF_NUMPHASES)
+			label = prof_phasenames[ev->name];
+		else
+			label = prof_thinks[ev->name - PROF_NUMPHASES].label.c_str();
+
+		fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n",
+			i ? "," : "", label, ev->name < PROF_NUMPHASES ? "server" : "think", ev->start / 1e3, ev->duration / 1e3);
+	}
+
+	fprintf(f, "]}\n");
+	fclose(f);
+
+	Con_Printf("Wrote %i events to %s\n", count, name);
+}
+
+/*
+================
+SV_ProfInit
+================
+*/
+void SV_ProfInit(void)
+{
+	prof_base = std::chrono::steady_clock::now();
+
+	Cvar_RegisterVariable(&sv_profile);
+	Cmd_AddCommand("profstats", SV_ProfStats_f);
+	Cmd_AddCommand("profdump", SV_ProfDump_f);
+}
@@ -470,6 +470,10 @@ void SV_ReadClientMove(usercmd_t* move)
 	// read light level
 	host_client->edict->v.light_level = MSG_ReadByte();
 #endif
+
+	// read the last entity frame the client received
+	if (host_client->protocol == PROTOCOL_DELTA)
+		host_client->delta_sequence = MSG_ReadLong();
 }
 
 /*
@@ -561,6 +565,8 @@ bool SV_ReadClientMessage(void)
 					ret = 1;
 				else if (Q_strncasecmp(s, "prespawn", 8) == 0)
 					ret = 1;
+				else if (Q_strncasecmp(s, "protocol", 8) == 0)
+					ret = 1;
 				else if (Q_strncasecmp(s, "kick", 4) == 0)
 					ret = 1;
 				else if (Q_strncasecmp(s, "ping", 4) == 0)
@@ -601,6 +607,9 @@ void SV_RunClients(void)
 {
 	int				i;
 
+	// fetch what every client sent since the last frame in one go
+	g_Networking->ReceiveMessages();
+
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
 		if (!host_client->active)
@@ -625,5 +634,8 @@ void SV_RunClients(void)
 		if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game))
 			SV_ClientThink();
 	}
+
+	// the last message was parsed in place, give net_message its buffer back
+	g_Networking->ReleaseMessage();
 }
 
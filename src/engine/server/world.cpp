@@ -19,6 +19,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // world.c -- world query functions
 
+#include <algorithm>
+#include <vector>
+
 #include "quakedef.h"
 #include "game/IGame.h"
 
@@ -44,6 +47,7 @@ typedef struct
 
 
 extern int SV_HullPointContents(hull_t* hull, int num, const vec3_t p);
+static void SV_ClearTraceRecording(void);
 
 /*
 ===============================================================================
@@ -179,6 +183,8 @@ ENTITY AREA CHECKING
 ===============================================================================
 */
 
+cvar_t	sv_broadphase = {"sv_broadphase", "0"};	// BROADPHASE_*, takes effect on the next map
+
 typedef struct areanode_s
 {
 	int		axis;		// -1 = leaf node
@@ -194,6 +200,43 @@ typedef struct areanode_s
 static	areanode_t	sv_areanodes[AREA_NODES];
 static	int			sv_numareanodes;
 
+static	int			sv_broadphasetype;
+static	unsigned int	sv_linksequence;
+
+/*
+The area grid buckets entities by the cells their absolute bounds cover on the
+x / y plane, so a query only looks at entities near the moving object.
+Entities that cover too many cells (large triggers, long brush entities) are
+kept in separate lists that every query checks.
+
+To make the grid a drop-in replacement for the area node tree, every linked
+entity also records the area node it would be linked under and a link
+sequence number. Sorting query results on those reproduces the exact
+order in which the area node walk visits entities.
+*/
+
+#define	AREAGRID_MAXCELLS		64		// per axis
+#define	AREAGRID_MINCELLSIZE	128
+#define	AREAGRID_MAXSPAN		16		// cells an entity can cover before it goes in the large lists
+
+typedef struct
+{
+	std::vector<edict_t*>	trigger_edicts;
+	std::vector<edict_t*>	solid_edicts;
+} areacell_t;
+
+static struct
+{
+	vec3_t	mins;
+	float	cellsize;
+	int		size[2];
+	std::vector<areacell_t>	cells;
+	link_t	trigger_edicts;		// large entities
+	link_t	solid_edicts;
+	link_t	cell_edicts;		// everything else, so ent->area always marks a linked entity
+	int		querycount;		// never reset, stale stamps on edicts must not match a new query
+} sv_areagrid;
+
 /*
 ===============
 SV_CreateAreaNode
@@ -241,19 +284,96 @@ areanode_t* SV_CreateAreaNode(int depth, vec3_t mins, vec3_t maxs)
 
 /*
 ===============
-SV_ClearWorld
+SV_CreateAreaGrid
 
 ===============
 */
-void SV_ClearWorld(void)
+void SV_CreateAreaGrid(vec3_t mins, vec3_t maxs)
 {
-	SV_InitBoxHull();
+	float	extent;
+	int		i;
+
+	extent = std::max(maxs[0] - mins[0], maxs[1] - mins[1]);
+
+	sv_areagrid.cellsize = ceil(extent / AREAGRID_MAXCELLS);
+	if (sv_areagrid.cellsize < AREAGRID_MINCELLSIZE)
+		sv_areagrid.cellsize = AREAGRID_MINCELLSIZE;
+
+	VectorCopy(mins, sv_areagrid.mins);
+	for (i = 0; i < 2; i++)
+	{
+		sv_areagrid.size[i] = (int)ceil((maxs[i] - mins[i]) / sv_areagrid.cellsize);
+		if (sv_areagrid.size[i] < 1)
+			sv_areagrid.size[i] = 1;
+		else if (sv_areagrid.size[i] > AREAGRID_MAXCELLS)
+			sv_areagrid.size[i] = AREAGRID_MAXCELLS;
+	}
+
+	sv_areagrid.cells.clear();
+	sv_areagrid.cells.resize(sv_areagrid.size[0] * sv_areagrid.size[1]);
+
+	ClearLink(&sv_areagrid.trigger_edicts);
+	ClearLink(&sv_areagrid.solid_edicts);
+	ClearLink(&sv_areagrid.cell_edicts);
+}
+
+/*
+===============
+SV_SetBroadphase
+
+Selects the entity area index.  All entities must be unlinked first.
+===============
+*/
+void SV_SetBroadphase(int type)
+{
+	sv_broadphasetype = type == BROADPHASE_AREAGRID ? BROADPHASE_AREAGRID : BROADPHASE_AREANODES;
 
 	memset(sv_areanodes, 0, sizeof(sv_areanodes));
 	sv_numareanodes = 0;
 	SV_CreateAreaNode(0, sv.worldmodel->mins, sv.worldmodel->maxs);
+
+	if (sv_broadphasetype == BROADPHASE_AREAGRID)
+		SV_CreateAreaGrid(sv.worldmodel->mins, sv.worldmodel->maxs);
+	else
+		sv_areagrid.cells.clear();
+
+	sv_linksequence = 0;
+}
+
+/*
+===============
+SV_ClearWorld
+
+===============
+*/
+void SV_ClearWorld(void)
+{
+	SV_InitBoxHull();
+	SV_NewTraceFrame();
+	SV_ClearTraceRecording();
+
+	SV_SetBroadphase((int)sv_broadphase.value);
 }
 
+/*
+===============
+SV_AreaGridRange
+
+Cell range covered by the given bounds, clamped to the grid
+===============
+*/
+static void SV_AreaGridRange(const vec3_t mins, const vec3_t maxs, int* range)
+{
+	int		i, c;
+
+	for (i = 0; i < 2; i++)
+	{
+		c = (int)floor((mins[i] - sv_areagrid.mins[i]) / sv_areagrid.cellsize);
+		range[i] = std::clamp(c, 0, sv_areagrid.size[i] - 1);
+		c = (int)floor((maxs[i] - sv_areagrid.mins[i]) / sv_areagrid.cellsize);
+		range[2 + i] = std::clamp(c, 0, sv_areagrid.size[i] - 1);
+	}
+}
 
 /*
 ===============
@@ -263,10 +383,173 @@ SV_UnlinkEdict
 */
 void SV_UnlinkEdict(edict_t* ent)
 {
+	int		x, y;
+	const int* cells;
+
 	if (!ent->area.prev)
 		return;		// not linked in anywhere
 	RemoveLink(&ent->area);
 	ent->area.prev = ent->area.next = NULL;
+
+	cells = ent->arealink.cells;
+	if (sv_broadphasetype != BROADPHASE_AREAGRID || cells[0] == -1)
+		return;
+
+	for (y = cells[1]; y <= cells[3]; y++)
+	{
+		for (x = cells[0]; x <= cells[2]; x++)
+		{
+			areacell_t& cell = sv_areagrid.cells[y * sv_areagrid.size[0] + x];
+			auto& list = ent->arealink.trigger ? cell.trigger_edicts : cell.solid_edicts;
+			auto it = std::find(list.begin(), list.end(), ent);
+
+			// order inside a cell doesn't matter, queries sort their results
+			*it = list.back();
+			list.pop_back();
+		}
+	}
+}
+
+/*
+====================
+SV_AreaNodeEdicts
+====================
+*/
+static void SV_AreaNodeEdicts(areanode_t* node, const vec3_t mins, const vec3_t maxs, edict_t** list, int* count, int maxcount, int areatype)
+{
+	link_t* l, * start;
+	edict_t* check;
+
+	if (areatype == AREA_SOLID)
+		start = &node->solid_edicts;
+	else
+		start = &node->trigger_edicts;
+
+	for (l = start->next; l != start; l = l->next)
+	{
+		check = EDICT_FROM_AREA(l);
+
+		if (mins[0] > check->v.absmax[0]
+			|| mins[1] > check->v.absmax[1]
+			|| mins[2] > check->v.absmax[2]
+			|| maxs[0] < check->v.absmin[0]
+			|| maxs[1] < check->v.absmin[1]
+			|| maxs[2] < check->v.absmin[2])
+			continue;
+
+		if (*count == maxcount)
+		{
+			Con_Printf("SV_AreaEdicts: MAXCOUNT\n");
+			return;
+		}
+
+		list[*count] = check;
+		(*count)++;
+	}
+
+	// recurse down both sides
+	if (node->axis == -1)
+		return;
+
+	if (maxs[node->axis] > node->dist)
+		SV_AreaNodeEdicts(node->children[0], mins, maxs, list, count, maxcount, areatype);
+	if (mins[node->axis] < node->dist)
+		SV_AreaNodeEdicts(node->children[1], mins, maxs, list, count, maxcount, areatype);
+}
+
+/*
+====================
+SV_AreaGridEdicts
+====================
+*/
+static int SV_AreaGridEdicts(const vec3_t mins, const vec3_t maxs, edict_t** list, int maxcount, int areatype)
+{
+	int			range[4];
+	int			x, y;
+	int			count;
+	link_t* l, * start;
+	edict_t* check;
+
+	count = 0;
+
+	++sv_areagrid.querycount;
+
+	auto add = [&](edict_t* check)
+	{
+		if (check->arealink.query == sv_areagrid.querycount)
+			return true;	// already added from another cell
+		check->arealink.query = sv_areagrid.querycount;
+
+		if (mins[0] > check->v.absmax[0]
+			|| mins[1] > check->v.absmax[1]
+			|| mins[2] > check->v.absmax[2]
+			|| maxs[0] < check->v.absmin[0]
+			|| maxs[1] < check->v.absmin[1]
+			|| maxs[2] < check->v.absmin[2])
+			return true;
+
+		if (count == maxcount)
+		{
+			Con_Printf("SV_AreaEdicts: MAXCOUNT\n");
+			return false;
+		}
+
+		list[count++] = check;
+		return true;
+	};
+
+	SV_AreaGridRange(mins, maxs, range);
+
+	for (y = range[1]; y <= range[3]; y++)
+	{
+		for (x = range[0]; x <= range[2]; x++)
+		{
+			const areacell_t& cell = sv_areagrid.cells[y * sv_areagrid.size[0] + x];
+			const auto& celllist = areatype == AREA_SOLID ? cell.solid_edicts : cell.trigger_edicts;
+
+			for (auto check : celllist)
+			{
+				if (!add(check))
+					goto sort;
+			}
+		}
+	}
+
+	start = areatype == AREA_SOLID ? &sv_areagrid.solid_edicts : &sv_areagrid.trigger_edicts;
+	for (l = start->next; l != start; l = l->next)
+	{
+		check = EDICT_FROM_AREA(l);
+		if (!add(check))
+			break;
+	}
+
+sort:
+	// visit in area node order
+	std::sort(list, list + count, [](const edict_t* lhs, const edict_t* rhs)
+		{
+			if (lhs->arealink.node != rhs->arealink.node)
+				return lhs->arealink.node < rhs->arealink.node;
+			return lhs->arealink.sequence < rhs->arealink.sequence;
+		});
+
+	return count;
+}
+
+/*
+====================
+SV_AreaEdicts
+====================
+*/
+int SV_AreaEdicts(const vec3_t mins, const vec3_t maxs, edict_t** list, int maxcount, int areatype)
+{
+	int		count;
+
+	if (sv_broadphasetype == BROADPHASE_AREAGRID)
+		return SV_AreaGridEdicts(mins, maxs, list, maxcount, areatype);
+
+	count = 0;
+	SV_AreaNodeEdicts(sv_areanodes, mins, maxs, list, &count, maxcount, areatype);
+	return count;
 }
 
 
@@ -275,20 +558,28 @@ void SV_UnlinkEdict(edict_t* ent)
 SV_TouchLinks
 ====================
 */
-void SV_TouchLinks(edict_t* ent, areanode_t* node)
+void SV_TouchLinks(edict_t* ent)
 {
-	link_t* l, * next;
+	int			i, num, mark;
 	edict_t* touch;
+	edict_t** touchlist;
+
+	// too big for the stack, and a touch function can link an entity and come
+	// back in here, so each call takes its own list from the thread's scratch
+	mark = Scratch_Mark();
+	touchlist = reinterpret_cast<edict_t**>(Scratch_Alloc(MAX_EDICTS * sizeof(edict_t*)));
+
+	num = SV_AreaEdicts(ent->v.absmin, ent->v.absmax, touchlist, MAX_EDICTS, AREA_TRIGGERS);
 
 	// touch linked edicts
-	for (l = node->trigger_edicts.next; l != &node->trigger_edicts; l = next)
+	for (i = 0; i < num; i++)
 	{
-		next = l->next;
-		touch = EDICT_FROM_AREA(l);
-		if (touch == ent)
+		touch = touchlist[i];
+		if (touch == ent || touch->free)
 			continue;
 		if (!touch->v.touch || touch->v.solid != SOLID_TRIGGER)
 			continue;
+		// a previous touch may have moved either entity
 		if (ent->v.absmin[0] > touch->v.absmax[0]
 			|| ent->v.absmin[1] > touch->v.absmax[1]
 			|| ent->v.absmin[2] > touch->v.absmax[2]
@@ -300,14 +591,7 @@ void SV_TouchLinks(edict_t* ent, areanode_t* node)
 		g_Game->EntityTouch(touch, ent);
 	}
 
-	// recurse down both sides
-	if (node->axis == -1)
-		return;
-
-	if (ent->v.absmax[node->axis] > node->dist)
-		SV_TouchLinks(ent, node->children[0]);
-	if (ent->v.absmin[node->axis] < node->dist)
-		SV_TouchLinks(ent, node->children[1]);
+	Scratch_FreeToMark(mark);
 }
 
 
@@ -323,6 +607,7 @@ void SV_FindTouchedLeafs(edict_t* ent, mnode_t* node)
 	mleaf_t* leaf;
 	int			sides;
 	int			leafnum;
+	int			cluster;
 
 	if (node->contents == CONTENTS_SOLID)
 		return;
@@ -331,14 +616,20 @@ void SV_FindTouchedLeafs(edict_t* ent, mnode_t* node)
 
 	if (node->contents < 0)
 	{
-		if (ent->num_leafs == MAX_ENT_LEAFS)
-			return;
+		int& num_leafs = sv.mirror.num_leafs[ent->entnum];
 
 		leaf = (mleaf_t*)node;
 		leafnum = leaf - sv.worldmodel->leafs - 1;
 
-		ent->leafnums[ent->num_leafs] = leafnum;
-		ent->num_leafs++;
+		cluster = leafnum >> LEAF_CLUSTER_SHIFT;
+		sv.mirror.clusters[ent->entnum][cluster >> 6] |= 1ull << (cluster & 63);
+
+		// too many to list, visibility is checked from the headnode instead
+		if (num_leafs == MAX_ENT_LEAFS)
+			return;
+
+		sv.mirror.leafnums[ent->entnum][num_leafs] = leafnum;
+		num_leafs++;
 		return;
 	}
 
@@ -355,6 +646,82 @@ void SV_FindTouchedLeafs(edict_t* ent, mnode_t* node)
 		SV_FindTouchedLeafs(ent, node->children[1]);
 }
 
+/*
+===============
+SV_HeadNode
+
+Returns the first node the box crosses, or the leaf it is in
+===============
+*/
+static mnode_t* SV_HeadNode(vec3_t absmin, vec3_t absmax)
+{
+	mnode_t* node;
+	int			sides;
+
+	node = sv.worldmodel->nodes;
+	while (node->contents >= 0)
+	{
+		sides = BOX_ON_PLANE_SIDE(absmin, absmax, node->plane);
+		if (sides == 1)
+			node = node->children[0];
+		else if (sides == 2)
+			node = node->children[1];
+		else
+			break;
+	}
+
+	return node;
+}
+
+/*
+===============
+SV_LinkEdictLeafs
+
+Finds the leafs and leaf clusters touched by the entity, and moves it to the
+edict lists of its new clusters
+===============
+*/
+static void SV_LinkEdictLeafs(edict_t* ent)
+{
+	int			c, w;
+	const int	e = ent->entnum;
+	uint64_t* clusters = sv.mirror.clusters[e];
+	uint64_t	bits;
+	const uint64_t	entbit = 1ull << (e & 63);
+
+	// remove from the old clusters
+	for (w = 0; w < CLUSTER_WORDS; w++)
+	{
+		for (bits = clusters[w]; bits; bits &= bits - 1)
+		{
+			c = w * 64 + Q_LowestBit64(bits);
+			sv.mirror.clusterents[c * sv.mirror.clusterwords + (e >> 6)] &= ~entbit;
+		}
+		clusters[w] = 0;
+	}
+
+	sv.mirror.num_leafs[e] = 0;
+	sv.mirror.headnode[e] = NULL;
+
+	if (!ent->v.modelindex)
+		return;
+
+	SV_FindTouchedLeafs(ent, sv.worldmodel->nodes);
+
+	if (sv.mirror.num_leafs[e] == MAX_ENT_LEAFS)
+		sv.mirror.headnode[e] = SV_HeadNode(ent->v.absmin, ent->v.absmax);
+
+	// add to the new ones
+	for (w = 0; w < CLUSTER_WORDS; w++)
+	{
+		for (bits = clusters[w]; bits; bits &= bits - 1)
+		{
+			c = w * 64 + Q_LowestBit64(bits);
+			sv.mirror.clusterents[c * sv.mirror.clusterwords + (e >> 6)] |= entbit;
+		}
+	}
+}
+
 /*
 ===============
 SV_LinkEdict
@@ -364,6 +731,8 @@ SV_LinkEdict
 void SV_LinkEdict(edict_t* ent, bool touch_triggers)
 {
 	areanode_t* node;
+	int			x, y;
+	int* cells;
 
 	if (ent->area.prev)
 		SV_UnlinkEdict(ent);	// unlink from old position
@@ -429,9 +798,7 @@ void SV_LinkEdict(edict_t* ent, bool touch_triggers)
 	}
 
 	// link to PVS leafs
-	ent->num_leafs = 0;
-	if (ent->v.modelindex)
-		SV_FindTouchedLeafs(ent, sv.worldmodel->nodes);
+	SV_LinkEdictLeafs(ent);
 
 	if (ent->v.solid == SOLID_NOT)
 		return;
@@ -450,20 +817,252 @@ void SV_LinkEdict(edict_t* ent, bool touch_triggers)
 			break;		// crosses the node
 	}
 
+	ent->arealink.node = node - sv_areanodes;
+	ent->arealink.sequence = sv_linksequence++;
+	ent->arealink.trigger = ent->v.solid == SOLID_TRIGGER;
+
 	// link it in	
 
-	if (ent->v.solid == SOLID_TRIGGER)
-		InsertLinkBefore(&ent->area, &node->trigger_edicts);
+	if (sv_broadphasetype == BROADPHASE_AREAGRID)
+	{
+		cells = ent->arealink.cells;
+		SV_AreaGridRange(ent->v.absmin, ent->v.absmax, cells);
+
+		if ((cells[2] - cells[0] + 1) * (cells[3] - cells[1] + 1) > AREAGRID_MAXSPAN)
+		{
+			cells[0] = -1;
+
+			if (ent->arealink.trigger)
+				InsertLinkBefore(&ent->area, &sv_areagrid.trigger_edicts);
+			else
+				InsertLinkBefore(&ent->area, &sv_areagrid.solid_edicts);
+		}
+		else
+		{
+			for (y = cells[1]; y <= cells[3]; y++)
+			{
+				for (x = cells[0]; x <= cells[2]; x++)
+				{
+					areacell_t& cell = sv_areagrid.cells[y * sv_areagrid.size[0] + x];
+
+					if (ent->arealink.trigger)
+						cell.trigger_edicts.push_back(ent);
+					else
+						cell.solid_edicts.push_back(ent);
+				}
+			}
+
+			InsertLinkBefore(&ent->area, &sv_areagrid.cell_edicts);
+		}
+	}
 	else
-		InsertLinkBefore(&ent->area, &node->solid_edicts);
+	{
+		if (ent->arealink.trigger)
+			InsertLinkBefore(&ent->area, &node->trigger_edicts);
+		else
+			InsertLinkBefore(&ent->area, &node->solid_edicts);
+	}
 
 	// if touch_triggers, touch all entities at this node and decend for more
 	if (touch_triggers)
-		SV_TouchLinks(ent, sv_areanodes);
+		SV_TouchLinks(ent);
 }
 
 
 
+/*
+===============================================================================
+
+TRACE MEMO
+
+Monster movement asks the same questions of the static hulls many times a
+frame: SV_movestep, SV_CheckBottom's corner probes, visible() and CanDamage()
+all retrace the same endpoints.  Results against bsp hulls only depend on the
+hull and the endpoints, so they are remembered for the rest of the frame.
+The box hull is rebuilt for every entity and is never memoized.
+
+===============================================================================
+*/
+
+cvar_t	sv_tracememo = {"sv_tracememo", "1"};
+
+#define	TRACE_MEMO_SIZE		4096	// must be a power of two
+#define	POINT_MEMO_SIZE		1024	// must be a power of two
+
+typedef struct
+{
+	int			frame;
+	hull_t* hull;
+	vec3_t		offset, start, end;
+	trace_t		trace;			// before the entity is filled in
+} tracememo_t;
+
+typedef struct
+{
+	int			frame;
+	vec3_t		point;
+	int			contents;
+} pointmemo_t;
+
+static tracememo_t	sv_tracememos[TRACE_MEMO_SIZE];
+static pointmemo_t	sv_pointmemos[POINT_MEMO_SIZE];
+static int			sv_traceframe = 1;	// entries from other frames are stale
+
+/*
+==================
+SV_NewTraceFrame
+
+Forgets every memoized trace, called at the start of each physics frame
+and whenever the world changes
+==================
+*/
+void SV_NewTraceFrame(void)
+{
+	sv_traceframe++;
+}
+
+/*
+==================
+SV_HashFloats
+
+FNV-1a over the bit patterns, so -0 and 0 hash (and compare) differently
+==================
+*/
+static unsigned SV_HashFloats(unsigned hash, const float* f, int count)
+{
+	uint32_t	bits;
+	int			i;
+
+	for (i = 0; i < count; i++)
+	{
+		memcpy(&bits, &f[i], sizeof(bits));
+		hash = (hash ^ bits) * 16777619u;
+	}
+
+	return hash;
+}
+
+static bool SV_SameVector(const vec3_t a, const vec3_t b)
+{
+	return !memcmp(a, b, sizeof(vec3_t));
+}
+
+static tracememo_t* SV_TraceMemoSlot(hull_t* hull, const vec3_t offset, const vec3_t start, const vec3_t end)
+{
+	unsigned	hash;
+
+	hash = 2166136261u ^ (unsigned)((uintptr_t)hull >> 4);
+	hash = SV_HashFloats(hash, offset, 3);
+	hash = SV_HashFloats(hash, start, 3);
+	hash = SV_HashFloats(hash, end, 3);
+
+	return &sv_tracememos[(hash ^ (hash >> 15)) & (TRACE_MEMO_SIZE - 1)];
+}
+
+/*
+==================
+SV_LookupTraceMemo
+
+Returns true and fills in trace if the same hull trace was already done
+this frame
+==================
+*/
+static bool SV_LookupTraceMemo(hull_t* hull, const vec3_t offset, const vec3_t start, const vec3_t end, trace_t* trace)
+{
+	tracememo_t* memo;
+
+	memo = SV_TraceMemoSlot(hull, offset, start, end);
+	if (memo->frame != sv_traceframe || memo->hull != hull
+		|| !SV_SameVector(memo->offset, offset)
+		|| !SV_SameVector(memo->start, start)
+		|| !SV_SameVector(memo->end, end))
+		return false;
+
+	*trace = memo->trace;
+	return true;
+}
+
+static void SV_StoreTraceMemo(hull_t* hull, const vec3_t offset, const vec3_t start, const vec3_t end, const trace_t* trace)
+{
+	tracememo_t* memo;
+
+	memo = SV_TraceMemoSlot(hull, offset, start, end);
+	memo->frame = sv_traceframe;
+	memo->hull = hull;
+	VectorCopy(offset, memo->offset);
+	VectorCopy(start, memo->start);
+	VectorCopy(end, memo->end);
+	memo->trace = *trace;
+}
+
+/*
+==================
+SV_WorldPointContents
+
+Contents of the world's point hull, memoized for the frame
+==================
+*/
+static int SV_WorldPointContents(const vec3_t p)
+{
+	pointmemo_t* memo;
+	unsigned	hash;
+
+	if (!sv_tracememo.value)
+		return SV_HullPointContents(&sv.worldmodel->hulls[0], 0, p);
+
+	hash = SV_HashFloats(2166136261u, p, 3);
+	memo = &sv_pointmemos[(hash ^ (hash >> 15)) & (POINT_MEMO_SIZE - 1)];
+
+	if (memo->frame != sv_traceframe || !SV_SameVector(memo->point, p))
+	{
+		memo->frame = sv_traceframe;
+		VectorCopy(p, memo->point);
+		memo->contents = SV_HullPointContents(&sv.worldmodel->hulls[0], 0, p);
+	}
+
+	return memo->contents;
+}
+
+/*
+==================
+Trace recording
+
+sv_tracebench record captures the hull traces the game really does so they
+can be replayed through each tracer.  Hull pointers belong to the current
+map, so recordings are dropped by SV_ClearWorld.
+==================
+*/
+typedef struct
+{
+	hull_t* hull;
+	vec3_t		offset, start, end;
+	int			frame;
+} recordedtrace_t;
+
+static std::vector<recordedtrace_t>	sv_recordedtraces;
+static int		sv_tracerecordleft;		// traces still to record
+
+static void SV_ClearTraceRecording(void)
+{
+	sv_recordedtraces.clear();
+	sv_tracerecordleft = 0;
+}
+
+static void SV_RecordTrace(hull_t* hull, const vec3_t offset, const vec3_t start, const vec3_t end)
+{
+	recordedtrace_t	rec;
+
+	rec.hull = hull;
+	VectorCopy(offset, rec.offset);
+	VectorCopy(start, rec.start);
+	VectorCopy(end, rec.end);
+	rec.frame = sv_traceframe;
+	sv_recordedtraces.push_back(rec);
+
+	if (!--sv_tracerecordleft)
+		Con_Printf("sv_tracebench: recorded %i traces\n", (int)sv_recordedtraces.size());
+}
+
 /*
 ===============================================================================
 
@@ -515,7 +1114,7 @@ int SV_PointContents(const vec3_t p)
 {
 	int		cont;
 
-	cont = SV_HullPointContents(&sv.worldmodel->hulls[0], 0, p);
+	cont = SV_WorldPointContents(p);
 	if (cont <= CONTENTS_CURRENT_0 && cont >= CONTENTS_CURRENT_DOWN)
 		cont = CONTENTS_WATER;
 	return cont;
@@ -523,7 +1122,7 @@ int SV_PointContents(const vec3_t p)
 
 int SV_TruePointContents(const vec3_t p)
 {
-	return SV_HullPointContents(&sv.worldmodel->hulls[0], 0, p);
+	return SV_WorldPointContents(p);
 }
 
 //===========================================================================
@@ -697,6 +1296,190 @@ bool SV_RecursiveHullCheck(hull_t* hull, int num, float p1f, float p2f, vec3_t p
 	return false;
 }
 
+/*
+==================
+SV_HullCheck
+
+Iterative version of SV_RecursiveHullCheck that gives bit identical results.
+Every node the line crosses is pushed on a small stack instead of recursing,
+so the near side can be walked as a loop and the far side entered as a tail
+call.  Stationary traces, which SV_TestEntityPosition and the point probes
+do a lot of, never cross a plane and just drop straight down to their leaf.
+==================
+*/
+#define	MAX_HULL_STACK	256
+
+typedef struct
+{
+	int		num;			// the node the line crosses
+	int		side;			// child holding p1
+	float	frac;
+	float	p1f, midf, p2f;
+	vec3_t	p1, mid, p2;
+} hullstack_t;
+
+bool SV_HullCheck(hull_t* hull, int num, float p1f, float p2f, const vec3_t start, const vec3_t end, trace_t* trace)
+{
+	hullstack_t	stack[MAX_HULL_STACK];
+	hullstack_t* frame;
+	int			depth;
+	dclipnode_t* node;
+	mplane_t* plane;
+	float		t1, t2;
+	float		frac, midf;
+	vec3_t		p1, p2, mid;
+	int			i, side;
+
+	VectorCopy(start, p1);
+	VectorCopy(end, p2);
+	depth = 0;
+
+	if (VectorCompare(p1, p2))
+		num = SV_HullPointContents(hull, num, p1);
+
+	while (1)
+	{
+		// walk the near side down to a leaf, remembering each crossing
+		while (num >= 0)
+		{
+			if (num < hull->firstclipnode || num > hull->lastclipnode)
+				Sys_Error("SV_HullCheck: bad node number");
+
+			node = hull->clipnodes + num;
+			plane = hull->planes + node->planenum;
+
+			if (plane->type < 3)
+			{
+				t1 = p1[plane->type] - plane->dist;
+				t2 = p2[plane->type] - plane->dist;
+			}
+			else
+			{
+				t1 = DotProduct(plane->normal, p1) - plane->dist;
+				t2 = DotProduct(plane->normal, p2) - plane->dist;
+			}
+
+			if (t1 >= 0 && t2 >= 0)
+			{
+				num = node->children[0];
+				continue;
+			}
+			if (t1 < 0 && t2 < 0)
+			{
+				num = node->children[1];
+				continue;
+			}
+
+			// put the crosspoint DIST_EPSILON pixels on the near side
+			if (t1 < 0)
+				frac = (t1 + DIST_EPSILON) / (t1 - t2);
+			else
+				frac = (t1 - DIST_EPSILON) / (t1 - t2);
+			if (frac < 0)
+				frac = 0;
+			if (frac > 1)
+				frac = 1;
+
+			midf = p1f + (p2f - p1f) * frac;
+			for (i = 0; i < 3; i++)
+				mid[i] = p1[i] + frac * (p2[i] - p1[i]);
+
+			side = (t1 < 0);
+
+			if (depth == MAX_HULL_STACK)
+				Sys_Error("SV_HullCheck: stack overflow");
+
+			frame = &stack[depth++];
+			frame->num = num;
+			frame->side = side;
+			frame->frac = frac;
+			frame->p1f = p1f;
+			frame->midf = midf;
+			frame->p2f = p2f;
+			VectorCopy(p1, frame->p1);
+			VectorCopy(mid, frame->mid);
+			VectorCopy(p2, frame->p2);
+
+			// move up to the node
+			num = node->children[side];
+			p2f = midf;
+			VectorCopy(mid, p2);
+		}
+
+		// check for empty
+		if (num != CONTENTS_SOLID)
+		{
+			trace->allsolid = false;
+			if (num == CONTENTS_EMPTY)
+				trace->inopen = true;
+			else
+				trace->inwater = true;
+		}
+		else
+			trace->startsolid = true;
+
+		// the near side was empty, so try the far side of the last crossing
+		if (!depth)
+			return true;
+
+		frame = &stack[--depth];
+		node = hull->clipnodes + frame->num;
+
+		if (SV_HullPointContents(hull, node->children[frame->side ^ 1], frame->mid)
+			!= CONTENTS_SOLID)
+		{
+			// go past the node
+			num = node->children[frame->side ^ 1];
+			p1f = frame->midf;
+			p2f = frame->p2f;
+			VectorCopy(frame->mid, p1);
+			VectorCopy(frame->p2, p2);
+			continue;
+		}
+
+		if (trace->allsolid)
+			return false;		// never got out of the solid area
+
+		// the other side of the node is solid, this is the impact point
+		plane = hull->planes + node->planenum;
+		if (!frame->side)
+		{
+			VectorCopy(plane->normal, trace->plane.normal);
+			trace->plane.dist = plane->dist;
+		}
+		else
+		{
+			VectorSubtract(vec3_origin, plane->normal, trace->plane.normal);
+			trace->plane.dist = -plane->dist;
+		}
+
+		frac = frame->frac;
+		midf = frame->midf;
+		VectorCopy(frame->mid, mid);
+
+		while (SV_HullPointContents(hull, hull->firstclipnode, mid)
+			== CONTENTS_SOLID)
+		{ // shouldn't really happen, but does occasionally
+			frac -= 0.1f;
+			if (frac < 0)
+			{
+				trace->fraction = midf;
+				VectorCopy(mid, trace->endpos);
+				Con_DPrintf("backup past 0\n");
+				return false;
+			}
+			midf = frame->p1f + (frame->p2f - frame->p1f) * frac;
+			for (i = 0; i < 3; i++)
+				mid[i] = frame->p1[i] + frac * (frame->p2[i] - frame->p1[i]);
+		}
+
+		trace->fraction = midf;
+		VectorCopy(mid, trace->endpos);
+
+		return false;
+	}
+}
+
 
 /*
 ==================
@@ -712,6 +1495,7 @@ trace_t SV_ClipMoveToEntity(edict_t* ent, const vec3_t start, const vec3_t mins,
 	vec3_t		offset;
 	vec3_t		start_l, end_l;
 	hull_t* hull;
+	bool		memo;
 
 	// fill in a default trace
 	memset(&trace, 0, sizeof(trace_t));
@@ -722,6 +1506,22 @@ trace_t SV_ClipMoveToEntity(edict_t* ent, const vec3_t start, const vec3_t mins,
 	// get the clipping hull
 	hull = SV_HullForEntity(ent, mins, maxs, offset);
 
+	// bsp hulls don't change during a frame, so neither do traces through them
+	memo = hull != &box_hull && sv_tracememo.value;
+#ifdef QUAKE2
+	if (ent->v.angles[0] || ent->v.angles[1] || ent->v.angles[2])
+		memo = false;
+#endif
+	if (hull != &box_hull && sv_tracerecordleft > 0)
+		SV_RecordTrace(hull, offset, start, end);
+
+	if (memo && SV_LookupTraceMemo(hull, offset, start, end, &trace))
+	{
+		if (trace.fraction < 1 || trace.startsolid)
+			trace.ent = ent;
+		return trace;
+	}
+
 	VectorSubtract(start, offset, start_l);
 	VectorSubtract(end, offset, end_l);
 
@@ -749,7 +1549,7 @@ trace_t SV_ClipMoveToEntity(edict_t* ent, const vec3_t start, const vec3_t mins,
 #endif
 
 	// trace a line through the apropriate clipping hull
-	SV_RecursiveHullCheck(hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace);
+	SV_HullCheck(hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace);
 
 #ifdef QUAKE2
 	// rotate endpos back to world frame of reference
@@ -782,6 +1582,9 @@ trace_t SV_ClipMoveToEntity(edict_t* ent, const vec3_t start, const vec3_t mins,
 	if (trace.fraction != 1)
 		VectorAdd(trace.endpos, offset, trace.endpos);
 
+	if (memo)
+		SV_StoreTraceMemo(hull, offset, start, end, &trace);
+
 	// did we clip the move?
 	if (trace.fraction < 1 || trace.startsolid)
 		trace.ent = ent;
@@ -798,17 +1601,19 @@ SV_ClipToLinks
 Mins and maxs enclose the entire area swept by the move
 ====================
 */
-void SV_ClipToLinks(areanode_t* node, moveclip_t* clip)
+void SV_ClipToLinks(moveclip_t* clip)
 {
-	link_t* l, * next;
+	int			i, num;
 	edict_t* touch;
+	static thread_local edict_t* touchlist[MAX_EDICTS];	// too big for the stack, clipping never recurses
 	trace_t		trace;
 
+	num = SV_AreaEdicts(clip->boxmins, clip->boxmaxs, touchlist, MAX_EDICTS, AREA_SOLID);
+
 	// touch linked edicts
-	for (l = node->solid_edicts.next; l != &node->solid_edicts; l = next)
+	for (i = 0; i < num; i++)
 	{
-		next = l->next;
-		touch = EDICT_FROM_AREA(l);
+		touch = touchlist[i];
 		if (touch->v.solid == SOLID_NOT)
 			continue;
 		if (touch == clip->passedict)
@@ -819,14 +1624,6 @@ void SV_ClipToLinks(areanode_t* node, moveclip_t* clip)
 		if (clip->type == MOVE_NOMONSTERS && touch->v.solid != SOLID_BSP)
 			continue;
 
-		if (clip->boxmins[0] > touch->v.absmax[0]
-			|| clip->boxmins[1] > touch->v.absmax[1]
-			|| clip->boxmins[2] > touch->v.absmax[2]
-			|| clip->boxmaxs[0] < touch->v.absmin[0]
-			|| clip->boxmaxs[1] < touch->v.absmin[1]
-			|| clip->boxmaxs[2] < touch->v.absmin[2])
-			continue;
-
 		if (clip->passedict && clip->passedict->v.size[0] && !touch->v.size[0])
 			continue;	// points never interact
 
@@ -860,15 +1657,6 @@ void SV_ClipToLinks(areanode_t* node, moveclip_t* clip)
 		else if (trace.startsolid)
 			clip->trace.startsolid = true;
 	}
-
-	// recurse down both sides
-	if (node->axis == -1)
-		return;
-
-	if (clip->boxmaxs[node->axis] > node->dist)
-		SV_ClipToLinks(node->children[0], clip);
-	if (clip->boxmins[node->axis] < node->dist)
-		SV_ClipToLinks(node->children[1], clip);
 }
 
 
@@ -942,8 +1730,298 @@ trace_t SV_Move(const vec3_t start, const vec3_t mins, const vec3_t maxs, const
 	SV_MoveBounds(start, clip.mins2, clip.maxs2, end, clip.boxmins, clip.boxmaxs);
 
 	// clip to entities
-	SV_ClipToLinks(sv_areanodes, &clip);
+	SV_ClipToLinks(&clip);
 
 	return clip.trace;
 }
 
+//===========================================================================
+
+/*
+==================
+SV_BroadphaseBench_f
+
+Replays a set of traces against the entities currently linked in the world
+with each broadphase and reports traces/sec, checking that both give the same
+results.
+==================
+*/
+void SV_BroadphaseBench_f(void)
+{
+	static const vec3_t hullmins[] = {{0, 0, 0}, {-16, -16, -24}, {-32, -32, -24}};
+	static const vec3_t hullmaxs[] = {{0, 0, 0}, {16, 16, 32}, {32, 32, 64}};
+	static const char* names[] = {"areanodes", "areagrid"};
+
+	struct benchtrace_t
+	{
+		vec3_t	start, end;
+		int		hull;
+	};
+
+	std::vector<edict_t*>		linked;
+	std::vector<benchtrace_t>	traces;
+	std::vector<trace_t>		results[2];
+	unsigned int	seed;
+	int			i, j, numtraces, mode, oldmode, mismatches;
+	double		time[2];
+	edict_t* ent;
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_broadphasebench: no map running\n");
+		return;
+	}
+
+	numtraces = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 100000;
+	if (numtraces < 1)
+		numtraces = 1;
+
+	// record the current entity set in link order
+	for (i = 1; i < sv.num_edicts; i++)
+	{
+		ent = EDICT_NUM(i);
+		if (ent->area.prev)
+			linked.push_back(ent);
+	}
+
+	std::sort(linked.begin(), linked.end(), [](const edict_t* lhs, const edict_t* rhs)
+		{
+			return lhs->arealink.sequence < rhs->arealink.sequence;
+		});
+
+	// deterministic traces, around entities when there are any so the
+	// broadphase actually has something to return
+	seed = 0x1234567;
+	auto random = [&seed]()
+	{
+		seed = seed * 1103515245 + 12345;
+		return ((seed >> 8) & 0xffff) / 65535.0f;
+	};
+
+	traces.resize(numtraces);
+	for (i = 0; i < numtraces; i++)
+	{
+		benchtrace_t& t = traces[i];
+
+		if (!linked.empty() && (i & 1))
+		{
+			ent = linked[(int)(random() * (linked.size() - 1))];
+			for (j = 0; j < 3; j++)
+				t.start[j] = ent->v.absmin[j] + random() * (ent->v.absmax[j] - ent->v.absmin[j]);
+		}
+		else
+		{
+			for (j = 0; j < 3; j++)
+				t.start[j] = sv.worldmodel->mins[j] + random() * (sv.worldmodel->maxs[j] - sv.worldmodel->mins[j]);
+		}
+
+		for (j = 0; j < 3; j++)
+			t.end[j] = t.start[j] + (random() - 0.5f) * 1024;
+
+		t.hull = (int)(random() * 2.99f);
+	}
+
+	oldmode = sv_broadphasetype;
+
+	for (mode = BROADPHASE_AREANODES; mode <= BROADPHASE_AREAGRID; mode++)
+	{
+		for (auto e : linked)
+			SV_UnlinkEdict(e);
+		SV_SetBroadphase(mode);
+		for (auto e : linked)
+			SV_LinkEdict(e, false);
+
+		results[mode].resize(numtraces);
+
+		time[mode] = Sys_FloatTime();
+		for (i = 0; i < numtraces; i++)
+		{
+			const benchtrace_t& t = traces[i];
+			results[mode][i] = SV_Move(t.start, hullmins[t.hull], hullmaxs[t.hull], t.end, MOVE_NORMAL, NULL);
+		}
+		time[mode] = Sys_FloatTime() - time[mode];
+	}
+
+	// put things back the way they were
+	for (auto e : linked)
+		SV_UnlinkEdict(e);
+	SV_SetBroadphase(oldmode);
+	for (auto e : linked)
+		SV_LinkEdict(e, false);
+
+	mismatches = 0;
+	for (i = 0; i < numtraces; i++)
+	{
+		trace_t& a = results[0][i];
+		trace_t& b = results[1][i];
+
+		if (a.allsolid != b.allsolid || a.startsolid != b.startsolid
+			|| a.inopen != b.inopen || a.inwater != b.inwater
+			|| a.fraction != b.fraction || a.ent != b.ent
+			|| !VectorCompare(a.endpos, b.endpos)
+			|| !VectorCompare(a.plane.normal, b.plane.normal) || a.plane.dist != b.plane.dist)
+			mismatches++;
+	}
+
+	Con_Printf("%i traces against %i entities\n", numtraces, (int)linked.size());
+	for (mode = BROADPHASE_AREANODES; mode <= BROADPHASE_AREAGRID; mode++)
+	{
+		Con_Printf("%-10s %8.3f ms %10.0f traces/sec\n", names[mode], time[mode] * 1000,
+			time[mode] > 0 ? numtraces / time[mode] : 0.0);
+	}
+	if (mismatches)
+		Con_Printf("%i traces differ between broadphases\n", mismatches);
+	else
+		Con_Printf("traces identical\n");
+}
+
+/*
+==================
+SV_ReplayTrace
+
+Repeats a recorded hull trace the way SV_ClipMoveToEntity does it
+==================
+*/
+static void SV_ReplayTrace(const recordedtrace_t* rec, bool iterative, trace_t* trace)
+{
+	vec3_t		start_l, end_l;
+
+	memset(trace, 0, sizeof(*trace));
+	trace->fraction = 1;
+	trace->allsolid = true;
+	VectorCopy(rec->end, trace->endpos);
+
+	VectorSubtract(rec->start, rec->offset, start_l);
+	VectorSubtract(rec->end, rec->offset, end_l);
+
+	if (iterative)
+		SV_HullCheck(rec->hull, rec->hull->firstclipnode, 0, 1, start_l, end_l, trace);
+	else
+		SV_RecursiveHullCheck(rec->hull, rec->hull->firstclipnode, 0, 1, start_l, end_l, trace);
+
+	if (trace->fraction != 1)
+		VectorAdd(trace->endpos, rec->offset, trace->endpos);
+}
+
+static bool SV_SameTrace(const trace_t* a, const trace_t* b)
+{
+	return a->allsolid == b->allsolid && a->startsolid == b->startsolid
+		&& a->inopen == b->inopen && a->inwater == b->inwater
+		&& !memcmp(&a->fraction, &b->fraction, sizeof(float))
+		&& SV_SameVector(a->endpos, b->endpos)
+		&& SV_SameVector(a->plane.normal, b->plane.normal)
+		&& !memcmp(&a->plane.dist, &b->plane.dist, sizeof(float));
+}
+
+/*
+==================
+SV_TraceBench_f
+
+sv_tracebench record [count] captures the next count hull traces made on
+the current map, sv_tracebench [passes] then replays them through the
+recursive tracer, the iterative tracer and the iterative tracer behind the
+per-frame memo, checking every result against the recursive one.
+==================
+*/
+void SV_TraceBench_f(void)
+{
+	static const char* names[] = {"recursive", "iterative", "memoized"};
+
+	std::vector<trace_t>	reference;
+	trace_t		trace;
+	double		time[3];
+	int			i, pass, passes, mode, frame, hits, mismatches[3];
+	size_t		numtraces;
+
+	if (!sv.active)
+	{
+		Con_Printf("sv_tracebench: no map running\n");
+		return;
+	}
+
+	if (Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "record"))
+	{
+		SV_ClearTraceRecording();
+		sv_tracerecordleft = Cmd_Argc() > 2 ? Q_atoi(Cmd_Argv(2)) : 100000;
+		if (sv_tracerecordleft < 1)
+			sv_tracerecordleft = 1;
+		sv_recordedtraces.reserve(sv_tracerecordleft);
+		Con_Printf("sv_tracebench: recording the next %i traces\n", sv_tracerecordleft);
+		return;
+	}
+
+	numtraces = sv_recordedtraces.size();
+	if (!numtraces)
+	{
+		Con_Printf("sv_tracebench: nothing recorded, use \"sv_tracebench record [count]\" first\n");
+		return;
+	}
+	if (sv_tracerecordleft > 0)
+		Con_Printf("sv_tracebench: still recording, replaying the %i traces so far\n", (int)numtraces);
+
+	passes = Cmd_Argc() > 1 ? Q_atoi(Cmd_Argv(1)) : 10;
+	if (passes < 1)
+		passes = 1;
+
+	reference.resize(numtraces);
+	for (i = 0; i < (int)numtraces; i++)
+		SV_ReplayTrace(&sv_recordedtraces[i], false, &reference[i]);
+
+	hits = 0;
+	for (mode = 0; mode < 3; mode++)
+	{
+		mismatches[mode] = 0;
+		time[mode] = Sys_FloatTime();
+
+		for (pass = 0; pass < passes; pass++)
+		{
+			frame = 0;
+			for (i = 0; i < (int)numtraces; i++)
+			{
+				const recordedtrace_t* rec = &sv_recordedtraces[i];
+
+				if (mode == 2)
+				{
+					// start a new memo frame wherever the game did
+					if (rec->frame != frame)
+					{
+						frame = rec->frame;
+						SV_NewTraceFrame();
+					}
+
+					if (SV_LookupTraceMemo(rec->hull, rec->offset, rec->start, rec->end, &trace))
+					{
+						if (!pass)
+							hits++;
+					}
+					else
+					{
+						SV_ReplayTrace(rec, true, &trace);
+						SV_StoreTraceMemo(rec->hull, rec->offset, rec->start, rec->end, &trace);
+					}
+				}
+				else
+					SV_ReplayTrace(rec, mode == 1, &trace);
+
+				if (!pass && !SV_SameTrace(&trace, &reference[i]))
+					mismatches[mode]++;
+			}
+		}
+
+		time[mode] = Sys_FloatTime() - time[mode];
+	}
+
+	// don't leave replayed entries behind for the game
+	SV_NewTraceFrame();
+
+	Con_Printf("%i recorded traces x %i passes, %i memo hits per pass\n", (int)numtraces, passes, hits);
+	for (mode = 0; mode < 3; mode++)
+	{
+		Con_Printf("%-10s %8.3f ms %10.0f traces/sec %5.2fx", names[mode], time[mode] * 1000,
+			time[mode] > 0 ? numtraces * passes / time[mode] : 0.0,
+			time[mode] > 0 ? time[0] / time[mode] : 0.0);
+		if (mismatches[mode])
+			Con_Printf(" %i differ", mismatches[mode]);
+		Con_Printf("\n");
+	}
+}
@@ -41,6 +41,13 @@ typedef struct
 #define	MOVE_NOMONSTERS	1
 #define	MOVE_MISSILE	2
 
+#define	AREA_SOLID		1
+#define	AREA_TRIGGERS	2
+
+// sv_broadphase values
+#define	BROADPHASE_AREANODES	0	// fixed depth binary split of the world
+#define	BROADPHASE_AREAGRID		1	// uniform grid sized from the world bounds
+
 
 void SV_ClearWorld(void);
 // called after the world model has been loaded, before linking any entities
@@ -56,6 +63,19 @@ void SV_LinkEdict(edict_t* ent, bool touch_triggers);
 // sets ent->v.absmin and ent->v.absmax
 // if touchtriggers, calls prog functions for the intersected triggers
 
+int SV_AreaEdicts(const vec3_t mins, const vec3_t maxs, edict_t** list, int maxcount, int areatype);
+// fills in a list of all entities who's absmin / absmax intersects the given
+// bounds.  This does NOT mean that they actually touch in the case of bmodels.
+// the list is in the same order for every broadphase, so traces and touches
+// resolve ties identically
+
+void SV_BroadphaseBench_f(void);
+void SV_TraceBench_f(void);
+
+void SV_NewTraceFrame(void);
+// forgets the traces and point contents memoized so far, called at the
+// start of every physics frame
+
 int SV_PointContents(const vec3_t p);
 int SV_TruePointContents(const vec3_t p);
 // returns the CONTENTS_* value from the world at the given point.
@@ -65,6 +85,8 @@ int SV_TruePointContents(const vec3_t p);
 edict_t* SV_TestEntityPosition(edict_t* ent);
 
 bool SV_RecursiveHullCheck(hull_t* hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t* trace);
+bool SV_HullCheck(hull_t* hull, int num, float p1f, float p2f, const vec3_t start, const vec3_t end, trace_t* trace);
+// iterative version of SV_RecursiveHullCheck with identical results
 
 trace_t SV_Move(const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int type, edict_t* passedict);
 // mins and maxs are reletive
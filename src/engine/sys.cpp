@@ -33,8 +33,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "IDedicatedLauncher.h"
 #include "interface.h"
 
-#ifndef WIN32
+#ifdef WIN32
+#include <Windows.h>
+#include <io.h>
+#else
 #include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #endif
 
 #include <SDL.h>
@@ -107,6 +112,47 @@ FILE* Sys_FileOpenWrite(const char* path)
 	return f;
 }
 
+const byte* Sys_FileMap(FILE* f, long length)
+{
+	if (length <= 0)
+		return nullptr;
+
+#ifdef WIN32
+	const HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(f)));
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+		return nullptr;
+
+	void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length);
+
+	// the view keeps the mapping alive until it is unmapped
+	CloseHandle(mapping);
+
+	return reinterpret_cast<const byte*>(base);
+#else
+	void* base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (base == MAP_FAILED)
+		return nullptr;
+
+	return reinterpret_cast<const byte*>(base);
+#endif
+}
+
+void Sys_FileUnmap(const byte* base, long length)
+{
+	if (!base)
+		return;
+
+#ifdef WIN32
+	UnmapViewOfFile(base);
+#else
+	munmap(const_cast<byte*>(base), length);
+#endif
+}
+
 time_t Sys_FileTime(const char* path)
 {
 	struct stat buf;
@@ -119,6 +165,42 @@ time_t Sys_FileTime(const char* path)
 	return buf.st_mtime;
 }
 
+/*
+================
+Sys_MemReserve
+
+Address space only, nothing is backed by memory until Sys_MemCommit
+================
+*/
+byte* Sys_MemReserve(int size)
+{
+#ifdef WIN32
+	return reinterpret_cast<byte*>(VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+#else
+	void* base = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED)
+		return nullptr;
+
+	return reinterpret_cast<byte*>(base);
+#endif
+}
+
+/*
+================
+Sys_MemCommit
+
+Backs part of a reserved range with zero filled memory
+================
+*/
+bool Sys_MemCommit(byte* base, int size)
+{
+#ifdef WIN32
+	return VirtualAlloc(base, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(base, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
 void Sys_mkdir(const char* path)
 {
 #ifdef WIN32
@@ -464,8 +546,8 @@ int EngineMain(int argc, const char* const* argv, InterfaceAccessor launcherInte
 		}
 	}
 
-	// take 16 Mb, unless they explicitly
-	// request otherwise
+	// start the level arena at 16 Mb, it grows from
+	// there as maps need more
 	parms.memsize = MAXIMUM_WIN_MEMORY;
 
 	if (int t = COM_CheckParm("-heapsize"); t != 0)
@@ -476,11 +558,6 @@ int EngineMain(int argc, const char* const* argv, InterfaceAccessor launcherInte
 			parms.memsize = Q_atoi(com_argv[t]) * 1024;
 	}
 
-	parms.membase = malloc(parms.memsize);
-
-	if (!parms.membase)
-		Sys_Error("Not enough memory free; check disk space\n");
-
 	Sys_Init();
 
 	Sys_Printf("Host_Init\n");
@@ -495,15 +572,9 @@ int EngineMain(int argc, const char* const* argv, InterfaceAccessor launcherInte
 	{
 		if (isDedicated)
 		{
+			// sleep until the next tick is due
+			time = Tick_Wait();
 			newtime = Sys_FloatTime();
-			time = newtime - oldtime;
-
-			while (time < sys_ticrate.value)
-			{
-				Sys_Sleep();
-				newtime = Sys_FloatTime();
-				time = newtime - oldtime;
-			}
 		}
 		else
 		{
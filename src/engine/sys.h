@@ -29,9 +29,21 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 long Sys_FileOpenRead(const char* path, FILE** hndl);
 
 FILE* Sys_FileOpenWrite(const char* path);
+
+// maps the whole of an open file read only, the view stays valid after the
+// file is closed.  returns nullptr where mapping isn't supported
+const byte* Sys_FileMap(FILE* f, long length);
+void Sys_FileUnmap(const byte* base, long length);
+
 time_t Sys_FileTime(const char* path);
 void Sys_mkdir(const char* path);
 
+//
+// memory
+//
+byte* Sys_MemReserve(int size);
+bool Sys_MemCommit(byte* base, int size);
+
 //
 // system IO
 //
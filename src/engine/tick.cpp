@@ -0,0 +1,288 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* tick.c -- fixed rate frame scheduling for dedicated servers */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <cerrno>
+#include <time.h>
+#endif
+
+#include "quakedef.h"
+
+typedef std::chrono::steady_clock	tickclock;
+
+cvar_t	sv_tickrate = {"sv_tickrate", "0"};		// ticks per second, 0 uses 1 / sys_ticrate
+cvar_t	sv_tickwake = {"sv_tickwake", "0"};		// start a tick early when client messages arrive
+
+typedef struct
+{
+	int		ticks;
+	int		overruns;		// fell a whole tick behind and skipped ahead
+	int		earlywakes;
+
+	// seconds between the starts of consecutive ticks
+	double	intervalsum, intervalsq;
+	double	intervalmin, intervalmax;
+
+	// seconds the wake up came after the deadline
+	double	latesum, latemax;
+} tickstats_t;
+
+static tickstats_t			tick_stats;
+static tickclock::time_point	tick_last;		// when the previous tick started
+static tickclock::time_point	tick_deadline;	// when the next one is due
+static bool					tick_started;
+
+// set by Tick_Wake when the network has data, with sv_tickwake
+static std::mutex				tick_wakelock;
+static std::condition_variable	tick_wakecond;
+static bool					tick_woken;
+
+/*
+================
+Tick_Interval
+================
+*/
+static double Tick_Interval(void)
+{
+	if (sv_tickrate.value > 0)
+		return 1.0 / sv_tickrate.value;
+
+	return std::max(sys_ticrate.value, 0.001f);
+}
+
+static tickclock::duration Tick_Seconds(double seconds)
+{
+	return std::chrono::duration_cast<tickclock::duration>(std::chrono::duration<double>(seconds));
+}
+
+static double Tick_ToSeconds(tickclock::duration duration)
+{
+	return std::chrono::duration<double>(duration).count();
+}
+
+/*
+================
+Tick_SleepUntil
+
+Sleeps to an absolute time, so waking late never pushes the next deadline back
+================
+*/
+static void Tick_SleepUntil(tickclock::time_point deadline)
+{
+#ifdef __linux__
+	// steady_clock is CLOCK_MONOTONIC
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+	struct timespec	ts;
+
+	ts.tv_sec = ns / 1000000000;
+	ts.tv_nsec = ns % 1000000000;
+
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+		;
+#else
+	std::this_thread::sleep_until(deadline);
+#endif
+}
+
+/*
+================
+Tick_WaitForWake
+
+Sleeps until the deadline or until Tick_Wake is called, whichever is first
+================
+*/
+static void Tick_WaitForWake(tickclock::time_point deadline)
+{
+	std::unique_lock<std::mutex>	lock(tick_wakelock);
+
+	tick_wakecond.wait_until(lock, deadline, []() { return tick_woken; });
+}
+
+/*
+================
+Tick_Wake
+================
+*/
+void Tick_Wake(void)
+{
+	{
+		std::lock_guard<std::mutex>	lock(tick_wakelock);
+		tick_woken = true;
+	}
+
+	tick_wakecond.notify_one();
+}
+
+/*
+================
+Tick_ResetStats
+================
+*/
+static void Tick_ResetStats(void)
+{
+	memset(&tick_stats, 0, sizeof(tick_stats));
+	tick_stats.intervalmin = 1e9;
+}
+
+/*
+================
+Tick_Wait
+================
+*/
+double Tick_Wait(void)
+{
+	tickclock::time_point	now, earliest;
+	double		interval, elapsed, late;
+	bool		early;
+
+	now = tickclock::now();
+	interval = Tick_Interval();
+
+	if (!tick_started)
+	{
+		// the first tick runs right away
+		tick_started = true;
+		tick_last = now;
+		tick_deadline = now + Tick_Seconds(interval);
+		return interval;
+	}
+
+	// an early tick never comes sooner than half an interval after the last
+	earliest = tick_last + Tick_Seconds(interval * 0.5);
+	early = false;
+
+	while (now < tick_deadline)
+	{
+		if (!sv_tickwake.value)
+			Tick_SleepUntil(tick_deadline);
+		else if (now < earliest)
+			Tick_SleepUntil(earliest);
+		else
+		{
+			// clear the wake before looking, so data arriving after the check still wakes us
+			{
+				std::lock_guard<std::mutex>	lock(tick_wakelock);
+				tick_woken = false;
+			}
+
+			if (g_Networking->MessagesWaiting())
+			{
+				early = true;
+				break;
+			}
+
+			// the network layer calls Tick_Wake when a packet comes in, not
+			// every packet holds a message so look again after waking
+			Tick_WaitForWake(tick_deadline);
+		}
+
+		now = tickclock::now();
+	}
+
+	elapsed = Tick_ToSeconds(now - tick_last);
+	tick_last = now;
+
+	tick_stats.ticks++;
+	tick_stats.intervalsum += elapsed;
+	tick_stats.intervalsq += elapsed * elapsed;
+	tick_stats.intervalmin = std::min(tick_stats.intervalmin, elapsed);
+	tick_stats.intervalmax = std::max(tick_stats.intervalmax, elapsed);
+
+	if (early)
+	{
+		// leave the deadline alone, the schedule stays where it was
+		tick_stats.earlywakes++;
+		return elapsed;
+	}
+
+	late = Tick_ToSeconds(now - tick_deadline);
+	tick_stats.latesum += late;
+	tick_stats.latemax = std::max(tick_stats.latemax, late);
+
+	// the next tick is due one interval after this one was, unless the last
+	// frame took so long that we are a whole tick behind
+	tick_deadline += Tick_Seconds(interval);
+	if (tick_deadline <= now)
+	{
+		tick_stats.overruns++;
+		tick_deadline = now + Tick_Seconds(interval);
+	}
+
+	return elapsed;
+}
+
+/*
+================
+Tick_Stats_f
+
+Prints how regularly ticks have been running, "tickstats reset" starts over
+================
+*/
+static void Tick_Stats_f(void)
+{
+	double		mean, deviation, latemean;
+	int			ontime;
+
+	if (Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "reset"))
+	{
+		Tick_ResetStats();
+		return;
+	}
+
+	if (!tick_stats.ticks)
+	{
+		Con_Printf("no ticks scheduled%s\n", isDedicated ? "" : ", only dedicated servers use the tick scheduler");
+		return;
+	}
+
+	mean = tick_stats.intervalsum / tick_stats.ticks;
+	deviation = sqrt(std::max(tick_stats.intervalsq / tick_stats.ticks - mean * mean, 0.0));
+	ontime = tick_stats.ticks - tick_stats.earlywakes;
+	latemean = ontime ? tick_stats.latesum / ontime : 0;
+
+	Con_Printf("%i ticks, target %.2f ms (%.1f Hz)\n", tick_stats.ticks, Tick_Interval() * 1000, 1 / Tick_Interval());
+	Con_Printf("interval  avg %.3f ms  min %.3f  max %.3f  stddev %.3f\n",
+		mean * 1000, tick_stats.intervalmin * 1000, tick_stats.intervalmax * 1000, deviation * 1000);
+	Con_Printf("wake late avg %.3f ms  max %.3f\n", latemean * 1000, tick_stats.latemax * 1000);
+	Con_Printf("%i overruns, %i early wakes\n", tick_stats.overruns, tick_stats.earlywakes);
+}
+
+/*
+================
+Tick_Init
+================
+*/
+void Tick_Init(void)
+{
+	Cvar_RegisterVariable(&sv_tickrate);
+	Cvar_RegisterVariable(&sv_tickwake);
+
+	Cmd_AddCommand("tickstats", Tick_Stats_f);
+
+	Tick_ResetStats();
+}
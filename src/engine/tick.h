@@ -0,0 +1,34 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* tick.h -- fixed rate frame scheduling for dedicated servers */
+
+#pragma once
+
+void Tick_Init(void);
+
+// Sleeps until the next server tick is due and returns the seconds since the
+// previous one.  Ticks are scheduled on absolute deadlines so sleep overshoot
+// doesn't accumulate, and with sv_tickwake set a tick may start early when
+// client messages arrive.
+double Tick_Wait(void);
+
+// Wakes a Tick_Wait that is waiting for client messages.  Called by the
+// network layer when data arrives, from any thread.
+void Tick_Wake(void);
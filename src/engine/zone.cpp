@@ -19,6 +19,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // Z_zone.c
 
+#include <algorithm>
+#include <atomic>
+
 #include "quakedef.h"
 
 #define	DYNAMIC_SIZE	0xc000
@@ -42,8 +45,137 @@ typedef struct
 	memblock_t* rover;
 } memzone_t;
 
-void Cache_FreeLow(int new_low_hunk);
-void Cache_FreeHigh(int new_high_hunk);
+/*
+==============================================================================
+
+						ARENAS
+
+The zone, the low hunk, the high hunk and the cache each get their own range
+of address space, reserved at startup and backed with memory as it fills.
+Nothing ever moves, and a bigger map grows its arena instead of running out
+of one fixed block.
+
+A 64 bit build reserves big fixed ranges, address space costs it next to
+nothing and no memory is committed until an arena is used.  A 32 bit process
+shares its address space with the video driver, sound, thread stacks and
+mapped paks, so it only reserves a few times -heapsize and -zone.  Either
+way -heapsize is just what the low hunk starts with.
+==============================================================================
+*/
+
+#define	ARENA_GROWTH	(1024 * 1024)		// memory is committed in steps of this
+
+// 64 bit reservations
+#define	ZONE_RESERVE	(256 * 1024 * 1024)
+#define	LOW_RESERVE		(1024 * 1024 * 1024)	// level data
+#define	HIGH_RESERVE	(512 * 1024 * 1024)		// video buffers and temp data
+#define	CACHE_RESERVE	(128 * 1024 * 1024)		// cached resources, the least recently used are thrown out past this
+
+// 32 bit reservations, in multiples of what was asked for
+#define	ZONE_RESERVE_SCALE	4		// of -zone
+#define	LOW_RESERVE_SCALE	8		// of -heapsize
+#define	HIGH_RESERVE_SCALE	2
+#define	CACHE_RESERVE_SCALE	1
+
+#define	MAX_RESERVE		(1024 * 1024 * 1024)
+
+typedef struct
+{
+	const char* name;
+	byte*	base;
+	int		reserved;		// the arena can never grow past this
+	int		committed;		// backed by memory, from base
+	int		used;
+	int		peak;
+} arena_t;
+
+static arena_t	arena_zone, arena_low, arena_high, arena_cache;
+
+/*
+========================
+Arena_Commit
+
+Makes sure the first size bytes of the arena are backed by memory
+========================
+*/
+static bool Arena_Commit(arena_t* arena, int size)
+{
+	int		grow;
+
+	if (size <= arena->committed)
+		return true;
+	if (size > arena->reserved)
+		return false;
+
+	grow = std::max(size - arena->committed, ARENA_GROWTH);
+	grow = (grow + ARENA_GROWTH - 1) & ~(ARENA_GROWTH - 1);
+	grow = std::min(grow, arena->reserved - arena->committed);
+
+	if (!Sys_MemCommit(arena->base + arena->committed, grow))
+		return false;
+
+	arena->committed += grow;
+	return true;
+}
+
+/*
+========================
+Arena_Init
+========================
+*/
+static void Arena_Init(arena_t* arena, const char* name, int reserve, int initial)
+{
+	initial = (initial + ARENA_GROWTH - 1) & ~(ARENA_GROWTH - 1);
+
+	// a 32 bit process may not find the whole range, settle for less
+	arena->base = NULL;
+	for (reserve = std::max(reserve, initial); reserve >= std::max(initial, ARENA_GROWTH); reserve /= 2)
+	{
+		arena->base = Sys_MemReserve(reserve);
+		if (arena->base)
+			break;
+	}
+
+	if (!arena->base)
+		Sys_Error("Memory_Init: couldn't reserve %i bytes for %s", initial, name);
+
+	arena->name = name;
+	arena->reserved = reserve;
+	arena->committed = 0;
+	arena->used = 0;
+	arena->peak = 0;
+
+	if (!Arena_Commit(arena, initial))
+		Sys_Error("Memory_Init: couldn't commit %i bytes for %s", initial, name);
+}
+
+/*
+========================
+Arena_ReserveSize
+========================
+*/
+static int Arena_ReserveSize(int size, int scale, int reserve64)
+{
+	long long	reserve;
+
+	if (sizeof(void*) == 8)
+		reserve = std::max((long long)size, (long long)reserve64);
+	else
+		reserve = (long long)size * scale;
+	reserve = std::max(reserve, (long long)ARENA_GROWTH);
+	return (int)std::min(reserve, (long long)MAX_RESERVE);
+}
+
+/*
+========================
+Arena_Use
+========================
+*/
+static void Arena_Use(arena_t* arena, int used)
+{
+	arena->used = used;
+	arena->peak = std::max(arena->peak, used);
+}
 
 
 /*
@@ -83,6 +215,7 @@ void Z_ClearZone(memzone_t* zone, int size)
 	zone->blocklist.id = 0;
 	zone->blocklist.size = 0;
 	zone->rover = block;
+	zone->size = size;
 
 	block->prev = block->next = &zone->blocklist;
 	block->tag = 0;			// free block
@@ -152,14 +285,67 @@ void* Z_Malloc(int size)
 	return buf;
 }
 
+/*
+========================
+Z_Grow
+
+Adds at least size bytes of free space to the end of the zone
+========================
+*/
+static bool Z_Grow(int size)
+{
+	memblock_t* block, * last;
+
+	if (!Arena_Commit(&arena_zone, mainzone->size + size))
+		return false;
+
+	block = (memblock_t*)((byte*)mainzone + mainzone->size);
+	block->size = arena_zone.committed - mainzone->size;
+	block->tag = 0;			// free block
+	block->id = ZONEID;
+
+	last = mainzone->blocklist.prev;
+	block->prev = last;
+	block->next = &mainzone->blocklist;
+	last->next = block;
+	mainzone->blocklist.prev = block;
+
+	mainzone->size = arena_zone.committed;
+	Arena_Use(&arena_zone, mainzone->size);
+
+	if (!last->tag)
+	{	// merge onto the free block that ended the zone
+		last->size += block->size;
+		last->next = block->next;
+		last->next->prev = last;
+		block = last;
+	}
+
+	mainzone->rover = block;
+	return true;
+}
+
+static void* Z_TryTagMalloc(int size, int tag);
+
 void* Z_TagMalloc(int size, int tag)
 {
-	int		extra;
-	memblock_t* start, * rover, * pNew, * base;
+	void* buf;
 
 	if (!tag)
 		Sys_Error("Z_TagMalloc: tried to use a 0 tag");
 
+	buf = Z_TryTagMalloc(size, tag);
+	if (!buf && Z_Grow(size + sizeof(memblock_t) + 4 + 8))
+		buf = Z_TryTagMalloc(size, tag);
+
+	return buf;
+}
+
+static void* Z_TryTagMalloc(int size, int tag)
+{
+	int		extra;
+	memblock_t* start, * rover, * pNew, * base;
+
 	//
 	// scan through the block list looking for the first free block
 	// of sufficient size
@@ -272,16 +458,61 @@ typedef struct
 	char	name[8];
 } hunk_t;
 
-byte* hunk_base;
-int		hunk_size;
-
-int		hunk_low_used;
-int		hunk_high_used;
-
 bool	hunk_tempactive;
 int		hunk_tempmark;
 
-void R_FreeTextures(void);
+static void* (*hunk_external)(int size);	// when set, low allocations go here instead
+
+// bytes held under each allocation name, low and high hunk together
+#define	MAX_HUNK_STATS	128
+
+typedef struct
+{
+	char	name[8];
+	int		current;
+	int		peak;
+} hunkstat_t;
+
+static hunkstat_t	hunk_stats[MAX_HUNK_STATS];
+static int			hunk_numstats;
+
+/*
+==============
+Hunk_Stat
+
+The entry for an allocation name, the last one collects everything once the
+table is full
+==============
+*/
+static hunkstat_t* Hunk_Stat(const char* name)
+{
+	int		i;
+
+	for (i = 0; i < hunk_numstats; i++)
+		if (!strncmp(hunk_stats[i].name, name, 8))
+			return &hunk_stats[i];
+
+	if (hunk_numstats == MAX_HUNK_STATS)
+		return &hunk_stats[MAX_HUNK_STATS - 1];
+
+	strncpy(hunk_stats[hunk_numstats].name, name, 8);
+	return &hunk_stats[hunk_numstats++];
+}
+
+/*
+==============
+Hunk_FreeStats
+
+Takes the blocks between two offsets of an arena out of the statistics
+==============
+*/
+static void Hunk_FreeStats(arena_t* arena, int from, int to)
+{
+	hunk_t* h;
+
+	for (h = (hunk_t*)(arena->base + from); (byte*)h < arena->base + to; h = (hunk_t*)((byte*)h + h->size))
+		Hunk_Stat(h->name)->current -= h->size;
+}
 
 /*
 ==============
@@ -294,11 +525,11 @@ void Hunk_Check(void)
 {
 	hunk_t* h;
 
-	for (h = (hunk_t*)hunk_base; (byte*)h != hunk_base + hunk_low_used; )
+	for (h = (hunk_t*)arena_low.base; (byte*)h != arena_low.base + arena_low.used; )
 	{
 		if (h->sentinal != HUNK_SENTINAL)
 			Sys_Error("Hunk_Check: trahsed sentinal");
-		if (h->size < 16 || h->size + (byte*)h - hunk_base > hunk_size)
+		if (h->size < 16 || h->size + (byte*)h - arena_low.base > arena_low.used)
 			Sys_Error("Hunk_Check: bad size");
 		h = (hunk_t*)((byte*)h + h->size);
 	}
@@ -306,61 +537,37 @@ void Hunk_Check(void)
 
 /*
 ==============
-Hunk_Print
+Hunk_PrintArena
 
 If "all" is specified, every single allocation is printed.
 Otherwise, allocations with the same name will be totaled up before printing.
 ==============
 */
-void Hunk_Print(bool all)
+static int Hunk_PrintArena(arena_t* arena, bool all)
 {
-	hunk_t* h, * next, * endlow, * starthigh, * endhigh;
-	int		count, sum;
+	hunk_t* h, * next, * end;
+	int		sum;
 	int		totalblocks;
 	char	name[9];
 
 	name[8] = 0;
-	count = 0;
 	sum = 0;
 	totalblocks = 0;
 
-	h = (hunk_t*)hunk_base;
-	endlow = (hunk_t*)(hunk_base + hunk_low_used);
-	starthigh = (hunk_t*)(hunk_base + hunk_size - hunk_high_used);
-	endhigh = (hunk_t*)(hunk_base + hunk_size);
-
-	Con_Printf("          :%8i total hunk size\n", hunk_size);
-	Con_Printf("-------------------------\n");
+	h = (hunk_t*)arena->base;
+	end = (hunk_t*)(arena->base + arena->used);
 
-	while (1)
+	while (h != end)
 	{
-		//
-		// skip to the high hunk if done with low hunk
-		//
-		if (h == endlow)
-		{
-			Con_Printf("-------------------------\n");
-			Con_Printf("          :%8i REMAINING\n", hunk_size - hunk_low_used - hunk_high_used);
-			Con_Printf("-------------------------\n");
-			h = starthigh;
-		}
-
-		//
-		// if totally done, break
-		//
-		if (h == endhigh)
-			break;
-
 		//
 		// run consistancy checks
 		//
 		if (h->sentinal != HUNK_SENTINAL)
 			Sys_Error("Hunk_Check: trahsed sentinal");
-		if (h->size < 16 || h->size + (byte*)h - hunk_base > hunk_size)
+		if (h->size < 16 || h->size + (byte*)h - arena->base > arena->used)
 			Sys_Error("Hunk_Check: bad size");
 
 		next = (hunk_t*)((byte*)h + h->size);
-		count++;
 		totalblocks++;
 		sum += h->size;
 
@@ -374,21 +581,97 @@ void Hunk_Print(bool all)
 		//
 		// print the total
 		//
-		if (next == endlow || next == endhigh ||
-			strncmp(h->name, next->name, 8))
+		if (next == end || strncmp(h->name, next->name, 8))
 		{
 			if (!all)
 				Con_Printf("          :%8i %8s (TOTAL)\n", sum, name);
-			count = 0;
 			sum = 0;
 		}
 
 		h = next;
 	}
 
+	return totalblocks;
+}
+
+/*
+==============
+Hunk_Print
+
+Lists the low then the high hunk, followed by how much each arena holds and
+the high-water mark of every allocation name
+==============
+*/
+void Hunk_Print(bool all)
+{
+	arena_t* arenas[] = {&arena_zone, &arena_low, &arena_high, &arena_cache};
+	int		totalblocks;
+	char	name[9];
+
+	Con_Printf("low hunk\n");
+	Con_Printf("-------------------------\n");
+	totalblocks = Hunk_PrintArena(&arena_low, all);
+	Con_Printf("-------------------------\n");
+	Con_Printf("high hunk\n");
+	Con_Printf("-------------------------\n");
+	totalblocks += Hunk_PrintArena(&arena_high, all);
 	Con_Printf("-------------------------\n");
 	Con_Printf("%8i total blocks\n", totalblocks);
 
+	Con_Printf("\narena        used      peak committed  reserved\n");
+	for (auto arena : arenas)
+		Con_Printf("%-8s %9i %9i %9i %9i\n", arena->name, arena->used, arena->peak, arena->committed, arena->reserved);
+
+	Con_Printf("\nname        now      peak\n");
+	name[8] = 0;
+	for (int i = 0; i < hunk_numstats; i++)
+	{
+		memcpy(name, hunk_stats[i].name, 8);
+		Con_Printf("%-8s %9i %9i\n", name, hunk_stats[i].current, hunk_stats[i].peak);
+	}
+}
+
+/*
+==============
+Hunk_Print_f
+
+"hunkprint [all]"
+==============
+*/
+static void Hunk_Print_f(void)
+{
+	Hunk_Print(Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "all"));
+}
+
+/*
+===================
+Hunk_AllocBlock
+
+Carves a named block off the top of a hunk arena, growing it if needed
+===================
+*/
+static hunk_t* Hunk_AllocBlock(arena_t* arena, int size, const char* name)
+{
+	hunk_t* h;
+	hunkstat_t* stat;
+
+	if (!Arena_Commit(arena, arena->used + size))
+		return NULL;
+
+	h = (hunk_t*)(arena->base + arena->used);
+	Arena_Use(arena, arena->used + size);
+
+	memset(h, 0, size);
+
+	h->size = size;
+	h->sentinal = HUNK_SENTINAL;
+	Q_strncpy(h->name, name, 8);
+
+	stat = Hunk_Stat(h->name);
+	stat->current += size;
+	stat->peak = std::max(stat->peak, stat->current);
+
+	return h;
 }
 
 /*
@@ -407,22 +690,15 @@ void* Hunk_AllocName(int size, const char* name)
 	if (size < 0)
 		Sys_Error("Hunk_Alloc: bad size: %i", size);
 
+	if (hunk_external)
+		return hunk_external(size);
+
 	size = sizeof(hunk_t) + ((size + 15) & ~15);
 
-	if (hunk_size - hunk_low_used - hunk_high_used < size)
+	h = Hunk_AllocBlock(&arena_low, size, name);
+	if (!h)
 		Sys_Error("Hunk_Alloc: failed on %i bytes", size);
 
-	h = (hunk_t*)(hunk_base + hunk_low_used);
-	hunk_low_used += size;
-
-	Cache_FreeLow(hunk_low_used);
-
-	memset(h, 0, size);
-
-	h->size = size;
-	h->sentinal = HUNK_SENTINAL;
-	Q_strncpy(h->name, name, 8);
-
 	return (void*)(h + 1);
 }
 
@@ -436,17 +712,32 @@ void* Hunk_Alloc(int size)
 	return Hunk_AllocName(size, "unknown");
 }
 
+/*
+===================
+Hunk_SetExternal
+
+Sends Hunk_Alloc and Hunk_AllocName to another allocator until cleared
+with NULL, so a loader that only knows the hunk can build data that
+survives Hunk_FreeToLowMark.  The allocator must return 0 filled memory.
+===================
+*/
+void Hunk_SetExternal(void* (*alloc)(int size))
+{
+	hunk_external = alloc;
+}
+
 int	Hunk_LowMark(void)
 {
-	return hunk_low_used;
+	return arena_low.used;
 }
 
 void Hunk_FreeToLowMark(int mark)
 {
-	if (mark < 0 || mark > hunk_low_used)
+	if (mark < 0 || mark > arena_low.used)
 		Sys_Error("Hunk_FreeToLowMark: bad mark %i", mark);
-	memset(hunk_base + mark, 0, hunk_low_used - mark);
-	hunk_low_used = mark;
+	Hunk_FreeStats(&arena_low, mark, arena_low.used);
+	memset(arena_low.base + mark, 0, arena_low.used - mark);
+	arena_low.used = mark;
 }
 
 int	Hunk_HighMark(void)
@@ -457,7 +748,7 @@ int	Hunk_HighMark(void)
 		Hunk_FreeToHighMark(hunk_tempmark);
 	}
 
-	return hunk_high_used;
+	return arena_high.used;
 }
 
 void Hunk_FreeToHighMark(int mark)
@@ -467,10 +758,11 @@ void Hunk_FreeToHighMark(int mark)
 		hunk_tempactive = false;
 		Hunk_FreeToHighMark(hunk_tempmark);
 	}
-	if (mark < 0 || mark > hunk_high_used)
+	if (mark < 0 || mark > arena_high.used)
 		Sys_Error("Hunk_FreeToHighMark: bad mark %i", mark);
-	memset(hunk_base + hunk_size - hunk_high_used, 0, hunk_high_used - mark);
-	hunk_high_used = mark;
+	Hunk_FreeStats(&arena_high, mark, arena_high.used);
+	memset(arena_high.base + mark, 0, arena_high.used - mark);
+	arena_high.used = mark;
 }
 
 
@@ -498,22 +790,13 @@ void* Hunk_HighAllocName(int size, const char* name)
 
 	size = sizeof(hunk_t) + ((size + 15) & ~15);
 
-	if (hunk_size - hunk_low_used - hunk_high_used < size)
+	h = Hunk_AllocBlock(&arena_high, size, name);
+	if (!h)
 	{
 		Con_Printf("Hunk_HighAlloc: failed on %i bytes\n", size);
 		return NULL;
 	}
 
-	hunk_high_used += size;
-	Cache_FreeHigh(hunk_high_used);
-
-	h = (hunk_t*)(hunk_base + hunk_size - hunk_high_used);
-
-	memset(h, 0, size);
-	h->size = size;
-	h->sentinal = HUNK_SENTINAL;
-	Q_strncpy(h->name, name, 8);
-
 	return (void*)(h + 1);
 }
 
@@ -551,6 +834,9 @@ void* Hunk_TempAlloc(int size)
 
 CACHE MEMORY
 
+The cache arena grows until its reservation is used up, and only then are
+the least recently used objects thrown out to make room.
+
 ===============================================================================
 */
 
@@ -563,90 +849,10 @@ typedef struct cache_system_s
 	struct cache_system_s* lru_prev, * lru_next;	// for LRU flushing	
 } cache_system_t;
 
-cache_system_t* Cache_TryAlloc(int size, bool nobottom);
+cache_system_t* Cache_TryAlloc(int size);
 
 cache_system_t	cache_head;
 
-/*
-===========
-Cache_Move
-===========
-*/
-void Cache_Move(cache_system_t* c)
-{
-	cache_system_t* pNew;
-
-	// we are clearing up space at the bottom, so only allocate it late
-	pNew = Cache_TryAlloc(c->size, true);
-	if (pNew)
-	{
-		//		Con_Printf ("cache_move ok\n");
-
-		Q_memcpy(pNew + 1, c + 1, c->size - sizeof(cache_system_t));
-		pNew->user = c->user;
-		Q_memcpy(pNew->name, c->name, sizeof(pNew->name));
-		Cache_Free(c->user);
-		pNew->user->data = (void*)(pNew + 1);
-	}
-	else
-	{
-		//		Con_Printf ("cache_move failed\n");
-
-		Cache_Free(c->user);		// tough luck...
-	}
-}
-
-/*
-============
-Cache_FreeLow
-
-Throw things out until the hunk can be expanded to the given point
-============
-*/
-void Cache_FreeLow(int new_low_hunk)
-{
-	cache_system_t* c;
-
-	while (1)
-	{
-		c = cache_head.next;
-		if (c == &cache_head)
-			return;		// nothing in cache at all
-		if ((byte*)c >= hunk_base + new_low_hunk)
-			return;		// there is space to grow the hunk
-		Cache_Move(c);	// reclaim the space
-	}
-}
-
-/*
-============
-Cache_FreeHigh
-
-Throw things out until the hunk can be expanded to the given point
-============
-*/
-void Cache_FreeHigh(int new_high_hunk)
-{
-	cache_system_t* c, * prev;
-
-	prev = NULL;
-	while (1)
-	{
-		c = cache_head.prev;
-		if (c == &cache_head)
-			return;		// nothing in cache at all
-		if ((byte*)c + c->size <= hunk_base + hunk_size - new_high_hunk)
-			return;		// there is space to grow the hunk
-		if (c == prev)
-			Cache_Free(c->user);	// didn't move out of the way
-		else
-		{
-			Cache_Move(c);	// try to move it
-			prev = c;
-		}
-	}
-}
-
 void Cache_UnlinkLRU(cache_system_t* cs)
 {
 	if (!cs->lru_next || !cs->lru_prev)
@@ -673,65 +879,44 @@ void Cache_MakeLRU(cache_system_t* cs)
 ============
 Cache_TryAlloc
 
-Looks for a free block of memory between the high and low hunk marks
-Size should already include the header and padding
+Looks for a free block of memory in the cache arena, growing it if there is
+no gap big enough.  Size should already include the header and padding
 ============
 */
-cache_system_t* Cache_TryAlloc(int size, bool nobottom)
+cache_system_t* Cache_TryAlloc(int size)
 {
 	cache_system_t* cs, * pNew;
 
-	// is the cache completely empty?
-
-	if (!nobottom && cache_head.prev == &cache_head)
-	{
-		if (hunk_size - hunk_high_used - hunk_low_used < size)
-			Sys_Error("Cache_TryAlloc: %i is greater then free hunk", size);
-
-		pNew = (cache_system_t*)(hunk_base + hunk_low_used);
-		memset(pNew, 0, sizeof(*pNew));
-		pNew->size = size;
-
-		cache_head.prev = cache_head.next = pNew;
-		pNew->prev = pNew->next = &cache_head;
-
-		Cache_MakeLRU(pNew);
-		return pNew;
-	}
-
 	// search from the bottom up for space
 
-	pNew = (cache_system_t*)(hunk_base + hunk_low_used);
+	pNew = (cache_system_t*)arena_cache.base;
 	cs = cache_head.next;
 
-	do
+	while (cs != &cache_head)
 	{
-		if (!nobottom || cs != cache_head.next)
-		{
-			if ((byte*)cs - (byte*)pNew >= size)
-			{	// found space
-				memset(pNew, 0, sizeof(*pNew));
-				pNew->size = size;
+		if ((byte*)cs - (byte*)pNew >= size)
+		{	// found space
+			memset(pNew, 0, sizeof(*pNew));
+			pNew->size = size;
 
-				pNew->next = cs;
-				pNew->prev = cs->prev;
-				cs->prev->next = pNew;
-				cs->prev = pNew;
+			pNew->next = cs;
+			pNew->prev = cs->prev;
+			cs->prev->next = pNew;
+			cs->prev = pNew;
 
-				Cache_MakeLRU(pNew);
+			Cache_MakeLRU(pNew);
+			Arena_Use(&arena_cache, arena_cache.used + size);
 
-				return pNew;
-			}
+			return pNew;
 		}
 
 		// continue looking		
 		pNew = (cache_system_t*)((byte*)cs + cs->size);
 		cs = cs->next;
-
-	} while (cs != &cache_head);
+	}
 
 	// try to allocate one at the very end
-	if (hunk_base + hunk_size - hunk_high_used - (byte*)pNew >= size)
+	if (Arena_Commit(&arena_cache, (byte*)pNew - arena_cache.base + size))
 	{
 		memset(pNew, 0, sizeof(*pNew));
 		pNew->size = size;
@@ -742,6 +927,7 @@ cache_system_t* Cache_TryAlloc(int size, bool nobottom)
 		cache_head.prev = pNew;
 
 		Cache_MakeLRU(pNew);
+		Arena_Use(&arena_cache, arena_cache.used + size);
 
 		return pNew;
 	}
@@ -787,7 +973,8 @@ Cache_Report
 */
 void Cache_Report(void)
 {
-	Con_DPrintf("%4.1f megabyte data cache\n", (hunk_size - hunk_high_used - hunk_low_used) / (float)(1024 * 1024));
+	Con_DPrintf("%4.1f megabyte data cache, %4.1f in use\n", arena_cache.committed / (float)(1024 * 1024),
+		arena_cache.used / (float)(1024 * 1024));
 }
 
 /*
@@ -837,6 +1024,7 @@ void Cache_Free(cache_user_t* c)
 	c->data = NULL;
 
 	Cache_UnlinkLRU(cs);
+	arena_cache.used -= cs->size;
 }
 
 
@@ -883,7 +1071,7 @@ void* Cache_Alloc(cache_user_t* c, int size, const char* name)
 	// find memory for it	
 	while (1)
 	{
-		cs = Cache_TryAlloc(size, false);
+		cs = Cache_TryAlloc(size);
 		if (cs)
 		{
 			strncpy(cs->name, name, sizeof(cs->name) - 1);
@@ -902,25 +1090,236 @@ void* Cache_Alloc(cache_user_t* c, int size, const char* name)
 	return Cache_Check(c);
 }
 
+/*
+===============================================================================
+
+SCRATCH MEMORY
+
+Every thread bumps through a chain of arenas of its own.  The first is a few
+megabytes, reserved the first time the thread asks, and when one is too full
+for an allocation a chunk twice the size is chained after it.  Chunks are
+kept for the next frame once made, so a thread only ever reserves about
+twice its biggest frame.  The main thread's is emptied at the start of each
+host frame, a job worker's when it finishes its part of a batch.
+
+Marks are offsets into the whole chain, as if the chunks sat end to end.
+
+===============================================================================
+*/
+
+#define	SCRATCH_RESERVE		(4 * 1024 * 1024)	// the first chunk
+#define	MAX_SCRATCH_CHUNKS	8
+
+typedef struct
+{
+	arena_t	chunks[MAX_SCRATCH_CHUNKS];
+	int		start[MAX_SCRATCH_CHUNKS];	// mark at the base of each chunk
+	int		numchunks;
+	int		current;					// chunk being allocated from
+	int		peak;						// most used since the last reset
+} scratch_t;
+
+static thread_local scratch_t	scratch;
+
+static int				scratch_lastframe;		// main thread
+static int				scratch_framepeak;
+static std::atomic<int>	scratch_workerpeak;
+
+/*
+==============
+Scratch_AddChunk
+
+Chains a chunk big enough for size after the last one and moves to it
+==============
+*/
+static void Scratch_AddChunk(int size)
+{
+	arena_t*	last;
+	int			reserve;
+	int			c;
+
+	c = scratch.numchunks;
+	if (c == MAX_SCRATCH_CHUNKS)
+		Sys_Error("Scratch_Alloc: overflow on %i bytes", size);
+
+	reserve = SCRATCH_RESERVE;
+	scratch.start[c] = 0;
+	if (c)
+	{
+		last = &scratch.chunks[c - 1];
+		reserve = (int)std::min((long long)last->reserved * 2, (long long)MAX_RESERVE);
+		scratch.start[c] = scratch.start[c - 1] + last->reserved;
+	}
+	reserve = std::max(reserve, (size + ARENA_GROWTH - 1) & ~(ARENA_GROWTH - 1));
+
+	Arena_Init(&scratch.chunks[c], "scratch", reserve, ARENA_GROWTH);
+	if (scratch.chunks[c].reserved < size)
+		Sys_Error("Scratch_Alloc: overflow on %i bytes", size);
+
+	scratch.numchunks++;
+	scratch.current = c;
+}
+
+/*
+==============
+Scratch_Alloc
+==============
+*/
+void* Scratch_Alloc(int size)
+{
+	arena_t*	chunk;
+	int			offset;
+
+	if (size < 0)
+		Sys_Error("Scratch_Alloc: bad size: %i", size);
+
+	size = (size + 15) & ~15;
+
+	// find a chunk with room, making one if the chain runs out
+	while (1)
+	{
+		if (scratch.current < scratch.numchunks)
+		{
+			chunk = &scratch.chunks[scratch.current];
+			if (chunk->used + size <= chunk->reserved)
+				break;
+		}
+
+		if (scratch.current + 1 < scratch.numchunks)
+		{
+			scratch.current++;
+			scratch.chunks[scratch.current].used = 0;
+		}
+		else
+			Scratch_AddChunk(size);
+	}
+
+	offset = chunk->used;
+	if (!Arena_Commit(chunk, offset + size))
+		Sys_Error("Scratch_Alloc: overflow on %i bytes", size);
+
+	Arena_Use(chunk, offset + size);
+	scratch.peak = std::max(scratch.peak, scratch.start[scratch.current] + chunk->used);
+
+	return chunk->base + offset;
+}
+
+int Scratch_Mark(void)
+{
+	if (!scratch.numchunks)
+		return 0;
+	return scratch.start[scratch.current] + scratch.chunks[scratch.current].used;
+}
+
+void Scratch_FreeToMark(int mark)
+{
+	int		c;
+
+	if (mark < 0 || mark > Scratch_Mark())
+		Sys_Error("Scratch_FreeToMark: bad mark %i", mark);
+
+	if (!scratch.numchunks)
+		return;
+
+	for (c = scratch.current; c > 0 && scratch.start[c] > mark; c--)
+		;
+	scratch.current = c;
+	scratch.chunks[c].used = mark - scratch.start[c];
+}
+
+/*
+==============
+Scratch_Reset
+==============
+*/
+static void Scratch_Reset(void)
+{
+	scratch.current = 0;
+	if (scratch.numchunks)
+		scratch.chunks[0].used = 0;
+	scratch.peak = 0;
+}
+
+/*
+==============
+Scratch_EndFrame
+
+Called by the main thread at the start of each host frame
+==============
+*/
+void Scratch_EndFrame(void)
+{
+	scratch_lastframe = scratch.peak;
+	scratch_framepeak = std::max(scratch_framepeak, scratch.peak);
+
+	Scratch_Reset();
+}
+
+/*
+==============
+Scratch_EndJob
+
+Called by a job worker once it has run out of work in a batch
+==============
+*/
+void Scratch_EndJob(void)
+{
+	int		peak;
+
+	peak = scratch_workerpeak.load(std::memory_order_relaxed);
+	while (scratch.peak > peak && !scratch_workerpeak.compare_exchange_weak(peak, scratch.peak, std::memory_order_relaxed))
+		;
+
+	Scratch_Reset();
+}
+
+/*
+==============
+Scratch_Stats_f
+
+"scratchstats reset" starts the peaks over
+==============
+*/
+static void Scratch_Stats_f(void)
+{
+	int		committed;
+	int		reserved;
+	int		c;
+
+	if (Cmd_Argc() > 1 && !Q_strcasecmp(Cmd_Argv(1), "reset"))
+	{
+		scratch_framepeak = 0;
+		scratch_workerpeak = 0;
+		return;
+	}
+
+	committed = reserved = 0;
+	for (c = 0; c < scratch.numchunks; c++)
+	{
+		committed += scratch.chunks[c].committed;
+		reserved += scratch.chunks[c].reserved;
+	}
+
+	Con_Printf("last frame %i bytes, peak frame %i bytes\n", scratch_lastframe, scratch_framepeak);
+	Con_Printf("peak job %i bytes\n", scratch_workerpeak.load());
+	Con_Printf("%i bytes committed to the main thread in %i chunks, %i reserved\n", committed, scratch.numchunks, reserved);
+}
+
 //============================================================================
 
 
 /*
 ========================
 Memory_Init
+
+size is where the low hunk starts, it grows from there
 ========================
 */
-void Memory_Init(void* buf, int size)
+void Memory_Init(int size)
 {
 	int p;
 	int zonesize = DYNAMIC_SIZE;
 
-	hunk_base = reinterpret_cast<byte*>(buf);
-	hunk_size = size;
-	hunk_low_used = 0;
-	hunk_high_used = 0;
-
-	Cache_Init();
 	p = COM_CheckParm("-zone");
 	if (p)
 	{
@@ -929,7 +1328,18 @@ void Memory_Init(void* buf, int size)
 		else
 			Sys_Error("Memory_Init: you must specify a size in KB after -zone");
 	}
-	mainzone = reinterpret_cast<memzone_t*>(Hunk_AllocName(zonesize, "zone"));
+
+	Arena_Init(&arena_zone, "zone", Arena_ReserveSize(zonesize, ZONE_RESERVE_SCALE, ZONE_RESERVE), zonesize);
+	Arena_Init(&arena_low, "low", Arena_ReserveSize(size, LOW_RESERVE_SCALE, LOW_RESERVE), size);
+	Arena_Init(&arena_high, "high", Arena_ReserveSize(size, HIGH_RESERVE_SCALE, HIGH_RESERVE), ARENA_GROWTH);
+	Arena_Init(&arena_cache, "cache", Arena_ReserveSize(size, CACHE_RESERVE_SCALE, CACHE_RESERVE), 0);
+
+	Cache_Init();
+
+	mainzone = reinterpret_cast<memzone_t*>(arena_zone.base);
 	Z_ClearZone(mainzone, zonesize);
-}
+	Arena_Use(&arena_zone, zonesize);
 
+	Cmd_AddCommand("hunkprint", Hunk_Print_f);
+	Cmd_AddCommand("scratchstats", Scratch_Stats_f);
+}
@@ -20,70 +20,44 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 /*
  memory allocation
 
+Every kind of memory below lives in its own arena, a range of address space
+reserved at startup and backed with memory as it fills.  Arenas never move,
+so pointers stay good as they grow, and running out only happens when the
+reservation itself is used up.  -heapsize and -zone only set how much is
+committed to start with.
 
-H_??? The hunk manages the entire memory block given to quake.  It must be
-contiguous.  Memory can be allocated from either the low or high end in a
-stack fashion.  The only way memory is released is by resetting one of the
-pointers.
+
+H_??? The hunk is two stacks, the low hunk for level data and the high hunk
+for video buffers and temp data.  Memory is released by resetting one of
+them to a mark.  Allocations inside one mark are contiguous.
 
 Hunk allocations should be given a name, so the Hunk_Print () function
-can display usage.
+can display usage, including the most ever held under each name.
 
 Hunk allocations are guaranteed to be 16 byte aligned.
 
-The video buffers are allocated high to avoid leaving a hole underneath
-server allocations when changing to a higher video mode.
-
 
 Z_??? Zone memory functions used for small, dynamic allocations like text
-strings from command input.  There is only about 48K for it, allocated at
-the very bottom of the hunk.
+strings from command input.  It starts at 48K and grows when full.
 
 Cache_??? Cache memory is for objects that can be dynamically loaded and
-can usefully stay persistant between levels.  The size of the cache
-fluctuates from level to level.
+can usefully stay persistant between levels.  The cache grows until its
+reservation is full and then throws out the least recently used objects.
 
 To allocate a cachable object
 
 
-Temp_??? Temp memory is used for file loading and surface caching.  The size
-of the cache memory is adjusted so that there is a minimum of 512k remaining
-for temp memory.
-
-
------- Top of Memory -------
-
-high hunk allocations
-
-<--- high hunk reset point held by vid
-
-video buffer
-
-z buffer
-
-surface cache
-
-<--- high hunk used
-
-cachable memory
-
-<--- low hunk used
-
-client and server low hunk allocations
-
-<-- low hunk reset point held by host
-
-startup hunk allocations
-
-Zone block
-
------ Bottom of Memory -----
-
+Temp_??? Temp memory is used for file loading and surface caching.  It is
+the top block of the high hunk and is freed by the next temp allocation.
 
+Scratch_??? Scratch memory is for small transient data.  Each thread has its
+own, allocations coexist until the frame (or job batch) ends, and nothing
+ever has to be freed one at a time.
 
 */
 
-void Memory_Init(void* buf, int size);
+void Memory_Init(int size);
+// size is where the low hunk starts out
 
 void Z_Free(void* ptr);
 void* Z_Malloc(int size);			// returns 0 filled memory
@@ -96,6 +70,9 @@ int Z_FreeMemory(void);
 void* Hunk_Alloc(int size);		// returns 0 filled memory
 void* Hunk_AllocName(int size, const char* name);
 
+void Hunk_SetExternal(void* (*alloc)(int size));
+// redirects the two calls above, NULL restores the hunk
+
 void* Hunk_HighAllocName(int size, const char* name);
 
 int	Hunk_LowMark(void);
@@ -107,6 +84,7 @@ void Hunk_FreeToHighMark(int mark);
 void* Hunk_TempAlloc(int size);
 
 void Hunk_Check(void);
+void Hunk_Print(bool all);
 
 typedef struct cache_user_s
 {
@@ -128,4 +106,15 @@ void* Cache_Alloc(cache_user_t* c, int size, const char* name);
 void Cache_Report(void);
 
 
+void* Scratch_Alloc(int size);
+// 16 byte aligned, not cleared.  Lives until the end of the host frame, or
+// until the end of the batch when called from a job, unless freed to a mark
+
+int Scratch_Mark(void);
+void Scratch_FreeToMark(int mark);
+
+void Scratch_EndFrame(void);
+void Scratch_EndJob(void);
+
+
 